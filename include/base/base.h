@@ -2,6 +2,7 @@
 
 #include "buffer.h"
 #include "graphics_pipeline.h"
+#include "compute_pipeline.h"
 #include "image.h"
 #include "sampler.h"
 #include "context_structs.h"
@@ -9,3 +10,5 @@
 #include "descriptor_set_layout.h"
 #include "descriptor_pool.h"
 #include "render_pass.h"
+#include "memory_allocator.h"
+#include "pipeline_cache.h"
@@ -2,12 +2,23 @@
 
 #include <vulkan/vulkan.h>
 #include "context_structs.h"
+#include "memory_allocator.h"
 
 namespace rt {
+    class DestructionQueue;
+
     struct BufferCreateInfo {
         VkDeviceSize size;
         VkBufferUsageFlags usage;
         VkMemoryPropertyFlags properties;
+        // optional, sub-allocates from this instead of
+        //   calling vkAllocateMemory for every buffer
+        MemoryAllocator* allocator;
+        // optional, hands handles off to be destroyed once the GPU is
+        //   done with them instead of waiting for the device to go idle.
+        //   borrowed, it has to outlive this and be flushed before the
+        //   device (and allocator, if any) are destroyed
+        DestructionQueue* retire_queue;
     };
 
     class Buffer {
@@ -15,11 +26,15 @@ namespace rt {
         VkDevice device;
         VkBuffer buffer;
         void* mapped;
-        VkDeviceMemory device_memory;
+        MemoryAllocator* allocator;
+        MemoryAllocation allocation;
+        DestructionQueue* retire_queue;
         VkDeviceSize size;
         VkBufferUsageFlags buffer_usage;
         VkMemoryPropertyFlags memory_properties;
 
+        void CheckCopyFrom(const Buffer& src) const;
+
        public:
         Buffer(const BufferCreateInfo& create_info, const ApiContext& a_ctx);
         ~Buffer();
@@ -28,6 +43,8 @@ namespace rt {
         void CopyFromHostAuto(const void* data, size_t size);
         void CopyFromHost(const void* data, size_t size, uint64_t offset = 0);
         void CopyFromBuffer(const Buffer& src, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
+        // records the copy without submitting, src must outlive the command buffer
+        void CmdCopyFromBuffer(const Buffer& src, VkCommandBuffer command_buffer);
         void Map();
         void Map(uint64_t offset, size_t size);
         void Unmap();
@@ -35,5 +52,7 @@ namespace rt {
         VkBuffer get_buffer() const;
         VkDeviceSize get_size() const;
         bool get_mapped() const;
+        // null unless mapped, points at the start of the mapped range
+        void* get_mapped_data() const;
     };
 }
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include "context_structs.h"
+
+namespace rt {
+    class DestructionQueue;
+
+    struct ComputePipelineCreateInfo {
+        const VkPipelineShaderStageCreateInfo* shader_stage;
+        const VkPipelineLayoutCreateInfo* layout_create_info;
+        // the shader's local_size_x/y/z, none of them can be zero
+        uint32_t local_size[3];
+        // optional, used instead of creating a layout from layout_create_info,
+        //   it's borrowed and not destroyed along with the pipeline
+        VkPipelineLayout pipeline_layout;
+        // optional, speeds up creation a lot when the cache is warm
+        VkPipelineCache pipeline_cache;
+        // optional, hands handles off to be destroyed once the GPU is
+        //   done with them instead of waiting for the device to go idle
+        DestructionQueue* retire_queue;
+    };
+
+    class ComputePipeline {
+       private:
+        VkDevice device;
+        VkPipelineLayout pipeline_layout;
+        VkPipeline compute_pipeline;
+        bool owns_layout;
+        std::array<uint32_t, 3> local_size;
+        DestructionQueue* retire_queue;
+
+       public:
+        ComputePipeline(const ComputePipelineCreateInfo& create_info, const ApiContext& a_ctx);
+        ~ComputePipeline();
+
+        // binds the pipeline and descriptor sets starting at set 0 then
+        //   dispatches, doesn't record any barriers of its own
+        void CmdDispatch(
+            VkCommandBuffer command_buffer,
+            const VkDescriptorSet* descriptor_sets,
+            uint32_t descriptor_set_count,
+            uint32_t group_count_x,
+            uint32_t group_count_y = 1,
+            uint32_t group_count_z = 1
+        ) const;
+        // group counts are read from buffer at offset as a VkDispatchIndirectCommand
+        void CmdDispatchIndirect(
+            VkCommandBuffer command_buffer,
+            const VkDescriptorSet* descriptor_sets,
+            uint32_t descriptor_set_count,
+            VkBuffer buffer,
+            VkDeviceSize offset
+        ) const;
+
+        VkPipelineLayout get_layout() const;
+        VkPipeline get_pipeline() const;
+
+        // number of work groups needed to cover count items along axis
+        //   (0 to 2 for x to z) of the local size
+        uint32_t get_group_count(uint32_t count, uint32_t axis = 0) const;
+    };
+}
@@ -20,6 +20,10 @@ namespace rt {
         DescriptorPool(const DescriptorPoolCreateInfo& create_info, const ApiContext& a_ctx);
         ~DescriptorPool();
 
+        // frees every set allocated from the pool at once, none of
+        //   them may still be in use by the GPU
+        void Reset();
+
         VkDescriptorPool get_pool();
     };
 }
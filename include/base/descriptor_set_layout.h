@@ -8,6 +8,8 @@ namespace rt {
         VkDescriptorSetLayoutCreateFlags flags;
         const VkDescriptorSetLayoutBinding* bindings;
         uint32_t binding_count;
+        // optional, chained onto the create info (binding flags etc)
+        const void* next;
     };
 
     class DescriptorSetLayout {
@@ -4,6 +4,8 @@
 #include "context_structs.h"
 
 namespace rt {
+    class DestructionQueue;
+
     struct GraphicsPipelineCreateInfo {
         VkPipelineShaderStageCreateInfo* shader_stages;
         uint32_t shader_stage_count;
@@ -16,8 +18,16 @@ namespace rt {
         const VkPipelineColorBlendStateCreateInfo* color_blend;
         const VkPipelineDynamicStateCreateInfo* dynamic_state;
         const VkPipelineLayoutCreateInfo* layout_create_info;
+        // optional, used instead of creating a layout from layout_create_info,
+        //   it's borrowed and not destroyed along with the pipeline
+        VkPipelineLayout pipeline_layout;
         VkRenderPass render_pass;
         uint32_t subpass_index;
+        // optional, speeds up creation a lot when the cache is warm
+        VkPipelineCache pipeline_cache;
+        // optional, hands handles off to be destroyed once the GPU is
+        //   done with them instead of waiting for the device to go idle
+        DestructionQueue* retire_queue;
     };
 
     class GraphicsPipeline {
@@ -25,6 +35,8 @@ namespace rt {
         VkDevice device;
         VkPipelineLayout pipeline_layout;
         VkPipeline graphics_pipeline;
+        bool owns_layout;
+        DestructionQueue* retire_queue;
 
        public:
         GraphicsPipeline(const GraphicsPipelineCreateInfo& create_info, const ApiContext& a_ctx);
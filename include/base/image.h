@@ -2,8 +2,13 @@
 
 #include <vulkan/vulkan.h>
 #include "context_structs.h"
+#include "memory_allocator.h"
 
 namespace rt {
+    class UploadContext;
+    class StagingRing;
+    class DestructionQueue;
+
     struct ImageCreateInfo {
         uint32_t width;
         uint32_t height;
@@ -12,6 +17,25 @@ namespace rt {
         VkImageUsageFlags image_usage;
         VkMemoryPropertyFlags memory_properties;
         VkImageAspectFlags view_aspect_flags;
+        // optional, 0 or 1 for a single level. CopyData fills the rest by
+        //   blitting down from level 0, which needs a format that supports
+        //   linear filtering. CopyLevels takes them precomputed instead
+        //   (the only option for compressed formats, see Utils::get_full_mip_count)
+        uint32_t mip_levels;
+        // optional, sub-allocates from this instead of
+        //   calling vkAllocateMemory for every image
+        MemoryAllocator* allocator;
+        // optional, hands handles off to be destroyed once the GPU is
+        //   done with them instead of waiting for the device to go idle.
+        //   borrowed, it has to outlive this and be flushed before the
+        //   device (and allocator, if any) are destroyed
+        DestructionQueue* retire_queue;
+    };
+
+    // tightly packed texels (or 4x4 blocks) of a single mip level
+    struct ImageLevelData {
+        const void* data;
+        VkDeviceSize size;
     };
 
     class Image {
@@ -19,13 +43,19 @@ namespace rt {
         VkDevice device;
         VkImage image;
         VkImageView view;
-        VkDeviceMemory memory;
+        MemoryAllocator* allocator;
+        MemoryAllocation allocation;
+        DestructionQueue* retire_queue;
+        // device memory held, with alignment and allocator rounding
         VkDeviceSize size;
         VkFormat image_format;
         VkImageLayout image_layout;
         uint32_t width;
         uint32_t height;
+        uint32_t mip_levels;
+        bool can_generate_mips;
 
+        static VkImageCreateInfo GetVkCreateInfo(const ImageCreateInfo& create_info, uint32_t mip_levels);
         void CreateImage(const ImageCreateInfo& create_info, const ApiContext& a_ctx);
         void CreateImageView(const ImageCreateInfo& create_info, const ApiContext& a_ctx);
 
@@ -34,12 +64,42 @@ namespace rt {
         ~Image();
 
         void CopyData(const void* data, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
+        // records the upload into the context's current batch instead of waiting on it
+        void CopyData(const void* data, UploadContext& upload, const ApiContext& a_ctx);
+        // goes through the persistent staging ring, no staging allocation at all
+        void CopyData(const void* data, StagingRing& staging);
+        // uploads every level at once with one copy region per level,
+        //   level_count must match the image's mip levels
+        void CopyLevels(const ImageLevelData* levels, uint32_t level_count, UploadContext& upload, const ApiContext& a_ctx);
+        void CopyLevels(const ImageLevelData* levels, uint32_t level_count, StagingRing& staging);
         void TransitionToLayout(VkImageLayout layout, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
+        void CmdTransitionToLayout(VkImageLayout layout, VkCommandBuffer command_buffer);
+        // moves a freshly copied image to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        //   and hands it to the upload's receiving queue, generating the
+        //   rest of the mip chain from level 0 on the way if asked to
+        void CmdFinishUpload(UploadContext& upload, bool generate_mips = true);
+        // every level must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL with level 0
+        //   written, needs a graphics queue. leaves them shader read only
+        void CmdGenerateMipmaps(VkCommandBuffer command_buffer);
 
         VkImage get_image() const;
         VkImageView get_view() const;
         uint32_t get_width() const;
         uint32_t get_height() const;
         VkFormat get_format() const;
+        uint32_t get_mip_levels() const;
+        // whether the format can blit levels down from level 0
+        bool get_can_generate_mips() const;
+        // bytes of level 0, which is all CopyData reads
+        VkDeviceSize get_data_size() const;
+        VkDeviceSize get_level_size(uint32_t level) const;
+        VkExtent2D get_level_extent(uint32_t level) const;
+        // bytes of device memory the image holds, counting alignment
+        //   and the allocator's rounding
+        VkDeviceSize get_memory_size() const;
+
+        // what get_memory_size would return for an image made from
+        //   create_info, without allocating anything
+        static VkDeviceSize QueryMemorySize(const ImageCreateInfo& create_info, const ApiContext& a_ctx);
     };
 }
@@ -9,6 +9,8 @@ namespace rt {
         uint32_t api_version;
         const char* const* validation_layers;
         uint32_t validation_layer_count;
+        // skips GLFW's surface extensions so no window system is needed
+        bool headless;
     };
 
     class Instance {
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <set>
+#include <memory>
+#include <mutex>
+#include "context_structs.h"
+
+namespace rt {
+    struct MemoryAllocatorCreateInfo {
+        // size of each VkDeviceMemory block, must be a power of two
+        //   (defaults to 64 MiB if zero)
+        VkDeviceSize block_size;
+        // smallest sub-allocation handed out, must be a power of two
+        //   (defaults to 256 bytes if zero)
+        VkDeviceSize min_allocation_size;
+    };
+
+    struct MemoryAllocation {
+        VkDeviceMemory memory;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        // only non-null for host visible memory, blocks are mapped once
+        //   on creation since the same VkDeviceMemory can't be mapped twice
+        void* mapped;
+        uint32_t memory_type;
+        uint32_t block_id;
+        uint32_t order;
+    };
+
+    struct MemoryHeapStats {
+        uint32_t block_count;
+        uint32_t allocation_count;
+        uint32_t dedicated_allocation_count;
+        // bytes actually allocated from the driver
+        VkDeviceSize allocated_bytes;
+        // bytes handed out to resources (including buddy rounding)
+        VkDeviceSize used_bytes;
+    };
+
+    class MemoryAllocator {
+       private:
+        struct Block {
+            VkDeviceMemory memory;
+            void* mapped;
+            uint32_t memory_type;
+            uint32_t allocation_count;
+            // one set of free offsets per buddy order
+            std::vector<std::set<VkDeviceSize>> free_lists;
+        };
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memory_properties;
+        VkDeviceSize buffer_image_granularity;
+        VkDeviceSize block_size;
+        VkDeviceSize min_allocation_size;
+        uint32_t max_order;
+
+        std::vector<std::unique_ptr<Block>> blocks;
+        std::vector<MemoryHeapStats> heap_stats;
+        std::mutex mutex;
+
+        uint32_t CreateBlock(uint32_t memory_type);
+        void DestroyBlock(uint32_t block_id);
+        bool AllocateFromBlock(Block& block, uint32_t order, VkDeviceSize* out_offset);
+        // power of two buddy chunk that fits requirements
+        VkDeviceSize GetChunkSize(const VkMemoryRequirements& requirements, bool optimal_image) const;
+        MemoryAllocation AllocateDedicated(VkDeviceSize size, uint32_t memory_type);
+        MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool optimal_image);
+
+       public:
+        static constexpr uint32_t DEDICATED_BLOCK = UINT32_MAX;
+
+        MemoryAllocator(const MemoryAllocatorCreateInfo& create_info, const ApiContext& a_ctx);
+        ~MemoryAllocator();
+
+        MemoryAllocation AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+        MemoryAllocation AllocateForImage(VkImage image, VkMemoryPropertyFlags properties);
+        void Free(const MemoryAllocation& allocation);
+
+        // stats are indexed by VkMemoryHeap index
+        std::vector<MemoryHeapStats> get_heap_stats();
+        // bytes an allocation for requirements takes up, including buddy
+        //   rounding (what the heap's used_bytes grows by)
+        VkDeviceSize get_allocation_size(const VkMemoryRequirements& requirements, bool optimal_image) const;
+        VkDeviceSize get_block_size() const;
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include "context_structs.h"
+
+namespace rt {
+    struct PipelineCacheCreateInfo {
+        // optional, file the cache is loaded from and saved back
+        //   to, the cache only lives in memory if this is null
+        const char* path;
+    };
+
+    class PipelineCache {
+       private:
+        // written in front of the driver's cache data so we can throw
+        //   out files from other devices, drivers, or partial writes
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t vendor_id;
+            uint32_t device_id;
+            uint32_t driver_version;
+            uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+            uint64_t data_size;
+            uint64_t data_hash;
+        };
+
+        VkDevice device;
+        VkPipelineCache cache;
+        VkPhysicalDeviceProperties properties;
+        std::string path;
+        bool loaded_from_disk;
+
+        bool ValidateData(const FileHeader& header, const std::string& data) const;
+
+       public:
+        PipelineCache(const PipelineCacheCreateInfo& create_info, const ApiContext& a_ctx);
+        ~PipelineCache();
+
+        // called automatically on destruction if there's a path
+        void Save();
+
+        VkPipelineCache get_cache() const;
+        // false if the cache started cold (no file or it was invalid)
+        bool get_loaded_from_disk() const;
+    };
+}
@@ -10,6 +10,10 @@ namespace rt {
         VkSamplerAddressMode address_u;
         VkSamplerAddressMode address_v;
         VkSamplerAddressMode address_w;
+        // optional, range of mip levels sampled from. both 0 only ever
+        //   samples level 0, VK_LOD_CLAMP_NONE as max_lod allows the whole chain
+        float min_lod;
+        float max_lod;
     };
 
     class Sampler {
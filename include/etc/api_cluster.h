@@ -3,13 +3,19 @@
 #include <vulkan/vulkan.h>
 #include <memory>
 #include "../base/instance.h"
+#include "../base/pipeline_cache.h"
 #include "../base/context_structs.h"
+#include "../vk_utils.h"
 #include <GLFW/glfw3.h>
 
 namespace rt {
     struct ApiClusterCreateInfo {
         const InstanceCreateInfo& instance;
+        // null runs headless, without a surface or swap chain
         GLFWwindow* window;
+        // optional, pipeline cache is persisted to this file
+        //   so later launches don't recompile every pipeline
+        const char* pipeline_cache_path;
     };
 
     class ApiCluster {
@@ -19,6 +25,15 @@ namespace rt {
         VkDevice device;
         VkSurfaceKHR surface;
         GLFWwindow* window;
+        bool headless;
+        QueueFamilyIndices queue_families;
+        // core features that were enabled, optional ones are
+        //   only turned on when the device supports them
+        VkPhysicalDeviceFeatures features;
+        // optional Vulkan 1.2 features that were both supported
+        //   and enabled on the device (all false below 1.2)
+        VkPhysicalDeviceVulkan12Features features_12;
+        std::unique_ptr<PipelineCache> pipeline_cache;
 
        public:
         ApiCluster(const ApiClusterCreateInfo& create_info);
@@ -29,7 +44,17 @@ namespace rt {
         VkDevice get_device() const;
         VkSurfaceKHR get_surface() const;
         GLFWwindow* get_window() const;
+        bool is_headless() const;
         ApiContext get_api_context() const;
         void get_queues(VkQueue* out_graphics_queue, VkQueue* out_present_queue) const;
+        const QueueFamilyIndices& get_queue_families() const;
+        // null when the device has no dedicated family for these
+        VkQueue get_transfer_queue() const;
+        VkQueue get_compute_queue() const;
+        const VkPhysicalDeviceFeatures& get_features() const;
+        const VkPhysicalDeviceVulkan12Features& get_vulkan_12_features() const;
+        VkPipelineCache get_pipeline_cache() const;
+        // saves the pipeline cache now rather than waiting for destruction
+        void SavePipelineCache();
     };
 }
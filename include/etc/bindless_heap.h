@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+#include "../base/base.h"
+#include "destruction_queue.h"
+
+namespace rt {
+    // slot in one of the heap's arrays, what shaders index with
+    using BindlessIndex = uint32_t;
+
+    constexpr BindlessIndex BINDLESS_INVALID_INDEX = UINT32_MAX;
+
+    // bindings of the heap's set, shaders declare them as
+    //   layout(set = N, binding = 0) uniform texture2D images[];
+    //   layout(set = N, binding = 1) uniform sampler samplers[];
+    //   layout(set = N, binding = 2) buffer Buffers { ... } buffers[];
+    constexpr uint32_t BINDLESS_IMAGE_BINDING = 0;
+    constexpr uint32_t BINDLESS_SAMPLER_BINDING = 1;
+    constexpr uint32_t BINDLESS_BUFFER_BINDING = 2;
+
+    struct BindlessHeapCreateInfo {
+        // capacities are clamped to the device's update after bind limits
+        uint32_t max_images;
+        uint32_t max_samplers;
+        uint32_t max_buffers;
+        // from ApiCluster::get_vulkan_12_features(), which only has them
+        //   on vulkan 1.2 devices. construction throws unless is_supported
+        const VkPhysicalDeviceVulkan12Features* features;
+        // optional, keyed by frame number. released slots only become
+        //   reusable once in flight frames are done with them (immediately
+        //   when null)
+        DestructionQueue* retire_queue;
+    };
+
+    // one update after bind descriptor set holding every sampled image,
+    //   sampler and storage buffer. resources are registered once and
+    //   draws pick them by index through push constants, so the set is
+    //   bound once per command buffer instead of once per draw
+    class BindlessHeap {
+       private:
+        // shared with deferred releases so they can tell if the heap
+        //   was destroyed before the frame retired
+        struct FreeLists {
+            std::vector<BindlessIndex> images;
+            std::vector<BindlessIndex> samplers;
+            std::vector<BindlessIndex> buffers;
+        };
+
+        VkDevice device;
+        DestructionQueue* retire_queue;
+
+        std::unique_ptr<DescriptorSetLayout> layout;
+        std::unique_ptr<DescriptorPool> pool;
+        VkDescriptorSet set;
+
+        uint32_t max_images;
+        uint32_t max_samplers;
+        uint32_t max_buffers;
+
+        // slots below these have been handed out at least once
+        uint32_t image_count;
+        uint32_t sampler_count;
+        uint32_t buffer_count;
+        std::shared_ptr<FreeLists> free_lists;
+
+        static BindlessIndex Allocate(std::vector<BindlessIndex>& free_list, uint32_t* count, uint32_t max, const char* error);
+        void Release(std::vector<BindlessIndex> FreeLists::* list, BindlessIndex index);
+        void Write(uint32_t binding, BindlessIndex index, VkDescriptorType type, const VkDescriptorImageInfo* image_info, const VkDescriptorBufferInfo* buffer_info);
+
+       public:
+        BindlessHeap(const BindlessHeapCreateInfo& create_info, const ApiContext& a_ctx);
+        ~BindlessHeap();
+
+        BindlessHeap(const BindlessHeap&) = delete;
+        BindlessHeap& operator=(const BindlessHeap&) = delete;
+
+        // whether the features the heap needs were enabled, see
+        //   ApiCluster::get_vulkan_12_features
+        static bool is_supported(const VkPhysicalDeviceVulkan12Features& features);
+
+        // throw once every slot of that kind is taken
+        BindlessIndex RegisterImage(VkImageView view, VkImageLayout image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        BindlessIndex RegisterSampler(VkSampler sampler);
+        BindlessIndex RegisterBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+        // rewrites a slot in place. only for slots no submitted frame still
+        //   reads, otherwise register the new resource and release the old
+        //   slot (e.g. for TextureStreamer::get_changed)
+        void UpdateImage(BindlessIndex index, VkImageView view, VkImageLayout image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        void UpdateSampler(BindlessIndex index, VkSampler sampler);
+        void UpdateBuffer(BindlessIndex index, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+        // the slot is reused once the current frame retires, the
+        //   resource itself has to outlive that too
+        void ReleaseImage(BindlessIndex index);
+        void ReleaseSampler(BindlessIndex index);
+        void ReleaseBuffer(BindlessIndex index);
+
+        // pipeline_layout has to use get_layout() at set_index, e.g. by
+        //   replacing that entry of ShaderLayout::set_layouts
+        void CmdBind(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout, VkPipelineBindPoint bind_point, uint32_t set_index) const;
+
+        VkDescriptorSetLayout get_layout() const;
+        VkDescriptorSet get_set() const;
+        uint32_t get_max_images() const;
+        uint32_t get_max_samplers() const;
+        uint32_t get_max_buffers() const;
+    };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../base/base.h"
+
+namespace rt {
+    // descriptors of a type reserved per set when sizing a pool
+    struct DescriptorTypeRatio {
+        VkDescriptorType type;
+        float ratio;
+    };
+
+    // one descriptor written into a set, image is used for image and
+    //   sampler types and buffer for buffer types
+    struct DescriptorWrite {
+        uint32_t binding;
+        VkDescriptorType type;
+        VkDescriptorImageInfo image;
+        VkDescriptorBufferInfo buffer;
+    };
+
+    struct DescriptorAllocatorCreateInfo {
+        // optional, how pools are split between descriptor types. null
+        //   falls back to a mix of uniform, storage and image descriptors
+        const DescriptorTypeRatio* ratios;
+        uint32_t ratio_count;
+        // optional, sets in the first pool, 0 falls back to 64. every
+        //   new pool doubles this up to max_sets_per_pool
+        uint32_t initial_sets;
+        // optional, 0 falls back to 4096
+        uint32_t max_sets_per_pool;
+    };
+
+    // hands out descriptor sets that live for one frame. sets come from
+    //   a chain of pools that grows when a pool runs out, and once a
+    //   frame retires all of its pools are reset in one call and reused
+    class DescriptorAllocator {
+       private:
+        struct FramePools {
+            uint64_t frame_number;
+            // the last one is allocated from, earlier ones are full
+            std::vector<std::unique_ptr<DescriptorPool>> pools;
+            // keyed by layout and writes, see Get
+            std::unordered_map<std::string, VkDescriptorSet> cache;
+        };
+
+        ApiContext a_ctx;
+        std::vector<DescriptorTypeRatio> ratios;
+        uint32_t next_sets;
+        uint32_t max_sets_per_pool;
+
+        // oldest first, the back is the frame being recorded
+        std::deque<FramePools> frames;
+        // reset pools waiting to be reused
+        std::vector<std::unique_ptr<DescriptorPool>> ready_pools;
+        size_t pool_count;
+
+        std::unique_ptr<DescriptorPool> NextPool();
+        bool TryAllocate(VkDescriptorSetLayout layout, VkDescriptorSet* out_set);
+
+       public:
+        DescriptorAllocator(const DescriptorAllocatorCreateInfo& create_info, const ApiContext& a_ctx);
+        ~DescriptorAllocator();
+
+        DescriptorAllocator(const DescriptorAllocator&) = delete;
+        DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+        // once per frame before allocating, pools of frames at or before
+        //   completed_frame_number are reset and go back to be reused
+        void BeginFrame(uint64_t frame_number, uint64_t completed_frame_number);
+
+        // an empty set, valid until the current frame retires. throws
+        //   if BeginFrame hasn't been called yet
+        VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+        // a set holding writes, identical requests during the same frame
+        //   return the same set instead of allocating and writing again
+        VkDescriptorSet Get(VkDescriptorSetLayout layout, const DescriptorWrite* writes, uint32_t write_count);
+
+        // pools owned across all frames, in use or not
+        size_t get_pool_count() const;
+    };
+}
@@ -1,18 +1,47 @@
 #pragma once
 
+#include <vulkan/vulkan.h>
 #include <deque>
 #include <functional>
+#include <mutex>
 
 namespace rt {
     class DestructionQueue {
        private:
+        struct RetiredEntry {
+            std::function<void()> func;
+            uint64_t retire_value;
+            VkDeviceSize bytes;
+        };
+
         std::deque<std::function<void()>> queue;
 
+        // retirement entries are keyed by a monotonically increasing
+        //   value (frame number, upload token, etc) and are released
+        //   once the owner reports that value as completed on the GPU
+        std::deque<RetiredEntry> retired;
+        uint64_t current_value;
+        VkDeviceSize pending_bytes;
+        std::mutex retire_mutex;
+
        public:
         DestructionQueue();
         ~DestructionQueue();
 
         void QueueDelete(std::function<void()> func);
+        // runs every retired entry FIFO then the delete queue LIFO,
+        //   the GPU must be idle before calling this
         void Flush();
+
+        // queues func to run once the current value has completed,
+        //   bytes is only tracked for get_pending_bytes()
+        void QueueRetire(std::function<void()> func, VkDeviceSize bytes = 0);
+        // runs every retired entry queued at or before completed_value
+        void Retire(uint64_t completed_value);
+
+        void set_current_value(uint64_t value);
+        uint64_t get_current_value();
+        VkDeviceSize get_pending_bytes();
+        size_t get_pending_count();
     };
 }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+#include "../base/base.h"
+#include "destruction_queue.h"
+#include "mesh.h"
+
+namespace rt {
+    struct DrawListCreateInfo {
+        // most draws a single frame can hold
+        uint32_t max_draws;
+        uint32_t frame_flight_count;
+        // from ApiCluster::get_features(), without it every command
+        //   is its own vkCmdDrawIndexedIndirect call
+        bool multi_draw_indirect;
+        // from ApiCluster::get_features(), without it indirect commands
+        //   must keep firstInstance at 0 so Add rejects anything else
+        bool draw_indirect_first_instance;
+        // from ApiCluster::get_vulkan_12_features(), batches are drawn
+        //   with vkCmdDrawIndexedIndirectCount so the GPU (culling) can
+        //   lower a batch's count by rewriting the count buffer
+        bool draw_indirect_count;
+        // optional, command buffers are sub-allocated from this
+        MemoryAllocator* allocator;
+        // optional, buffers are retired through this on destruction
+        DestructionQueue* retire_queue;
+    };
+
+    // draws sharing all of these go out in a single indirect call
+    struct DrawBatchKey {
+        VkPipeline pipeline;
+        VkBuffer vertex_buffer;
+        VkBuffer index_buffer;
+        VkIndexType index_type;
+    };
+
+    // a contiguous run of commands in the frame's indirect buffer
+    struct DrawBatch {
+        DrawBatchKey key;
+        // in commands, not bytes
+        uint32_t first_command;
+        uint32_t command_count;
+    };
+
+    // collects indexed draws on the CPU, then writes them into a
+    //   persistently mapped indirect buffer grouped by pipeline and
+    //   geometry. per-object data should be looked up in shaders with
+    //   the instance index, which firstInstance is set up for when the
+    //   device has drawIndirectFirstInstance
+    class DrawList {
+       private:
+        struct Draw {
+            DrawBatchKey key;
+            VkDrawIndexedIndirectCommand command;
+        };
+
+        struct FrameBuffers {
+            std::unique_ptr<Buffer> commands;
+            // one uint32_t per batch, only used with draw_indirect_count
+            std::unique_ptr<Buffer> counts;
+        };
+
+        uint32_t max_draws;
+        bool multi_draw_indirect;
+        bool draw_indirect_first_instance;
+        bool draw_indirect_count;
+
+        std::vector<FrameBuffers> frames;
+        uint32_t frame_index;
+
+        std::vector<Draw> draws;
+        std::vector<DrawBatch> batches;
+        bool is_built;
+
+       public:
+        DrawList(const DrawListCreateInfo& create_info, const ApiContext& a_ctx);
+        ~DrawList();
+
+        // clears last frame's draws, frame_index picks which buffers get
+        //   written so frames in flight aren't overwritten
+        void Begin(uint32_t frame_index);
+
+        void Add(const DrawBatchKey& key, const VkDrawIndexedIndirectCommand& command);
+        // draws the mesh's full detail level, first_instance is usually
+        //   the object's index into per-object shader data
+        void Add(VkPipeline pipeline, const Mesh& mesh, uint32_t instance_count = 1, uint32_t first_instance = 0);
+        // draws one of the mesh's levels, usually from Mesh::SelectLod
+        void Add(VkPipeline pipeline, const Mesh& mesh, const MeshLod& lod, uint32_t instance_count = 1, uint32_t first_instance = 0);
+
+        // sorts draws into batches and writes them to this frame's
+        //   buffers, CmdDraw calls this if it hasn't happened yet. call
+        //   it earlier when a compute pass needs to process the commands
+        void Build();
+        // binds and draws every batch, must be inside a render pass.
+        //   pipelines are bound by the list, descriptor sets are not
+        void CmdDraw(VkCommandBuffer command_buffer);
+
+        const std::vector<DrawBatch>& get_batches() const;
+        size_t get_draw_count() const;
+        // this frame's buffers, commands are tightly packed
+        //   VkDrawIndexedIndirectCommands in batch order
+        VkBuffer get_command_buffer() const;
+        // null unless draw_indirect_count is on
+        VkBuffer get_count_buffer() const;
+    };
+}
@@ -5,3 +5,20 @@
 #include "swap_chain.h"
 #include "ring_buffer.h"
 #include "destruction_queue.h"
+#include "upload_context.h"
+#include "staging_ring.h"
+#include "pipeline_state.h"
+#include "pipeline_compiler.h"
+#include "pipeline_registry.h"
+#include "shader_library.h"
+#include "frame_readback.h"
+#include "draw_list.h"
+#include "geometry_pool.h"
+#include "mapped_file.h"
+#include "mesh_file.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "texture_file.h"
+#include "texture_streamer.h"
+#include "bindless_heap.h"
+#include "descriptor_allocator.h"
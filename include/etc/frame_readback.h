@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "../base/base.h"
+
+namespace rt {
+    struct ReadbackResult {
+        // only valid for the duration of the callback
+        const void* data;
+        VkDeviceSize size;
+        uint32_t width;
+        uint32_t height;
+        VkFormat format;
+        uint64_t frame_number;
+    };
+
+    using ReadbackCallback = std::function<void(const ReadbackResult& result)>;
+
+    struct FrameReadbackCreateInfo {
+        uint32_t frame_flight_count;
+        // optional, readback buffers are sub-allocated from this
+        MemoryAllocator* allocator;
+        // optional, buffers replaced after a resize are retired through this
+        DestructionQueue* retire_queue;
+    };
+
+    // copies rendered images into persistently mapped host buffers, one
+    //   per frame in flight, and hands the pixels over once the frame
+    //   that copied them has finished. nothing here ever waits on the GPU
+    class FrameReadback {
+       private:
+        struct Slot {
+            std::unique_ptr<Buffer> buffer;
+            uint32_t width;
+            uint32_t height;
+            VkFormat format;
+            VkDeviceSize size;
+            uint64_t frame_number;
+            // null when nothing is pending
+            ReadbackCallback callback;
+        };
+
+        ApiContext a_ctx;
+        MemoryAllocator* allocator;
+        DestructionQueue* retire_queue;
+        VkMemoryPropertyFlags memory_properties;
+        std::vector<Slot> slots;
+
+       public:
+        FrameReadback(const FrameReadbackCreateInfo& create_info, const ApiContext& a_ctx);
+
+        // records a copy of a single color image into frame_index's slot,
+        //   image must be in layout and is left in it. the slot must not
+        //   have an undelivered readback from an earlier frame
+        void CmdCopyImage(
+            VkCommandBuffer command_buffer,
+            uint32_t frame_index,
+            uint64_t frame_number,
+            VkImage image,
+            VkImageLayout layout,
+            VkExtent2D extent,
+            VkFormat format,
+            ReadbackCallback callback
+        );
+
+        // runs callbacks for every readback recorded at or before
+        //   completed_frame_number, oldest first
+        void Deliver(uint64_t completed_frame_number);
+
+        size_t get_pending_count() const;
+    };
+}
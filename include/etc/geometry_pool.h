@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <map>
+#include <memory>
+#include "../base/base.h"
+#include "destruction_queue.h"
+#include "upload_context.h"
+#include "staging_ring.h"
+
+namespace rt {
+    // index into a pool's allocation table, stays valid across compaction
+    using GeometryHandle = uint32_t;
+
+    struct GeometryPoolCreateInfo {
+        // every mesh in a pool shares one vertex layout
+        VkDeviceSize vertex_size;
+        uint32_t vertex_capacity;
+        uint32_t index_capacity;
+        VkIndexType index_type;
+        // optional, arenas will be sub-allocated from this
+        MemoryAllocator* allocator;
+        // keyed by frame number, freed ranges only become reusable once
+        //   in flight frames are done drawing from them (immediately when
+        //   null). required for CmdCompact to retire the old arenas
+        DestructionQueue* retire_queue;
+    };
+
+    // where a mesh lives in the pool, in vertices and indices
+    struct GeometryRange {
+        int32_t vertex_offset;
+        uint32_t vertex_count;
+        uint32_t first_index;
+        uint32_t index_count;
+    };
+
+    // two big device local arenas meshes are sub-allocated into, so a
+    //   whole scene shares one vertex and one index buffer binding and
+    //   draws pick their mesh with vertexOffset and firstIndex
+    class GeometryPool {
+       private:
+        // first fit over free spans keyed by offset, neighbours are merged on free
+        struct RangeAllocator {
+            std::map<uint32_t, uint32_t> free_ranges;
+            uint32_t capacity;
+            uint32_t used;
+
+            void Reset(uint32_t new_capacity, uint32_t new_used);
+            bool Allocate(uint32_t count, uint32_t* out_offset);
+            void Free(uint32_t offset, uint32_t count);
+        };
+
+        // shared with deferred frees so they can tell if the pool was
+        //   destroyed or compacted before the frame retired
+        struct Arenas {
+            RangeAllocator vertices;
+            RangeAllocator indices;
+        };
+
+        struct Slot {
+            GeometryRange range;
+            bool live;
+        };
+
+        ApiContext a_ctx;
+        VkDeviceSize vertex_size;
+        VkIndexType index_type;
+        VkDeviceSize index_size;
+        MemoryAllocator* allocator;
+        DestructionQueue* retire_queue;
+
+        std::unique_ptr<Buffer> vertex_buffer;
+        std::unique_ptr<Buffer> index_buffer;
+        std::shared_ptr<Arenas> arenas;
+
+        std::vector<Slot> slots;
+        std::vector<GeometryHandle> free_slots;
+
+        std::unique_ptr<Buffer> CreateArena(VkDeviceSize size, VkBufferUsageFlags usage);
+        // hands just this range of both arenas to the graphics queue
+        void ReleaseRange(const GeometryRange& range, UploadContext& upload);
+
+       public:
+        GeometryPool(const GeometryPoolCreateInfo& create_info, const ApiContext& a_ctx);
+        ~GeometryPool();
+
+        // reserves space without writing anything, throws if either arena is full
+        GeometryHandle Allocate(uint32_t vertex_count, uint32_t index_count);
+        // the range is reused once the current frame retires
+        void Free(GeometryHandle handle);
+
+        // indices are relative to the mesh, not the arena
+        void Write(GeometryHandle handle, const void* vertices, const void* indices, UploadContext& upload);
+        void Write(GeometryHandle handle, const void* vertices, const void* indices, StagingRing& staging);
+
+        // packs every live range to the front of fresh arenas, must be
+        //   outside a render pass and after uploads into the pool have
+        //   finished. handles keep working but their ranges move, so draw
+        //   commands have to be rebuilt afterwards
+        void CmdCompact(VkCommandBuffer command_buffer);
+
+        const GeometryRange& get_range(GeometryHandle handle) const;
+        VkBuffer get_vertex_buffer() const;
+        VkBuffer get_index_buffer() const;
+        VkIndexType get_index_type() const;
+        VkDeviceSize get_vertex_size() const;
+        uint32_t get_used_vertices() const;
+        uint32_t get_used_indices() const;
+        // number of holes between allocations, a rough fragmentation measure
+        size_t get_free_range_count() const;
+    };
+}
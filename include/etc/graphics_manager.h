@@ -8,6 +8,10 @@
 #include "swap_chain.h"
 #include "destruction_queue.h"
 #include "api_cluster.h"
+#include "upload_context.h"
+#include "staging_ring.h"
+#include "frame_readback.h"
+#include "pipeline_compiler.h"
 #include <functional>
 
 namespace rt {
@@ -22,20 +26,58 @@ namespace rt {
         //   is recreated upon window resizing
         std::function<void(std::shared_ptr<SwapChain>)> on_swapchain_recreate_callback;
 
+        // when the api cluster is headless frames are rendered into
+        //   offscreen targets instead, and swap_chain.extent must be set
         const SwapChainCreateInfo& swap_chain;
         const GraphicsPipelineCreateInfo& graphics_pipeline;
+
+        // optional size of a persistent staging ring for streaming
+        //   uploads, no ring is created if this is zero
+        VkDeviceSize staging_ring_size;
+
+        // optional, paces frames with a single Vulkan 1.2 timeline
+        //   semaphore counting frame numbers instead of per-frame fences
+        bool use_timeline_semaphore;
+
+        // optional number of threads that will record secondary command
+        //   buffers in parallel, each gets its own pool per frame in flight
+        uint32_t worker_count;
+
+        // optional, records uploads on the device's dedicated transfer
+        //   queue so they overlap rendering. ownership is handed to the
+        //   graphics queue at the start of the next submitted frame. falls
+        //   back to the graphics queue if there's no transfer family
+        bool use_transfer_queue;
+
+        // optional, graphics_pipeline is compiled on this while the swap
+        //   chain is created, retiring through the compiler's retire_queue
+        //   instead of its own. built on the constructor's thread if null
+        PipelineCompiler* pipeline_compiler;
+    };
+
+    struct WorkerCommandPool {
+        VkCommandPool pool;
+        std::vector<VkCommandBuffer> command_buffers;
+        uint32_t used_count;
+        std::vector<VkCommandBuffer> recorded;
     };
 
     struct FrameData {
         VkSemaphore image_available_semaphore;
         VkFence in_flight_fence;
         VkCommandBuffer command_buffer;
+        // records upload acquire barriers ahead of command_buffer
+        VkCommandBuffer acquire_command_buffer;
+        // frame number last submitted with this frame data
+        uint64_t frame_number;
+        std::vector<WorkerCommandPool> worker_pools;
     };
 
     class GraphicsManager {
        private:
         std::shared_ptr<ApiCluster> api_cluster;
         VkDevice device;
+        bool headless;
 
         SwapChainCreateInfo swap_chain_create_info;
         std::shared_ptr<SwapChain> swap_chain;
@@ -52,12 +94,36 @@ namespace rt {
         VkCommandPool command_pool;
         VkClearValue clear_value;
 
+        std::shared_ptr<UploadContext> upload_context;
+        std::shared_ptr<StagingRing> staging_ring;
+        std::shared_ptr<FrameReadback> readback;
+
         DestructionQueue destruction_queue;
 
+        // resources are retired keyed by frame number, frame N's
+        //   resources are released once frame N's fence signals
+        DestructionQueue retire_queue;
+        uint64_t frame_number;
+        uint64_t completed_frame_number;
+
+        bool use_timeline_semaphore;
+        VkSemaphore frame_timeline;
+
+        // what the frame command buffer still needs a barrier for,
+        //   compute and graphics work are only synced at their boundaries
+        bool in_render_pass;
+        bool compute_written;
+        bool graphics_written;
+
         void CreateCommandPool(const GraphicsManagerCreateInfo& create_info);
+        void CreateUploadContext(const GraphicsManagerCreateInfo& create_info);
         void CreateFrameDataAndCommandBuffers(const GraphicsManagerCreateInfo& create_info);
         void CreateRenderObjects(const GraphicsManagerCreateInfo& create_info);
         void CreateSyncObjects(const GraphicsManagerCreateInfo& create_info);
+        void CreateWorkerPools(const GraphicsManagerCreateInfo& create_info);
+
+        void CmdSetDefaultState(VkCommandBuffer command_buffer);
+        void CmdSyncComputeToGraphics(VkCommandBuffer command_buffer);
 
         void RecreateSwapChain();
 
@@ -66,13 +132,48 @@ namespace rt {
         ~GraphicsManager();
 
         void ResetFrameAndBeginCB();
-        void CmdStartRenderPass();
+        // use VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS when drawing
+        //   with worker command buffers, then call CmdExecuteWorkerCBs
+        void CmdStartRenderPass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void CmdEndRenderPass();
         void EndCBAndPresentFrame();
 
+        // thread safe as long as each worker index is only used by one
+        //   thread at a time, call between ResetFrameAndBeginCB and
+        //   CmdExecuteWorkerCBs. returned command buffers inherit the main
+        //   render pass and already have the pipeline and viewport bound
+        VkCommandBuffer BeginWorkerCB(uint32_t worker_index);
+        void EndWorkerCB(uint32_t worker_index, VkCommandBuffer command_buffer);
+        // executes every ended worker command buffer, ordered by worker index
+        void CmdExecuteWorkerCBs();
+
+        // records a dispatch into the frame command buffer, outside of the
+        //   render pass only. the first dispatch after graphics work waits
+        //   on it, and the next render pass (or the end of the frame) waits
+        //   on every dispatch before it
+        void CmdDispatch(
+            const ComputePipeline& pipeline,
+            const VkDescriptorSet* descriptor_sets,
+            uint32_t descriptor_set_count,
+            uint32_t group_count_x,
+            uint32_t group_count_y = 1,
+            uint32_t group_count_z = 1
+        );
+        // orders dispatches that read what an earlier dispatch wrote
+        void CmdComputeBarrier();
+
+        // copies this frame's color target to the host, call after
+        //   CmdEndRenderPass. the callback runs from a later
+        //   ResetFrameAndBeginCB or PollReadbacks once the frame is done
+        void CmdReadbackFrame(ReadbackCallback callback);
+        // delivers finished readbacks without blocking
+        void PollReadbacks();
+
         // getters/setters
 
         VkCommandBuffer get_command_buffer() const;
+        uint32_t get_worker_count() const;
+        bool is_headless() const;
         VkDevice get_device() const;
         VkPhysicalDevice get_physical_device() const;
         std::shared_ptr<RenderPass> get_render_pass() const;
@@ -82,6 +183,18 @@ namespace rt {
         VkCommandPool get_command_pool() const;
         VkQueue get_graphics_queue() const;
         VkQueue get_present_queue() const;
+        std::shared_ptr<UploadContext> get_upload_context() const;
+        std::shared_ptr<StagingRing> get_staging_ring() const;
+        std::shared_ptr<FrameReadback> get_frame_readback() const;
+        DestructionQueue& get_retire_queue();
+        uint64_t get_frame_number() const;
+        uint64_t get_completed_frame_number() const;
+        // cheap, doesn't block
+        bool IsFrameComplete(uint64_t frame);
+        void WaitForFrame(uint64_t frame);
+        // signaled with each frame's number once it finishes, can be
+        //   waited on from other queues (null if not in timeline mode)
+        VkSemaphore get_frame_timeline() const;
         VkExtent2D get_swapchain_extent() const;
         ApiContext get_api_context() const;
         GraphicsContext get_graphics_context() const;
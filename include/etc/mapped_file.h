@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace rt {
+    // read only memory mapping of a whole file, unmapped on destruction.
+    //   mappings are page aligned so any word sized reads are fine
+    class MappedFile {
+       private:
+        void* data;
+        size_t size;
+
+       public:
+        // throws if the file can't be opened, is empty or can't be
+        //   mapped. sequential tells the kernel the whole file is about
+        //   to be read front to back so it can read ahead
+        MappedFile(const std::string& path, bool sequential = true);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const void* get_data() const;
+        size_t get_size() const;
+    };
+}
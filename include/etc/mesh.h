@@ -2,9 +2,24 @@
 
 #include <vulkan/vulkan.h>
 #include <memory>
+#include <vector>
 #include "../base/base.h"
+#include "upload_context.h"
+#include "staging_ring.h"
+#include "destruction_queue.h"
+#include "geometry_pool.h"
 
 namespace rt {
+    // a level of detail, every level shares the mesh's vertices and
+    //   draws its own run of the index buffer
+    struct MeshLod {
+        uint32_t first_index;
+        uint32_t index_count;
+        // simplification error relative to the mesh's bounds (the box
+        //   diagonal), 0 for the full detail level
+        float error;
+    };
+
     struct MeshCreateInfo {
         const void* vertices;
         size_t vertex_size;
@@ -12,17 +27,51 @@ namespace rt {
         const void* indices;
         size_t index_size;
         uint32_t num_indices;
+        // optional, buffers will be sub-allocated from this
+        MemoryAllocator* allocator;
+        // optional, records the uploads into this context's current
+        //   batch instead of stalling the queue for each buffer
+        UploadContext* upload_context;
+        // optional, streams through the ring instead of creating staging
+        //   buffers (uploads are recorded into the ring's upload context)
+        StagingRing* staging_ring;
+        // optional, mesh buffers are retired through this on destruction
+        DestructionQueue* retire_queue;
+        // optional, the mesh becomes a range of the pool's shared buffers
+        //   instead of owning its own. needs an upload context or staging
+        //   ring, and the pool's vertex size and index type must match
+        GeometryPool* geometry_pool;
+        // optional, ordered from most to least detailed. without them
+        //   the mesh has a single level covering every index
+        const MeshLod* lods;
+        uint32_t lod_count;
     };
 
     struct Mesh {
        private:
         VkDevice device;
 
+        // either both buffers are owned or the mesh lives in a pool
         std::unique_ptr<Buffer> vertex_buffer;
         std::unique_ptr<Buffer> index_buffer;
+        GeometryPool* geometry_pool;
+        GeometryHandle geometry_handle;
 
         uint32_t num_vertices;
         uint32_t num_indices;
+        VkIndexType index_type;
+        std::vector<MeshLod> lods;
+        UploadToken upload_token;
+
+        static void ReleaseToReader(const Buffer& buffer, VkBufferUsageFlags usage, UploadContext& upload);
+        std::unique_ptr<Buffer> CreateDeviceBuffer(
+            const void* data,
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            const MeshCreateInfo& create_info,
+            const GraphicsContext& g_ctx,
+            const ApiContext& a_ctx
+        );
 
        public:
         Mesh(const MeshCreateInfo& create_info, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
@@ -31,6 +80,23 @@ namespace rt {
         VkBuffer get_vertex_buffer() const;
         VkBuffer get_index_buffer() const;
         uint32_t get_num_vertices() const;
+        // every LOD level together, they're back to back in the index
+        //   buffer. draws should use a level's index_count and first_index
+        //   (on top of get_first_index) from get_lods or SelectLod
         uint32_t get_num_indices() const;
+        VkIndexType get_index_type() const;
+        // where the mesh starts within its buffers, zero unless pooled
+        int32_t get_vertex_offset() const;
+        uint32_t get_first_index() const;
+        // zero if the mesh was uploaded synchronously
+        UploadToken get_upload_token() const;
+
+        // picks the coarsest level whose error stays under max_pixel_error
+        //   when the mesh's bounds cover projected_size pixels on screen
+        const MeshLod& SelectLod(float projected_size, float max_pixel_error = 1.0f) const;
+        // on screen size in pixels of bounds with the given diagonal at a
+        //   distance from a perspective camera, for use with SelectLod
+        static float get_projected_size(float diagonal, float distance, float fov_y, float viewport_height);
+        const std::vector<MeshLod>& get_lods() const;
     };
 }
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "mesh.h"
+
+namespace rt {
+    // "RTMS" when read as little endian bytes
+    constexpr uint32_t MESH_FILE_MAGIC = 0x534D5452;
+    constexpr uint32_t MESH_FILE_VERSION = 1;
+    // vertex and index blobs start on this so they can be
+    //   copied (or read by SIMD loads) straight out of the mapping
+    constexpr uint64_t MESH_FILE_ALIGNMENT = 16;
+
+    // ~~~ on disk layout, everything little endian ~~~
+    //   header, attributes[], lods[], vertex blob, index blob
+
+    struct MeshFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertex_size;
+        // 2 or 4
+        uint32_t index_size;
+        uint32_t attribute_count;
+        uint32_t lod_count;
+        uint64_t vertex_offset;
+        uint64_t vertex_bytes;
+        uint64_t index_offset;
+        uint64_t index_bytes;
+    };
+
+    struct MeshFileAttribute {
+        uint32_t location;
+        // a VkFormat
+        uint32_t format;
+        uint32_t offset;
+        uint32_t reserved;
+    };
+
+    // every level shares the vertex blob and owns a run of the index blob,
+    //   level 0 is the full detail mesh
+    struct MeshFileLod {
+        uint32_t first_index;
+        uint32_t index_count;
+        // simplification error relative to the mesh's bounds, 0 for level 0
+        float error;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(MeshFileHeader) == 56);
+    static_assert(sizeof(MeshFileAttribute) == 16);
+    static_assert(sizeof(MeshFileLod) == 16);
+
+    struct MeshFileWriteInfo {
+        const void* vertices;
+        uint32_t vertex_size;
+        uint32_t num_vertices;
+        const void* indices;
+        uint32_t index_size;
+        uint32_t num_indices;
+        const MeshFileAttribute* attributes;
+        uint32_t attribute_count;
+        // optional, a single level covering every index is written if empty
+        const MeshFileLod* lods;
+        uint32_t lod_count;
+    };
+
+    // read only memory mapping of a mesh file, nothing is parsed or
+    //   copied on load. the blobs are handed to Mesh as they are, so
+    //   the only copy is the one into staging memory. loading does read
+    //   the index blob once to check every index against the vertices
+    class MeshFile {
+       private:
+        MappedFile mapping;
+        const MeshFileHeader* header;
+        // the on disk levels in the layout Mesh takes
+        std::vector<MeshLod> lods;
+
+        bool IndicesInRange() const;
+
+       public:
+        MeshFile(const std::string& path);
+        ~MeshFile();
+
+        MeshFile(const MeshFile&) = delete;
+        MeshFile& operator=(const MeshFile&) = delete;
+
+        static void Write(const std::string& path, const MeshFileWriteInfo& write_info);
+
+        // vertices and indices point into the mapping, so this file must
+        //   outlive the Mesh constructor. upload fields are left empty
+        MeshCreateInfo get_mesh_create_info() const;
+        VkVertexInputBindingDescription get_binding_description(uint32_t binding) const;
+        std::vector<VkVertexInputAttributeDescription> get_attribute_descriptions(uint32_t binding) const;
+
+        const MeshFileHeader& get_header() const;
+        const MeshFileAttribute* get_attributes() const;
+        const MeshFileLod* get_lods() const;
+        const void* get_vertices() const;
+        const void* get_indices() const;
+        uint32_t get_num_vertices() const;
+        uint32_t get_num_indices() const;
+    };
+}
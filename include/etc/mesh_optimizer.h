@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "mesh.h"
+
+namespace rt {
+    struct MeshOptimizerSettings {
+        // entries in the simulated post transform cache, 0 falls back
+        //   to 16 which is conservative for most desktop GPUs
+        uint32_t cache_size;
+        // reorders vertices by first use so fetches walk memory forwards,
+        //   vertices no triangle uses are dropped along the way
+        bool optimize_vertex_fetch;
+        // sorts triangle clusters so outward facing ones draw first,
+        //   needs position_offset to point at three floats in each vertex
+        bool optimize_overdraw;
+        uint32_t position_offset;
+        // how much worse ACMR may get for the overdraw order to be
+        //   kept, e.g. 1.05 (anything below 1 falls back to 1.05)
+        float overdraw_threshold;
+        // writes 16 bit indices when every vertex index fits
+        bool downcast_indices;
+    };
+
+    struct MeshCacheStats {
+        // average cache miss ratio, transformed vertices per triangle (0.5 - 3)
+        float acmr;
+        // average transform to vertex ratio, transformed vertices per vertex (1 is ideal)
+        float atvr;
+    };
+
+    struct OptimizedMesh {
+        std::vector<uint8_t> vertices;
+        std::vector<uint8_t> indices;
+        uint32_t vertex_size;
+        uint32_t num_vertices;
+        uint32_t index_size;
+        uint32_t num_indices;
+        MeshCacheStats before;
+        MeshCacheStats after;
+
+        // copies the upload fields from base, data points into this mesh
+        MeshCreateInfo get_mesh_create_info(const MeshCreateInfo& base) const;
+    };
+
+    // offline style optimization of indexed triangle lists before upload,
+    //   tipsify (Sander et al. 2007) for vertex cache locality followed by
+    //   their cluster sort for overdraw. everything here is CPU only
+    class MeshOptimizer {
+       public:
+        // only the geometry fields of source are read
+        static OptimizedMesh Optimize(const MeshCreateInfo& source, const MeshOptimizerSettings& settings);
+        // optimizes each mesh on its own worker thread, 0 threads uses
+        //   one per hardware thread. results are in the same order as sources
+        static std::vector<OptimizedMesh> OptimizeAll(
+            const MeshCreateInfo* sources,
+            uint32_t source_count,
+            const MeshOptimizerSettings& settings,
+            uint32_t thread_count = 0
+        );
+
+        // simulates a FIFO cache of cache_size entries over the triangles,
+        //   throws if an index is num_vertices or above
+        static MeshCacheStats AnalyzeCache(const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size);
+    };
+}
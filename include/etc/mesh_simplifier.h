@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "mesh.h"
+
+namespace rt {
+    struct MeshLodSettings {
+        // points at three floats in each vertex
+        uint32_t position_offset;
+        // levels to generate including level 0, 0 falls back to 4
+        uint32_t max_lod_count;
+        // index count of each level relative to the one before it,
+        //   e.g. 0.5 (anything outside (0, 1) falls back to 0.5)
+        float reduction;
+        // generation stops once a level would need more error than
+        //   this (relative to the mesh's bounds), 0 means no limit
+        float max_error;
+    };
+
+    struct MeshLodChain {
+        // every level back to back, level 0 is the source's indices
+        std::vector<uint8_t> indices;
+        uint32_t index_size;
+        uint32_t num_indices;
+        std::vector<MeshLod> lods;
+
+        // copies base and swaps in the chain's indices and levels, so
+        //   vertices still come from base and this must outlive the Mesh
+        //   constructor
+        MeshCreateInfo get_mesh_create_info(const MeshCreateInfo& base) const;
+    };
+
+    // quadric error metric simplification (Garland and Heckbert 1997)
+    //   restricted to collapsing vertices into their neighbours, so every
+    //   level indexes the source's vertex buffer and no vertices are added.
+    //   run MeshOptimizer first, coarser levels keep the surviving
+    //   triangles in their original (cache friendly) order
+    class MeshSimplifier {
+       public:
+        // only the geometry fields of source are read
+        static MeshLodChain GenerateLods(const MeshCreateInfo& source, const MeshLodSettings& settings);
+    };
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include "../base/base.h"
+#include "pipeline_state.h"
+#include "pipeline_registry.h"
+
+namespace rt {
+    using PipelineFuture = std::shared_future<std::shared_ptr<GraphicsPipeline>>;
+
+    struct PipelineCompilerCreateInfo {
+        // 0 uses one thread per hardware thread
+        uint32_t thread_count;
+        // optional, used by every request that doesn't set its own
+        VkPipelineCache pipeline_cache;
+        // optional, compiled pipelines are retired through this instead
+        //   of waiting for the device to go idle. deduplicated pipelines
+        //   are shared, so it replaces the retire_queue of every request
+        //   (a registry's own queue wins over both)
+        DestructionQueue* retire_queue;
+        // optional, workers build through this so compiled pipelines
+        //   and their layouts are shared with everything else using it
+        PipelineRegistry* registry;
+    };
+
+    // compiles graphics pipelines on a pool of worker threads,
+    //   identical requests share one compile and one pipeline. finished
+    //   pipelines are only held weakly, but queued and running compiles
+    //   aren't, so it has to be destroyed (or WaitIdle'd and Clear'ed)
+    //   before the ApiCluster it compiles for
+    class PipelineCompiler {
+       private:
+        struct Job {
+            std::shared_ptr<const GraphicsPipelineState> state;
+            std::promise<std::shared_ptr<GraphicsPipeline>> promise;
+        };
+
+        struct Request {
+            std::shared_ptr<const GraphicsPipelineState> state;
+            // only valid until the compile finishes, then it's dropped so
+            //   this doesn't keep the pipeline alive
+            PipelineFuture future;
+            std::weak_ptr<GraphicsPipeline> pipeline;
+        };
+
+        ApiContext a_ctx;
+        VkPipelineCache pipeline_cache;
+        DestructionQueue* retire_queue;
+        PipelineRegistry* registry;
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable job_available;
+        std::condition_variable jobs_done;
+        std::deque<Job> jobs;
+        uint32_t active_jobs;
+        bool stopping;
+
+        // keyed by state hash, collisions are resolved by comparing states
+        std::unordered_map<uint64_t, std::vector<Request>> requests;
+
+        void WorkerLoop();
+        // swaps a finished request's future for a weak reference, or
+        //   forgets it if the compile failed
+        void ResolveRequest(const std::shared_ptr<const GraphicsPipelineState>& state, const std::shared_ptr<GraphicsPipeline>& pipeline);
+
+       public:
+        PipelineCompiler(const PipelineCompilerCreateInfo& create_info, const ApiContext& a_ctx);
+        // finishes every queued job before returning
+        ~PipelineCompiler();
+
+        // create_info and everything it points at is copied, so it
+        //   doesn't need to outlive this call. compile errors are
+        //   rethrown from the future's get(), and failed requests
+        //   aren't deduplicated against. retire_queue is ignored
+        PipelineFuture Compile(const GraphicsPipelineCreateInfo& create_info);
+        std::vector<PipelineFuture> Compile(const GraphicsPipelineCreateInfo* create_infos, uint32_t count);
+
+        // blocks until every queued job has finished
+        void WaitIdle();
+        // forgets previous requests so they're no longer deduplicated
+        //   against, pipelines live on as long as a future holds them
+        void Clear();
+
+        uint32_t get_thread_count() const;
+    };
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include "../base/base.h"
+#include "pipeline_state.h"
+
+namespace rt {
+    struct PipelineRegistryCreateInfo {
+        // optional, used by every request that doesn't set its own
+        VkPipelineCache pipeline_cache;
+        // optional, pipelines and layouts are retired through
+        //   this instead of waiting for the device to go idle. it
+        //   replaces the retire_queue of every request, which is ignored
+        DestructionQueue* retire_queue;
+    };
+
+    // hands out one shared pipeline per unique pipeline state, and one
+    //   shared layout per unique layout create info. returned pipelines
+    //   keep the layouts alive, so they may outlive the registry, but
+    //   layouts from GetLayout are only valid as long as it's around
+    class PipelineRegistry {
+       private:
+        struct PipelineEntry {
+            std::shared_ptr<const GraphicsPipelineState> state;
+            std::shared_ptr<GraphicsPipeline> pipeline;
+        };
+
+        struct LayoutEntry {
+            std::vector<uint8_t> key;
+            VkPipelineLayout layout;
+        };
+
+        // destroys every layout once the registry and the last pipeline
+        //   it returned are gone, pipelines bind with get_layout()
+        struct LayoutStore {
+            VkDevice device;
+            DestructionQueue* retire_queue;
+            // keyed by key hash, collisions are resolved by comparing keys
+            std::unordered_map<uint64_t, std::vector<LayoutEntry>> entries;
+
+            ~LayoutStore();
+        };
+
+        ApiContext a_ctx;
+        VkPipelineCache pipeline_cache;
+        DestructionQueue* retire_queue;
+
+        std::mutex mutex;
+        // keyed by state hash, collisions are resolved by comparing states
+        std::unordered_map<uint64_t, std::vector<PipelineEntry>> pipelines;
+        std::shared_ptr<LayoutStore> layouts;
+        size_t pipeline_count;
+        size_t layout_count;
+        uint64_t hit_count;
+        uint64_t miss_count;
+
+        VkPipelineLayout GetLayoutLocked(const VkPipelineLayoutCreateInfo& layout_info);
+
+       public:
+        PipelineRegistry(const PipelineRegistryCreateInfo& create_info, const ApiContext& a_ctx);
+        ~PipelineRegistry();
+
+        // returns the existing pipeline for this state, or builds it on
+        //   this thread. layout_create_info is swapped for a shared layout
+        //   and retire_queue for the registry's own
+        std::shared_ptr<GraphicsPipeline> Get(const GraphicsPipelineCreateInfo& create_info);
+        VkPipelineLayout GetLayout(const VkPipelineLayoutCreateInfo& layout_info);
+
+        size_t get_pipeline_count();
+        size_t get_layout_count();
+        uint64_t get_hit_count();
+        uint64_t get_miss_count();
+    };
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include <optional>
+#include "../base/graphics_pipeline.h"
+
+namespace rt {
+    // owning deep copy of everything a GraphicsPipelineCreateInfo points
+    //   at, so it can outlive the caller's structs and be hashed/compared.
+    //   pNext chains aren't supported and will throw
+    class GraphicsPipelineState {
+       private:
+        struct SpecializationStorage {
+            VkSpecializationInfo info;
+            std::vector<VkSpecializationMapEntry> entries;
+            std::vector<uint8_t> data;
+        };
+
+        GraphicsPipelineCreateInfo create_info;
+
+        std::vector<VkPipelineShaderStageCreateInfo> stages;
+        std::vector<std::string> stage_names;
+        std::vector<std::optional<SpecializationStorage>> specializations;
+
+        std::optional<VkPipelineVertexInputStateCreateInfo> vertex_input;
+        std::vector<VkVertexInputBindingDescription> vertex_bindings;
+        std::vector<VkVertexInputAttributeDescription> vertex_attributes;
+
+        std::optional<VkPipelineInputAssemblyStateCreateInfo> input_assembly;
+
+        std::optional<VkPipelineViewportStateCreateInfo> viewport;
+        std::vector<VkViewport> viewports;
+        std::vector<VkRect2D> scissors;
+
+        std::optional<VkPipelineRasterizationStateCreateInfo> rasterizer;
+
+        std::optional<VkPipelineMultisampleStateCreateInfo> multisample;
+        std::vector<VkSampleMask> sample_mask;
+
+        std::optional<VkPipelineDepthStencilStateCreateInfo> depth_stencil;
+
+        std::optional<VkPipelineColorBlendStateCreateInfo> color_blend;
+        std::vector<VkPipelineColorBlendAttachmentState> blend_attachments;
+
+        std::optional<VkPipelineDynamicStateCreateInfo> dynamic_state;
+        std::vector<VkDynamicState> dynamic_states;
+
+        std::optional<VkPipelineLayoutCreateInfo> layout_create_info;
+        std::vector<VkDescriptorSetLayout> set_layouts;
+        std::vector<VkPushConstantRange> push_constant_ranges;
+
+        std::vector<uint8_t> key;
+        uint64_t hash;
+
+        void CopyState(const GraphicsPipelineCreateInfo& source);
+        void PointAtStorage();
+        void BuildKey();
+
+       public:
+        GraphicsPipelineState(const GraphicsPipelineCreateInfo& create_info);
+
+        // internal pointers would dangle if this was copied around
+        GraphicsPipelineState(const GraphicsPipelineState&) = delete;
+        GraphicsPipelineState& operator=(const GraphicsPipelineState&) = delete;
+
+        bool operator==(const GraphicsPipelineState& other) const;
+
+        // points into this object, valid for as long as it lives
+        const GraphicsPipelineCreateInfo& get_create_info() const;
+        uint64_t get_hash() const;
+
+        // key of just the layout, for deduplicating pipeline layouts
+        static std::vector<uint8_t> MakeLayoutKey(const VkPipelineLayoutCreateInfo& layout_info);
+    };
+}
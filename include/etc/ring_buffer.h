@@ -2,6 +2,7 @@
 
 #include "../base/context_structs.h"
 #include "../base/base.h"
+#include <deque>
 #include <memory>
 #include <vector>
 
@@ -11,26 +12,75 @@ namespace rt {
         uint32_t max_elements;
         VkBufferUsageFlags usage;
         VkMemoryPropertyFlags properties;
+        // *_BUFFER_DYNAMIC types share a single descriptor set and pick
+        //   their region with a dynamic offset at bind time, anything
+        //   else gets one descriptor set per element
         VkDescriptorType descriptor_type;
         VkDescriptorSetLayout layout;
     };
 
     class RingBuffer {
        private:
+        // bytes taken by one frame, wrap padding included, and the
+        //   per element descriptor sets it wrote
+        struct FrameRegion {
+            uint64_t frame_number;
+            uint64_t size;
+            uint32_t descriptor_count;
+        };
+
         VkDevice device;
         std::unique_ptr<Buffer> buffer;
         std::unique_ptr<DescriptorPool> pool;
         std::vector<VkDescriptorSet> descriptor_sets;
 
         VkDescriptorType descriptor_type;
+        bool dynamic;
         uint32_t max_elements;
+        // element size rounded up to the device's offset alignment
+        uint64_t element_size;
+        uint64_t alignment;
         uint64_t buffer_offset;
         uint32_t descriptor_index;
 
+        // only tracked once BeginFrame is called, oldest first
+        std::deque<FrameRegion> frames;
+        uint64_t used;
+        uint32_t used_descriptors;
+
+        // finds size contiguous bytes, throws if frames in flight
+        //   still use them
+        uint64_t Reserve(uint64_t size);
+
        public:
         RingBuffer(const RingBufferCreateInfo& create_info, const ApiContext& a_ctx);
         ~RingBuffer();
 
+        // optional, once per frame before writing. regions written during
+        //   frames up to completed_frame_number become free, without this
+        //   the ring wraps over old data unchecked
+        void BeginFrame(uint64_t frame_number, uint64_t completed_frame_number);
+
+        // not for dynamic descriptor types, writes a descriptor per call
         VkDescriptorSet CopyToNextRegion(void* data, size_t size);
+
+        // dynamic descriptor types only, returns the dynamic offset to
+        //   bind get_descriptor_set() with
+        uint32_t Push(const void* data, size_t size);
+        // count tightly packed elements of size bytes in one go. returns
+        //   the first dynamic offset, the rest follow every get_stride()
+        //   bytes. out_offsets is optional and gets every offset
+        uint32_t PushMany(const void* data, size_t size, uint32_t count, uint32_t* out_offsets = nullptr);
+        void CmdBind(
+            VkCommandBuffer command_buffer,
+            VkPipelineLayout pipeline_layout,
+            VkPipelineBindPoint bind_point,
+            uint32_t set_index,
+            uint32_t dynamic_offset
+        ) const;
+
+        VkDescriptorSet get_descriptor_set() const;
+        uint64_t get_stride() const;
+        uint64_t get_alignment() const;
     };
 }
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "../base/base.h"
+
+namespace rt {
+    struct ShaderLibraryCreateInfo {
+        // descriptor count used for runtime sized arrays since
+        //   SPIR-V doesn't say, 0 falls back to 1
+        uint32_t runtime_array_size;
+    };
+
+    struct ShaderDescriptorBinding {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType type;
+        uint32_t count;
+        VkShaderStageFlags stages;
+    };
+
+    // what a module's interface looks like according to its SPIR-V
+    struct ShaderReflection {
+        VkShaderStageFlagBits stage;
+        std::string entry_point;
+        std::vector<ShaderDescriptorBinding> bindings;
+        std::vector<VkPushConstantRange> push_constant_ranges;
+    };
+
+    struct ShaderModule {
+        VkShaderModule module;
+        uint64_t hash;
+        ShaderReflection reflection;
+
+        // pName points into this module so it must outlive the result
+        VkPipelineShaderStageCreateInfo get_stage_create_info() const;
+    };
+
+    // handles are owned by the library that made this
+    struct ShaderLayout {
+        std::vector<VkDescriptorSetLayout> set_layouts;
+        std::vector<VkPushConstantRange> push_constant_ranges;
+
+        // points into this layout so it must outlive the result
+        VkPipelineLayoutCreateInfo get_layout_create_info() const;
+    };
+
+    // owns one shader module per unique SPIR-V binary along with
+    //   descriptor set layouts generated from their reflection
+    class ShaderLibrary {
+       private:
+        struct ModuleEntry {
+            std::vector<uint32_t> code;
+            std::unique_ptr<ShaderModule> shader;
+        };
+
+        ApiContext a_ctx;
+        uint32_t runtime_array_size;
+        uint32_t max_bound_descriptor_sets;
+
+        std::mutex mutex;
+        // keyed by content hash, collisions resolved by comparing code
+        std::unordered_map<uint64_t, std::vector<ModuleEntry>> modules;
+        std::unordered_map<std::string, const ShaderModule*> paths;
+        // keyed by the bindings they were built from
+        std::unordered_map<std::string, std::unique_ptr<DescriptorSetLayout>> set_layouts;
+
+        // modules must have a single entry point, every resource they
+        //   declare is assumed to belong to it
+        ShaderReflection Reflect(const uint32_t* code, size_t word_count) const;
+        const ShaderModule& LoadLocked(const uint32_t* code, size_t size);
+        VkDescriptorSetLayout GetSetLayoutLocked(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+       public:
+        ShaderLibrary(const ShaderLibraryCreateInfo& create_info, const ApiContext& a_ctx);
+        ~ShaderLibrary();
+
+        // memory maps the file, loading the same path twice only
+        //   reads it once. identical bytecode shares one module
+        const ShaderModule& Load(const std::string& path);
+        // size is in bytes
+        const ShaderModule& Load(const uint32_t* code, size_t size);
+
+        // merges reflection from every stage into set layouts and push
+        //   constant ranges, identical set layouts are shared
+        ShaderLayout CreateLayout(const ShaderModule* const* shaders, uint32_t shader_count);
+
+        size_t get_module_count();
+    };
+}
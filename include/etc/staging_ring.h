@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <deque>
+#include "../base/base.h"
+#include "upload_context.h"
+
+namespace rt {
+    struct StagingRingCreateInfo {
+        VkDeviceSize size;
+        std::shared_ptr<UploadContext> upload_context;
+        // optional, ring buffer memory will be sub-allocated from this
+        MemoryAllocator* allocator;
+    };
+
+    class StagingRing {
+       private:
+        // a span of the ring that's in use until its upload finishes
+        struct Region {
+            VkDeviceSize begin;
+            VkDeviceSize end;
+            UploadToken token;
+        };
+
+        std::shared_ptr<UploadContext> upload_context;
+        std::unique_ptr<Buffer> buffer;
+        VkDeviceSize size;
+        VkDeviceSize max_chunk_size;
+        VkDeviceSize head;
+        std::deque<Region> regions;
+
+        void Reclaim();
+        bool TryReserve(VkDeviceSize reserve_size, VkDeviceSize alignment, VkDeviceSize* out_offset);
+        VkDeviceSize Reserve(VkDeviceSize reserve_size, VkDeviceSize alignment);
+
+       public:
+        StagingRing(const StagingRingCreateInfo& create_info, const ApiContext& a_ctx);
+        ~StagingRing();
+
+        // copies data into the ring and records the transfers into the
+        //   upload context, large uploads are split into chunks. when the
+        //   context transfers ownership, callers must release dst themselves
+        //   since only they know how it will be used
+        void CopyToBuffer(const void* data, VkDeviceSize data_size, Buffer& dst, VkDeviceSize dst_offset = 0);
+        // leaves the image in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        //   owned by the upload context's receiving queue
+        void CopyToImage(const void* data, VkDeviceSize data_size, Image& dst);
+        // only records the copies, dst must already be in
+        //   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL (see Image::CopyLevels)
+        void CopyToImageLevel(const void* data, VkDeviceSize data_size, Image& dst, uint32_t mip_level);
+
+        UploadContext& get_upload_context() const;
+        VkDeviceSize get_size() const;
+    };
+}
@@ -7,22 +7,33 @@
 #include <optional>
 
 namespace rt {
+    // color format of headless targets when surface_format isn't set
+    constexpr VkFormat OFFSCREEN_DEFAULT_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
     struct SwapChainCreateInfo {
         uint32_t frame_flight_count;
         std::optional<VkFormat> depth_format;
         std::optional<VkSurfaceFormatKHR> surface_format;
         std::optional<VkPresentModeKHR> present_mode;
+        // required when headless since there's no window to size to
         std::optional<VkExtent2D> extent;
         VkRenderPass render_pass;
     };
 
+    // without a surface (headless api cluster) no VkSwapchainKHR is made,
+    //   instead there's one offscreen color target per frame in flight
+
     class SwapChain {
        private:
         VkDevice device;
         VkSwapchainKHR swap_chain;
         std::vector<VkImage> images;
+        // only used when headless, owns images and image_views
+        std::vector<std::unique_ptr<Image>> offscreen_images;
+        bool headless;
         std::unique_ptr<Image> depth_image;
         VkFormat image_format;
+        VkImageUsageFlags image_usage;
         VkExtent2D extent;
         std::vector<VkImageView> image_views;
         std::vector<VkFramebuffer> framebuffers;
@@ -31,6 +42,7 @@ namespace rt {
         uint32_t frame_flight_index;
 
         void CreateSwapChain(const SwapChainCreateInfo& create_info, const ApiContext& a_ctx);
+        void CreateOffscreenImages(const SwapChainCreateInfo& create_info, const ApiContext& a_ctx);
         void CreateImageViews(const ApiContext& a_ctx);
         void CreateDepthImage(const SwapChainCreateInfo& create_info, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
         void CreateFrameBuffers(const SwapChainCreateInfo& create_info, const ApiContext& a_ctx);
@@ -39,6 +51,7 @@ namespace rt {
         SwapChain(const SwapChainCreateInfo& create_info, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
         ~SwapChain();
 
+        // when headless this never waits and semaphore/fence aren't signaled
         VkResult NextImage(VkSemaphore semaphore, VkFence fence);
         void NextFrame();
 
@@ -46,9 +59,13 @@ namespace rt {
         uint32_t get_image_index() const;
         VkExtent2D get_extent() const;
         VkFormat get_image_format() const;
+        // includes VK_IMAGE_USAGE_TRANSFER_SRC_BIT when images can be read back
+        VkImageUsageFlags get_image_usage() const;
         VkFormat get_depth_format() const;
         uint32_t get_image_count() const;
         uint32_t get_frame_flight_count() const;
+        bool is_headless() const;
+        // null when headless
         VkSwapchainKHR get_swap_chain() const;
         VkFramebuffer get_current_framebuffer() const;
         const std::vector<VkImage>& get_images() const;
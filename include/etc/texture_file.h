@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "../base/base.h"
+
+namespace rt {
+    // "RTTX" when read as little endian bytes
+    constexpr uint32_t TEXTURE_FILE_MAGIC = 0x58545452;
+    constexpr uint32_t TEXTURE_FILE_VERSION = 1;
+    // covers the largest compressed block so levels can be copied
+    //   straight out of the mapping
+    constexpr uint64_t TEXTURE_FILE_ALIGNMENT = 16;
+
+    // ~~~ on disk layout, everything little endian ~~~
+    //   header, levels[], level blobs (largest first)
+
+    struct TextureFileHeader {
+        uint32_t magic;
+        uint32_t version;
+        // a VkFormat, BC1 - BC7 or an uncompressed fallback
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t level_count;
+        uint64_t reserved;
+    };
+
+    struct TextureFileLevel {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    static_assert(sizeof(TextureFileHeader) == 32);
+    static_assert(sizeof(TextureFileLevel) == 24);
+
+    struct TextureFileWriteInfo {
+        VkFormat format;
+        uint32_t width;
+        uint32_t height;
+        // largest first, each tightly packed
+        const ImageLevelData* levels;
+        uint32_t level_count;
+    };
+
+    // read only memory mapping of a texture file, levels are handed to
+    //   Image::CopyLevels straight out of the mapping
+    class TextureFile {
+       private:
+        MappedFile mapping;
+        const TextureFileHeader* header;
+
+       public:
+        TextureFile(const std::string& path);
+        ~TextureFile();
+
+        TextureFile(const TextureFile&) = delete;
+        TextureFile& operator=(const TextureFile&) = delete;
+
+        static void Write(const std::string& path, const TextureFileWriteInfo& write_info);
+
+        // throws if the device can't sample the file's format, so callers
+        //   can fall back to an uncompressed file. allocator and retire
+        //   queue are left empty
+        ImageCreateInfo get_image_create_info(VkPhysicalDevice physical_device) const;
+        // point into the mapping, so this file must outlive the upload
+        std::vector<ImageLevelData> get_level_data() const;
+
+        const TextureFileHeader& get_header() const;
+        const TextureFileLevel* get_levels() const;
+        VkFormat get_format() const;
+        uint32_t get_width() const;
+        uint32_t get_height() const;
+        uint32_t get_level_count() const;
+    };
+}
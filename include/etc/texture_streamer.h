@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include "../base/base.h"
+#include "destruction_queue.h"
+#include "staging_ring.h"
+#include "texture_file.h"
+
+namespace rt {
+    using TextureHandle = uint32_t;
+
+    struct TextureStreamerCreateInfo {
+        // bytes of device memory every streamed texture may use together,
+        //   counted as allocated (alignment and allocator rounding included).
+        //   the mip tails are kept resident even if they go over it.
+        //   dropping a level allocates the smaller image before the old
+        //   one retires, so evictions can briefly go over by that much
+        VkDeviceSize budget;
+        // upload bytes started per Update, at least one upload always
+        //   goes out so textures larger than this still make progress
+        VkDeviceSize max_upload_bytes_per_frame;
+        // levels this size or smaller (in texels, largest side) are the
+        //   mip tail, loaded first and never evicted. 0 falls back to 64
+        uint32_t tail_size;
+        std::shared_ptr<StagingRing> staging_ring;
+        // replaced images are retired through this, they may still be
+        //   in use by frames in flight
+        DestructionQueue* retire_queue;
+        // optional, images are sub-allocated from this
+        MemoryAllocator* allocator;
+    };
+
+    // keeps a window of each texture's mip chain resident, starting with
+    //   the tail and moving one level finer at a time as usage asks for it.
+    //   levels can't be added to a live image, so every change uploads a
+    //   new image from the mapped file and swaps it in once it's done
+    class TextureStreamer {
+       private:
+        struct Texture {
+            std::shared_ptr<const TextureFile> file;
+            std::unique_ptr<Image> image;
+            // finest file level in image, level count when nothing is resident
+            uint32_t resident_level;
+            uint32_t tail_level;
+            // device memory an image starting at each level takes, 0 until
+            //   it's been queried or created
+            std::vector<VkDeviceSize> memory_sizes;
+
+            std::unique_ptr<Image> pending;
+            uint32_t pending_level;
+            UploadToken pending_token;
+
+            // finest level asked for since the last Update
+            uint32_t wanted_level;
+            uint64_t last_used_frame;
+            bool alive;
+        };
+
+        ApiContext a_ctx;
+        VkDeviceSize budget;
+        VkDeviceSize max_upload_bytes_per_frame;
+        uint32_t tail_size;
+        std::shared_ptr<StagingRing> staging_ring;
+        DestructionQueue* retire_queue;
+        MemoryAllocator* allocator;
+
+        std::vector<Texture> textures;
+        std::vector<TextureHandle> free_handles;
+        std::vector<TextureHandle> changed;
+
+        // pending images of removed textures, waiting on their upload
+        struct AbandonedUpload {
+            std::unique_ptr<Image> image;
+            UploadToken token;
+            VkDeviceSize bytes;
+        };
+        std::vector<AbandonedUpload> abandoned_uploads;
+        uint64_t frame_number;
+        // replaced images that haven't been destroyed yet, shared with
+        //   their retire callbacks so it can outlive the streamer
+        std::shared_ptr<std::atomic<VkDeviceSize>> retiring_bytes;
+
+        // file bytes of levels first_level and coarser, what uploading them
+        //   costs. device memory is counted with GetImageSize instead
+        static VkDeviceSize GetChainSize(const TextureFile& file, uint32_t first_level);
+        ImageCreateInfo GetImageCreateInfo(const TextureFile& file, uint32_t first_level) const;
+        // device memory an image of levels first_level and coarser takes
+        VkDeviceSize GetImageSize(Texture& texture, uint32_t first_level);
+        // memory a texture holds right now, live and pending images
+        VkDeviceSize GetHeldSize(const Texture& texture) const;
+        // memory a texture will hold once its pending upload lands
+        VkDeviceSize GetSettledSize(const Texture& texture) const;
+        // returns the file bytes it put into the staging ring
+        VkDeviceSize StartUpload(TextureHandle handle, uint32_t first_level);
+        // counts image's bytes as retiring until it's destroyed, which
+        //   happens once frames in flight are done with it
+        void RetireImage(std::unique_ptr<Image> image, VkDeviceSize bytes);
+        // RetireImage for bytes that were already counted as retiring
+        void QueueImageRetire(std::unique_ptr<Image> image, VkDeviceSize bytes);
+        // counts an unfinished upload's image as retiring and holds it
+        //   until Update sees the upload finish
+        void RetirePending(Texture& texture);
+        // drops a level from something other than keep, held and settled
+        //   are the totals Update is working with
+        bool EvictOne(TextureHandle keep, VkDeviceSize* upload_bytes, VkDeviceSize* held, VkDeviceSize* settled);
+
+       public:
+        TextureStreamer(const TextureStreamerCreateInfo& create_info, const ApiContext& a_ctx);
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        // the file stays mapped for as long as the texture is streamed.
+        //   handles are reused once removed, until then the functions
+        //   taking one throw on a removed handle
+        TextureHandle Add(std::shared_ptr<const TextureFile> file);
+        void Remove(TextureHandle handle);
+
+        // usage feedback, call for every texture drawn this frame with
+        //   the finest level it needs (see get_wanted_level)
+        void RequestLevel(TextureHandle handle, uint32_t level);
+        // once per frame before recording, swaps in finished uploads,
+        //   evicts least recently used levels when over budget and starts
+        //   the next uploads (finest missing tail first). submits the
+        //   staging ring's upload context itself when it started any
+        void Update(uint64_t frame_number);
+
+        // level a texture texture_size texels wide needs to cover
+        //   projected_size pixels on screen without minifying
+        static uint32_t get_wanted_level(uint32_t texture_size, float projected_size);
+
+        // null until the texture's tail is resident, bind a fallback until
+        //   then. may change on Update, see get_changed
+        const Image* get_image(TextureHandle handle) const;
+        // finest level that's resident, in levels of the texture's file
+        uint32_t get_resident_level(TextureHandle handle) const;
+        // textures whose image changed in the last Update, descriptors
+        //   pointing at their old views need to be rewritten
+        const std::vector<TextureHandle>& get_changed() const;
+        // device memory held right now, counting pending uploads and
+        //   replaced images that haven't retired yet
+        VkDeviceSize get_committed_bytes() const;
+        VkDeviceSize get_budget() const;
+    };
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <optional>
+#include "../base/context_structs.h"
+#include "destruction_queue.h"
+
+namespace rt {
+    // monotonically increasing id of an upload batch, a token
+    //   is complete once the batch it was recorded in finishes
+    using UploadToken = uint64_t;
+
+    struct UploadContextCreateInfo {
+        VkQueue queue;
+        uint32_t queue_family_index;
+        // optional, family of the queue that uses uploaded resources. when
+        //   it differs from queue_family_index, resources handed to the
+        //   Release* functions have their ownership transferred over
+        std::optional<uint32_t> dst_queue_family_index;
+    };
+
+    // everything the receiving queue needs to take ownership of
+    //   uploads, the semaphores must be waited on at dst_stages in
+    //   the same batch that records the acquire barriers
+    struct UploadHandoff {
+        std::vector<VkSemaphore> semaphores;
+        std::vector<VkBufferMemoryBarrier> buffer_barriers;
+        std::vector<VkImageMemoryBarrier> image_barriers;
+        VkPipelineStageFlags dst_stages;
+        // recorded right after the acquire barriers, for work the
+        //   sending queue can't do itself (blits on a transfer queue)
+        std::vector<std::function<void(VkCommandBuffer)>> commands;
+    };
+
+    class UploadContext {
+       private:
+        struct Batch {
+            VkCommandBuffer command_buffer;
+            VkFence fence;
+            UploadToken token;
+            std::vector<std::function<void()>> on_complete;
+        };
+
+        VkDevice device;
+        VkQueue queue;
+        uint32_t queue_family_index;
+        uint32_t dst_queue_family_index;
+        bool transfers_ownership;
+        VkCommandPool command_pool;
+
+        // acquire barriers of the recording batch, and everything
+        //   submitted that the receiving queue hasn't taken yet
+        UploadHandoff recording_acquires;
+        UploadHandoff handoff;
+        std::vector<VkSemaphore> free_semaphores;
+
+        Batch recording;
+        bool is_recording;
+        std::deque<Batch> in_flight;
+        std::vector<Batch> free_batches;
+        UploadToken next_token;
+        UploadToken completed_token;
+
+        // keyed by upload token, things queued here are released
+        //   once the batch they were queued during has finished
+        DestructionQueue retire_queue;
+
+        void BeginBatch();
+        void RetireFront();
+
+       public:
+        UploadContext(const UploadContextCreateInfo& create_info, const ApiContext& a_ctx);
+        ~UploadContext();
+
+        // returns the command buffer of the batch currently being
+        //   recorded, starting a new batch if there isn't one
+        VkCommandBuffer AcquireCommandBuffer();
+        // token that completes once everything recorded so far has, the
+        //   recording batch's if there is one and the last submitted
+        //   batch's otherwise. never starts a batch
+        UploadToken get_recording_token() const;
+
+        // runs once the current batch finishes on the GPU,
+        //   useful for freeing staging buffers
+        void QueueOnComplete(std::function<void()> func);
+        DestructionQueue& get_retire_queue();
+
+        // hands a buffer written by this batch to the receiving queue, a
+        //   no-op when both are the same family (Submit's barrier covers it).
+        //   only offset..offset+size changes hands, so sub-allocated buffers
+        //   should pass just the range they wrote
+        void ReleaseBuffer(
+            VkBuffer buffer,
+            VkAccessFlags dst_access,
+            VkPipelineStageFlags dst_stage,
+            VkDeviceSize offset = 0,
+            VkDeviceSize size = VK_WHOLE_SIZE
+        );
+        // transitions an image written by this batch from old_layout to
+        //   new_layout, transferring ownership on the way if needed
+        void ReleaseImage(
+            VkImage image,
+            VkImageAspectFlags aspect,
+            VkImageLayout old_layout,
+            VkImageLayout new_layout,
+            VkAccessFlags dst_access,
+            VkPipelineStageFlags dst_stage
+        );
+
+        // records onto whichever queue receives this batch's resources,
+        //   right away on a shared queue and after the acquire otherwise.
+        //   only handles captured by value are safe to use in record
+        void RecordOnReceiver(std::function<void(VkCommandBuffer)> record);
+
+        // moves out everything submitted since the last call, returns
+        //   false when there's nothing to acquire. semaphores must be
+        //   given back with RecycleSemaphores once the wait on them is done
+        bool TakeHandoff(UploadHandoff* out_handoff);
+        void RecycleSemaphores(const std::vector<VkSemaphore>& semaphores);
+
+        UploadToken Submit();
+        void Wait(UploadToken token);
+        bool IsComplete(UploadToken token);
+        // submits anything recorded and waits for everything
+        void Flush();
+
+        uint32_t get_queue_family_index() const;
+        uint32_t get_dst_queue_family_index() const;
+        bool get_transfers_ownership() const;
+        VkQueue get_queue() const;
+    };
+}
@@ -15,6 +15,10 @@ namespace rt {
     struct QueueFamilyIndices {
         std::optional<uint32_t> graphics;
         std::optional<uint32_t> present;
+        // dedicated families that can run alongside graphics,
+        //   left empty when the device doesn't have any
+        std::optional<uint32_t> transfer;
+        std::optional<uint32_t> compute;
 
         bool is_complete() {
             return graphics.has_value() && present.has_value();
@@ -25,10 +29,62 @@ namespace rt {
         VkFormat find_supported_format(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features, VkPhysicalDevice physical_device);
         VkFormat find_depth_format(VkPhysicalDevice physical_device);
         uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties, VkPhysicalDevice physical_device);
+        uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties, const VkPhysicalDeviceMemoryProperties& mem_properties);
         VkCommandBuffer begin_single_use_commands(const GraphicsContext& g_ctx, const ApiContext& a_ctx);
         void end_single_use_commands(VkCommandBuffer command_buffer, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
-        void transition_image_layout(VkImage image, VkFormat format, VkImageLayout prev_layout, VkImageLayout new_layout, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
+        // transitions level_count mip levels starting at base_mip_level, every level by default
+        void transition_image_layout(
+            VkImage image,
+            VkFormat format,
+            VkImageLayout prev_layout,
+            VkImageLayout new_layout,
+            const GraphicsContext& g_ctx,
+            const ApiContext& a_ctx,
+            uint32_t base_mip_level = 0,
+            uint32_t level_count = VK_REMAINING_MIP_LEVELS
+        );
+        void cmd_transition_image_layout(
+            VkCommandBuffer command_buffer,
+            VkImage image,
+            VkFormat format,
+            VkImageLayout prev_layout,
+            VkImageLayout new_layout,
+            uint32_t base_mip_level = 0,
+            uint32_t level_count = VK_REMAINING_MIP_LEVELS
+        );
+        // fills levels 1+ by blitting each level down from the one above it,
+        //   every level must start in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL and
+        //   ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        void cmd_generate_mipmaps(VkCommandBuffer command_buffer, VkImage image, uint32_t width, uint32_t height, uint32_t mip_levels);
         void copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, const GraphicsContext& g_ctx, const ApiContext& a_ctx);
+        void cmd_copy_buffer_to_image(VkCommandBuffer command_buffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+        void cmd_copy_image_to_buffer(VkCommandBuffer command_buffer, VkImage image, VkImageLayout layout, VkBuffer buffer, uint32_t width, uint32_t height);
+        // global memory barrier, enough for buffers on a single queue
+        void cmd_memory_barrier(VkCommandBuffer command_buffer, VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+        void cmd_buffer_barrier(VkCommandBuffer command_buffer, VkBuffer buffer, VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+        // single descriptor writes for compute resources, image
+        //   layout is normally VK_IMAGE_LAYOUT_GENERAL for storage images
+        void write_storage_buffer_descriptor(VkDevice device, VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+        void write_storage_image_descriptor(VkDevice device, VkDescriptorSet set, uint32_t binding, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL);
+        // bytes per texel of uncompressed color and depth/stencil formats,
+        //   throws for block compressed and multi-planar ones
+        uint32_t get_format_texel_size(VkFormat format);
+        // levels needed to go all the way down to 1x1
+        uint32_t get_full_mip_count(uint32_t width, uint32_t height);
+        // bytes per 4x4 block of BC formats, 0 for anything uncompressed
+        uint32_t get_format_block_size(VkFormat format);
+        // bytes of one tightly packed mip level, compressed or not
+        VkDeviceSize get_image_level_size(VkFormat format, uint32_t width, uint32_t height);
+        // smallest valid bufferOffset step when copying into an image of this
+        //   format, the texel or block size rounded up to a multiple of 4
+        VkDeviceSize get_copy_offset_alignment(VkFormat format);
+        // inline so the offline tools can use it without linking vulkan
+        inline uint64_t align_up(uint64_t value, uint64_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+        // 64 bit FNV-1a, fast and fine for keys and catching corrupt files
+        //   but nothing adversarial
+        uint64_t hash_bytes(const void* data, size_t size);
         SwapChainSupportDetails query_swap_chain_support(VkPhysicalDevice device, VkSurfaceKHR surface);
         QueueFamilyIndices find_queue_families(VkPhysicalDevice device, VkSurfaceKHR surface);
         bool check_device_extension_support(VkPhysicalDevice device, const char* const* extensions, uint32_t extension_count);
@@ -2,11 +2,14 @@
 #include <stdexcept>
 #include <cstring>
 #include "vk_utils.h"
+#include "etc/destruction_queue.h"
 
 namespace rt {
     Buffer::Buffer(const BufferCreateInfo& create_info, const ApiContext& a_ctx)
       : device(a_ctx.device),
         mapped(nullptr),
+        allocator(create_info.allocator),
+        retire_queue(create_info.retire_queue),
         size(create_info.size),
         buffer_usage(create_info.usage),
         memory_properties(create_info.properties) {
@@ -22,33 +25,55 @@ namespace rt {
             throw std::runtime_error("Failed to create buffer!");
         }
 
-        VkMemoryRequirements mem_req;
-        vkGetBufferMemoryRequirements(a_ctx.device, buffer, &mem_req);
-
-        VkMemoryAllocateInfo alloc_info {
-            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-            .allocationSize = mem_req.size,
-            .memoryTypeIndex = Utils::find_memory_type(
-                mem_req.memoryTypeBits,
-                create_info.properties,
-                a_ctx.physical_device
-            )
-        };
-
-        if (vkAllocateMemory(a_ctx.device, &alloc_info, nullptr, &device_memory) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to allocate GPU buffer memory!");
+        if (allocator != nullptr) {
+            allocation = allocator->AllocateForBuffer(buffer, create_info.properties);
+        } else {
+            VkMemoryRequirements mem_req;
+            vkGetBufferMemoryRequirements(a_ctx.device, buffer, &mem_req);
+
+            VkMemoryAllocateInfo alloc_info {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .allocationSize = mem_req.size,
+                .memoryTypeIndex = Utils::find_memory_type(
+                    mem_req.memoryTypeBits,
+                    create_info.properties,
+                    a_ctx.physical_device
+                )
+            };
+
+            allocation = {
+                .offset = 0,
+                .size = mem_req.size,
+                .mapped = nullptr,
+                .memory_type = alloc_info.memoryTypeIndex
+            };
+
+            if (vkAllocateMemory(a_ctx.device, &alloc_info, nullptr, &allocation.memory) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate GPU buffer memory!");
+            }
         }
 
-        vkBindBufferMemory(a_ctx.device, buffer, device_memory, 0);
+        vkBindBufferMemory(a_ctx.device, buffer, allocation.memory, allocation.offset);
     }
 
     Buffer::~Buffer() {
-        vkDeviceWaitIdle(device);
-
         Unmap();
 
-        vkDestroyBuffer(device, buffer, nullptr);
-        vkFreeMemory(device, device_memory, nullptr);
+        auto destroy = [device = device, buffer = buffer, allocator = allocator, allocation = allocation] {
+            vkDestroyBuffer(device, buffer, nullptr);
+            if (allocator != nullptr) {
+                allocator->Free(allocation);
+            } else {
+                vkFreeMemory(device, allocation.memory, nullptr);
+            }
+        };
+
+        if (retire_queue != nullptr) {
+            retire_queue->QueueRetire(destroy, allocation.size);
+        } else {
+            vkDeviceWaitIdle(device);
+            destroy();
+        }
     }
 
     void Buffer::CopyFromHostAuto(const void* data, size_t size) {
@@ -76,7 +101,7 @@ namespace rt {
         );
     }
 
-    void Buffer::CopyFromBuffer(const Buffer& src, const GraphicsContext& g_ctx, const ApiContext& a_ctx) {
+    void Buffer::CheckCopyFrom(const Buffer& src) const {
         if ((src.buffer_usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) == 0) {
             throw std::runtime_error("Cannot copy data from a buffer whose usage doesn't include VK_BUFFER_USAGE_TRANSFER_SRC_BIT!");
         }
@@ -84,8 +109,18 @@ namespace rt {
         if ((buffer_usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) == 0) {
             throw std::runtime_error("Cannot copy data into a buffer whose usage doesn't include VK_BUFFER_USAGE_TRANSFER_DST_BIT!");
         }
+    }
+
+    void Buffer::CopyFromBuffer(const Buffer& src, const GraphicsContext& g_ctx, const ApiContext& a_ctx) {
+        CheckCopyFrom(src);
 
         VkCommandBuffer command_buffer = Utils::begin_single_use_commands(g_ctx, a_ctx);
+        CmdCopyFromBuffer(src, command_buffer);
+        Utils::end_single_use_commands(command_buffer, g_ctx, a_ctx);
+    }
+
+    void Buffer::CmdCopyFromBuffer(const Buffer& src, VkCommandBuffer command_buffer) {
+        CheckCopyFrom(src);
 
         VkDeviceSize copy_size = src.size;
         if (copy_size > size) copy_size = size;
@@ -95,25 +130,29 @@ namespace rt {
             .size = copy_size
         };
         vkCmdCopyBuffer(command_buffer, src.buffer, buffer, 1, &copy_region);
-
-        Utils::end_single_use_commands(command_buffer, g_ctx, a_ctx);
     }
 
     void Buffer::Map() {
-        if (mapped == nullptr) {
-            vkMapMemory(device, device_memory, 0, size, 0, &mapped);
-        }
+        Map(0, size);
     }
 
     void Buffer::Map(uint64_t offset, size_t size) {
         if (mapped == nullptr) {
-            vkMapMemory(device, device_memory, offset, size, 0, &mapped);
+            // sub-allocated memory is already persistently mapped by
+            //   the allocator, we just point into it
+            if (allocation.mapped != nullptr) {
+                mapped = static_cast<uint8_t*>(allocation.mapped) + offset;
+            } else {
+                vkMapMemory(device, allocation.memory, allocation.offset + offset, size, 0, &mapped);
+            }
         }
     }
 
     void Buffer::Unmap() {
         if (mapped != nullptr) {
-            vkUnmapMemory(device, device_memory);
+            if (allocation.mapped == nullptr) {
+                vkUnmapMemory(device, allocation.memory);
+            }
             mapped = nullptr;
         }
     }
@@ -126,6 +165,10 @@ namespace rt {
         return size;
     }
 
+    void* Buffer::get_mapped_data() const {
+        return mapped;
+    }
+
     bool Buffer::get_mapped() const {
         return mapped != nullptr;
     }
@@ -0,0 +1,112 @@
+#include "base/compute_pipeline.h"
+#include <stdexcept>
+#include "etc/destruction_queue.h"
+
+namespace rt {
+    ComputePipeline::ComputePipeline(const ComputePipelineCreateInfo& create_info, const ApiContext& a_ctx)
+      : device(a_ctx.device),
+        pipeline_layout(create_info.pipeline_layout),
+        owns_layout(create_info.pipeline_layout == VK_NULL_HANDLE),
+        local_size{create_info.local_size[0], create_info.local_size[1], create_info.local_size[2]},
+        retire_queue(create_info.retire_queue) {
+        if (create_info.shader_stage == nullptr || create_info.shader_stage->stage != VK_SHADER_STAGE_COMPUTE_BIT) {
+            throw std::runtime_error("Compute pipelines need exactly one compute shader stage!");
+        }
+
+        // get_group_count divides by these
+        if (local_size[0] == 0 || local_size[1] == 0 || local_size[2] == 0) {
+            throw std::runtime_error("Compute pipeline local size can't be zero!");
+        }
+
+        if (owns_layout) {
+            if (vkCreatePipelineLayout(a_ctx.device, create_info.layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create pipeline layout!");
+            }
+        }
+
+        VkComputePipelineCreateInfo pipeline_create_info = {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = *create_info.shader_stage,
+            .layout = pipeline_layout
+        };
+
+        if (vkCreateComputePipelines(a_ctx.device, create_info.pipeline_cache, 1, &pipeline_create_info, nullptr, &compute_pipeline) != VK_SUCCESS) {
+            if (owns_layout) {
+                vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+            }
+            throw std::runtime_error("Failed to create compute pipeline!");
+        }
+    }
+
+    ComputePipeline::~ComputePipeline() {
+        auto destroy = [device = device, pipeline_layout = owns_layout ? pipeline_layout : VK_NULL_HANDLE, compute_pipeline = compute_pipeline] {
+            // destroying a null layout is a no-op
+            vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+            vkDestroyPipeline(device, compute_pipeline, nullptr);
+        };
+
+        if (retire_queue != nullptr) {
+            retire_queue->QueueRetire(destroy);
+        } else {
+            vkDeviceWaitIdle(device);
+            destroy();
+        }
+    }
+
+    void ComputePipeline::CmdDispatch(
+        VkCommandBuffer command_buffer,
+        const VkDescriptorSet* descriptor_sets,
+        uint32_t descriptor_set_count,
+        uint32_t group_count_x,
+        uint32_t group_count_y,
+        uint32_t group_count_z
+    ) const {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline);
+        if (descriptor_set_count > 0) {
+            vkCmdBindDescriptorSets(
+                command_buffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                pipeline_layout,
+                0,
+                descriptor_set_count,
+                descriptor_sets,
+                0,
+                nullptr
+            );
+        }
+
+        vkCmdDispatch(command_buffer, group_count_x, group_count_y, group_count_z);
+    }
+
+    void ComputePipeline::CmdDispatchIndirect(
+        VkCommandBuffer command_buffer,
+        const VkDescriptorSet* descriptor_sets,
+        uint32_t descriptor_set_count,
+        VkBuffer buffer,
+        VkDeviceSize offset
+    ) const {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline);
+        if (descriptor_set_count > 0) {
+            vkCmdBindDescriptorSets(
+                command_buffer,
+                VK_PIPELINE_BIND_POINT_COMPUTE,
+                pipeline_layout,
+                0,
+                descriptor_set_count,
+                descriptor_sets,
+                0,
+                nullptr
+            );
+        }
+
+        vkCmdDispatchIndirect(command_buffer, buffer, offset);
+    }
+
+    VkPipelineLayout ComputePipeline::get_layout() const { return pipeline_layout; }
+    VkPipeline ComputePipeline::get_pipeline() const { return compute_pipeline; }
+
+    uint32_t ComputePipeline::get_group_count(uint32_t count, uint32_t axis) const {
+        uint32_t size = local_size.at(axis);
+        return (count + size - 1) / size;
+    }
+}
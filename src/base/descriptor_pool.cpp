@@ -28,5 +28,9 @@ namespace rt {
         vkDestroyDescriptorPool(device, pool, nullptr);
     }
 
+    void DescriptorPool::Reset() {
+        vkResetDescriptorPool(device, pool, 0);
+    }
+
     VkDescriptorPool DescriptorPool::get_pool() { return pool; }
 }
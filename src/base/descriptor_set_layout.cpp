@@ -9,6 +9,7 @@ namespace rt {
     ) : device(a_ctx.device) {
         VkDescriptorSetLayoutCreateInfo layout_info = {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .pNext = create_info.next,
             .flags = create_info.flags,
             .bindingCount = create_info.binding_count,
             .pBindings = create_info.bindings
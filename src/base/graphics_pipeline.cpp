@@ -1,11 +1,17 @@
 #include "base/graphics_pipeline.h"
 #include <stdexcept>
+#include "etc/destruction_queue.h"
 
 namespace rt {
     GraphicsPipeline::GraphicsPipeline(const GraphicsPipelineCreateInfo& create_info, const ApiContext& a_ctx)
-      : device(a_ctx.device) {
-        if (vkCreatePipelineLayout(a_ctx.device, create_info.layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create pipeline layout!");
+      : device(a_ctx.device),
+        pipeline_layout(create_info.pipeline_layout),
+        owns_layout(create_info.pipeline_layout == VK_NULL_HANDLE),
+        retire_queue(create_info.retire_queue) {
+        if (owns_layout) {
+            if (vkCreatePipelineLayout(a_ctx.device, create_info.layout_create_info, nullptr, &pipeline_layout) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create pipeline layout!");
+            }
         }
 
         VkGraphicsPipelineCreateInfo pipeline_create_info = {
@@ -25,16 +31,27 @@ namespace rt {
             .subpass = create_info.subpass_index
         };
 
-        if (vkCreateGraphicsPipelines(a_ctx.device, nullptr, 1, &pipeline_create_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(a_ctx.device, create_info.pipeline_cache, 1, &pipeline_create_info, nullptr, &graphics_pipeline) != VK_SUCCESS) {
+            if (owns_layout) {
+                vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+            }
             throw std::runtime_error("Failed to create graphics pipeline!");
         }
     }
 
     GraphicsPipeline::~GraphicsPipeline() {
-        vkDeviceWaitIdle(device);
+        auto destroy = [device = device, pipeline_layout = owns_layout ? pipeline_layout : VK_NULL_HANDLE, graphics_pipeline = graphics_pipeline] {
+            // destroying a null layout is a no-op
+            vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+            vkDestroyPipeline(device, graphics_pipeline, nullptr);
+        };
 
-        vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
-        vkDestroyPipeline(device, graphics_pipeline, nullptr);
+        if (retire_queue != nullptr) {
+            retire_queue->QueueRetire(destroy);
+        } else {
+            vkDeviceWaitIdle(device);
+            destroy();
+        }
     }
 
     VkPipelineLayout GraphicsPipeline::get_layout() const { return pipeline_layout; }
@@ -1,12 +1,17 @@
 #include "base/image.h"
 
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
 #include "vk_utils.h"
 #include "base/buffer.h"
+#include "etc/upload_context.h"
+#include "etc/staging_ring.h"
+#include "etc/destruction_queue.h"
 
 namespace rt {
-    void Image::CreateImage(const ImageCreateInfo& create_info, const ApiContext& a_ctx) {
-        VkImageCreateInfo image_create_info = {
+    VkImageCreateInfo Image::GetVkCreateInfo(const ImageCreateInfo& create_info, uint32_t mip_levels) {
+        return (VkImageCreateInfo) {
             .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
             .imageType = VK_IMAGE_TYPE_2D,
             .format = create_info.format,
@@ -15,14 +20,19 @@ namespace rt {
                 .height = create_info.height,
                 .depth = 1
             },
-            .mipLevels = 1,
+            .mipLevels = mip_levels,
             .arrayLayers = 1,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .tiling = create_info.tiling,
-            .usage = create_info.image_usage,
+            // every level but the last is blitted from
+            .usage = create_info.image_usage | (mip_levels > 1 ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0u),
             .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
             .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
         };
+    }
+
+    void Image::CreateImage(const ImageCreateInfo& create_info, const ApiContext& a_ctx) {
+        VkImageCreateInfo image_create_info = GetVkCreateInfo(create_info, mip_levels);
         image_layout = image_create_info.initialLayout;
 
         if (vkCreateImage(a_ctx.device, &image_create_info, nullptr, &image) != VK_SUCCESS) {
@@ -33,21 +43,33 @@ namespace rt {
         vkGetImageMemoryRequirements(a_ctx.device, image, &mem_requirements);
         size = mem_requirements.size;
 
-        VkMemoryAllocateInfo alloc_info = {
-            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-            .allocationSize = mem_requirements.size,
-            .memoryTypeIndex = Utils::find_memory_type(
-                mem_requirements.memoryTypeBits,
-                create_info.memory_properties,
-                a_ctx.physical_device
-            )
-        };
+        if (allocator != nullptr) {
+            allocation = allocator->AllocateForImage(image, create_info.memory_properties);
+            size = allocator->get_allocation_size(mem_requirements, true);
+        } else {
+            VkMemoryAllocateInfo alloc_info = {
+                .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                .allocationSize = mem_requirements.size,
+                .memoryTypeIndex = Utils::find_memory_type(
+                    mem_requirements.memoryTypeBits,
+                    create_info.memory_properties,
+                    a_ctx.physical_device
+                )
+            };
+
+            allocation = {
+                .offset = 0,
+                .size = mem_requirements.size,
+                .mapped = nullptr,
+                .memory_type = alloc_info.memoryTypeIndex
+            };
 
-        if (vkAllocateMemory(device, &alloc_info, nullptr, &memory) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to allocate image memory!");
+            if (vkAllocateMemory(device, &alloc_info, nullptr, &allocation.memory) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate image memory!");
+            }
         }
 
-        vkBindImageMemory(device, image, memory, 0);
+        vkBindImageMemory(device, image, allocation.memory, allocation.offset);
     }
 
     void Image::CreateImageView(const ImageCreateInfo& create_info, const ApiContext& a_ctx) {
@@ -59,7 +81,7 @@ namespace rt {
             .subresourceRange = {
                 .aspectMask = create_info.view_aspect_flags,
                 .baseMipLevel = 0,
-                .levelCount = 1,
+                .levelCount = mip_levels,
                 .baseArrayLayer = 0,
                 .layerCount = 1
             },
@@ -72,35 +94,189 @@ namespace rt {
 
     Image::Image(const ImageCreateInfo& create_info, const ApiContext& a_ctx)
       : device(a_ctx.device),
+        allocator(create_info.allocator),
+        retire_queue(create_info.retire_queue),
         image_format(create_info.format),
         width(create_info.width),
-        height(create_info.height) {
+        height(create_info.height),
+        mip_levels(create_info.mip_levels > 0 ? create_info.mip_levels : 1),
+        can_generate_mips(false) {
+        if (mip_levels > Utils::get_full_mip_count(width, height)) {
+            throw std::runtime_error("Image has more mip levels than its size allows!");
+        }
+
+        if (mip_levels > 1) {
+            VkFormatProperties format_properties;
+            vkGetPhysicalDeviceFormatProperties(a_ctx.physical_device, image_format, &format_properties);
+
+            VkFormatFeatureFlags needed = VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                          VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                          VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+            can_generate_mips = (format_properties.optimalTilingFeatures & needed) == needed;
+        }
+
         CreateImage(create_info, a_ctx);
         CreateImageView(create_info, a_ctx);
     }
 
     Image::~Image() {
-        vkDeviceWaitIdle(device);
+        auto destroy = [device = device, image = image, view = view, allocator = allocator, allocation = allocation] {
+            vkDestroyImage(device, image, nullptr);
+            if (allocator != nullptr) {
+                allocator->Free(allocation);
+            } else {
+                vkFreeMemory(device, allocation.memory, nullptr);
+            }
+            vkDestroyImageView(device, view, nullptr);
+        };
 
-        vkDestroyImage(device, image, nullptr);
-        vkFreeMemory(device, memory, nullptr);
-        vkDestroyImageView(device, view, nullptr);
+        if (retire_queue != nullptr) {
+            retire_queue->QueueRetire(destroy, allocation.size);
+        } else {
+            vkDeviceWaitIdle(device);
+            destroy();
+        }
     }
 
     void Image::CopyData(const void* data, const GraphicsContext& g_ctx, const ApiContext& a_ctx) {
+        if (mip_levels > 1 && !can_generate_mips) {
+            throw std::runtime_error("Image format doesn't support generating mipmaps!");
+        }
+
+        VkDeviceSize data_size = get_data_size();
         BufferCreateInfo staging_create_info = {
-            .size = size,
+            .size = data_size,
             .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .allocator = allocator
         };
         Buffer staging_buffer(staging_create_info, a_ctx);
-        staging_buffer.CopyFromHostAuto(data, static_cast<size_t>(size));
+        staging_buffer.CopyFromHostAuto(data, static_cast<size_t>(data_size));
 
         TransitionToLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, g_ctx, a_ctx);
 
         Utils::copy_buffer_to_image(staging_buffer.get_buffer(), image, width, height, g_ctx, a_ctx);
 
-        TransitionToLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, g_ctx, a_ctx);
+        if (mip_levels > 1) {
+            VkCommandBuffer command_buffer = Utils::begin_single_use_commands(g_ctx, a_ctx);
+            CmdGenerateMipmaps(command_buffer);
+            Utils::end_single_use_commands(command_buffer, g_ctx, a_ctx);
+        } else {
+            TransitionToLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, g_ctx, a_ctx);
+        }
+    }
+
+    void Image::CopyData(const void* data, UploadContext& upload, const ApiContext& a_ctx) {
+        // checked before anything goes into the shared batch
+        if (mip_levels > 1 && !can_generate_mips) {
+            throw std::runtime_error("Image format doesn't support generating mipmaps!");
+        }
+
+        VkDeviceSize data_size = get_data_size();
+        BufferCreateInfo staging_create_info = {
+            .size = data_size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .allocator = allocator,
+            // staging buffer has to stay alive until the GPU is done reading it
+            .retire_queue = &upload.get_retire_queue()
+        };
+        Buffer staging_buffer(staging_create_info, a_ctx);
+        staging_buffer.CopyFromHostAuto(data, static_cast<size_t>(data_size));
+
+        VkCommandBuffer command_buffer = upload.AcquireCommandBuffer();
+
+        CmdTransitionToLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, command_buffer);
+        Utils::cmd_copy_buffer_to_image(command_buffer, staging_buffer.get_buffer(), image, width, height);
+        CmdFinishUpload(upload);
+    }
+
+    void Image::CopyData(const void* data, StagingRing& staging) {
+        staging.CopyToImage(data, get_data_size(), *this);
+    }
+
+    void Image::CopyLevels(const ImageLevelData* levels, uint32_t level_count, UploadContext& upload, const ApiContext& a_ctx) {
+        if (level_count != mip_levels) {
+            throw std::runtime_error("Image level count doesn't match its mip levels!");
+        }
+
+        // every level goes into one staging buffer, aligned so every
+        //   level starts on a whole texel or block
+        VkDeviceSize alignment = Utils::get_copy_offset_alignment(image_format);
+        std::vector<VkDeviceSize> offsets(level_count);
+        VkDeviceSize staging_size = 0;
+        for (uint32_t level = 0; level < level_count; level++) {
+            if (levels[level].size != get_level_size(level)) {
+                throw std::runtime_error("Image level data is the wrong size!");
+            }
+
+            offsets[level] = staging_size;
+            staging_size = (staging_size + levels[level].size + alignment - 1) / alignment * alignment;
+        }
+
+        BufferCreateInfo staging_create_info = {
+            .size = staging_size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .allocator = allocator,
+            .retire_queue = &upload.get_retire_queue()
+        };
+        Buffer staging_buffer(staging_create_info, a_ctx);
+
+        std::vector<VkBufferImageCopy> regions(level_count);
+        staging_buffer.Map();
+        for (uint32_t level = 0; level < level_count; level++) {
+            staging_buffer.CopyFromHost(levels[level].data, static_cast<size_t>(levels[level].size), offsets[level]);
+
+            VkExtent2D extent = get_level_extent(level);
+            regions[level] = {
+                .bufferOffset = offsets[level],
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                },
+                .imageOffset = {0, 0, 0},
+                .imageExtent = {extent.width, extent.height, 1}
+            };
+        }
+        staging_buffer.Unmap();
+
+        VkCommandBuffer command_buffer = upload.AcquireCommandBuffer();
+
+        CmdTransitionToLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, command_buffer);
+        vkCmdCopyBufferToImage(
+            command_buffer,
+            staging_buffer.get_buffer(),
+            image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            level_count,
+            regions.data()
+        );
+        CmdFinishUpload(upload, false);
+    }
+
+    void Image::CopyLevels(const ImageLevelData* levels, uint32_t level_count, StagingRing& staging) {
+        if (level_count != mip_levels) {
+            throw std::runtime_error("Image level count doesn't match its mip levels!");
+        }
+
+        // check everything before recording, the batch is shared with
+        //   other uploads so a half recorded copy can't be left in it
+        for (uint32_t level = 0; level < level_count; level++) {
+            if (levels[level].size != get_level_size(level)) {
+                throw std::runtime_error("Image level data is the wrong size!");
+            }
+        }
+
+        CmdTransitionToLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, staging.get_upload_context().AcquireCommandBuffer());
+        for (uint32_t level = 0; level < level_count; level++) {
+            staging.CopyToImageLevel(levels[level].data, levels[level].size, *this, level);
+        }
+        CmdFinishUpload(staging.get_upload_context(), false);
     }
 
     void Image::TransitionToLayout(VkImageLayout layout, const GraphicsContext& g_ctx, const ApiContext& a_ctx) {
@@ -115,9 +291,111 @@ namespace rt {
         image_layout = layout;
     }
 
+    void Image::CmdTransitionToLayout(VkImageLayout layout, VkCommandBuffer command_buffer) {
+        Utils::cmd_transition_image_layout(
+            command_buffer,
+            image,
+            image_format,
+            image_layout,
+            layout
+        );
+        image_layout = layout;
+    }
+
+    void Image::CmdFinishUpload(UploadContext& upload, bool generate_mips) {
+        if (mip_levels > 1 && generate_mips) {
+            if (!can_generate_mips) {
+                throw std::runtime_error("Image format doesn't support generating mipmaps!");
+            }
+
+            // blits need a graphics queue, so the image is handed over
+            //   still in transfer layout and the receiver fills the chain.
+            //   every upload in the batch goes out in the same submit
+            upload.ReleaseImage(
+                image,
+                VK_IMAGE_ASPECT_COLOR_BIT,
+                image_layout,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT
+            );
+            upload.RecordOnReceiver([image = image, width = width, height = height, mip_levels = mip_levels](VkCommandBuffer command_buffer) {
+                Utils::cmd_generate_mipmaps(command_buffer, image, width, height, mip_levels);
+            });
+            image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            return;
+        }
+
+        upload.ReleaseImage(
+            image,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            image_layout,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+        );
+        image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    void Image::CmdGenerateMipmaps(VkCommandBuffer command_buffer) {
+        if (!can_generate_mips) {
+            throw std::runtime_error("Image format doesn't support generating mipmaps!");
+        }
+
+        if (image_layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+            throw std::runtime_error("Image must be a transfer destination to generate mipmaps!");
+        }
+
+        Utils::cmd_generate_mipmaps(command_buffer, image, width, height, mip_levels);
+        image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
     VkImage Image::get_image() const { return image; }
     VkImageView Image::get_view() const { return view; }
     uint32_t Image::get_width() const { return width; }
     uint32_t Image::get_height() const { return height; }
     VkFormat Image::get_format() const { return image_format; }
+    uint32_t Image::get_mip_levels() const { return mip_levels; }
+    bool Image::get_can_generate_mips() const { return can_generate_mips; }
+
+    VkDeviceSize Image::get_memory_size() const { return size; }
+
+    VkDeviceSize Image::QueryMemorySize(const ImageCreateInfo& create_info, const ApiContext& a_ctx) {
+        // a VkImage without memory bound is cheap, and the only way to
+        //   get its requirements on 1.0
+        VkImageCreateInfo image_create_info = GetVkCreateInfo(create_info, create_info.mip_levels > 0 ? create_info.mip_levels : 1);
+
+        VkImage image;
+        if (vkCreateImage(a_ctx.device, &image_create_info, nullptr, &image) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create image!");
+        }
+
+        VkMemoryRequirements mem_requirements;
+        vkGetImageMemoryRequirements(a_ctx.device, image, &mem_requirements);
+        vkDestroyImage(a_ctx.device, image, nullptr);
+
+        if (create_info.allocator != nullptr) {
+            return create_info.allocator->get_allocation_size(mem_requirements, true);
+        }
+
+        return mem_requirements.size;
+    }
+
+    VkDeviceSize Image::get_data_size() const {
+        return get_level_size(0);
+    }
+
+    VkDeviceSize Image::get_level_size(uint32_t level) const {
+        VkExtent2D extent = get_level_extent(level);
+        return Utils::get_image_level_size(image_format, extent.width, extent.height);
+    }
+
+    VkExtent2D Image::get_level_extent(uint32_t level) const {
+        VkExtent2D extent = {
+            .width = std::max(width >> level, 1u),
+            .height = std::max(height >> level, 1u)
+        };
+
+        return extent;
+    }
 }
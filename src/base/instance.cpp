@@ -49,9 +49,13 @@ rt::Instance::Instance(const InstanceCreateInfo& create_info) {
 
     // ~~~ GLFW instance extensions ~~~
 
-    // get GLFW extension
+    // get GLFW extension, headless instances don't present
+    //   anywhere so they don't need any (or GLFW at all)
     uint32_t glfw_extension_count = 0;
-    const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+    const char** glfw_extensions = nullptr;
+    if (!create_info.headless) {
+        glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+    }
 
     // make sure extensions are supported
     uint32_t extension_count = 0;
@@ -0,0 +1,291 @@
+#include "base/memory_allocator.h"
+
+#include <stdexcept>
+#include <bit>
+#include <algorithm>
+#include "vk_utils.h"
+
+namespace rt {
+    MemoryAllocator::MemoryAllocator(const MemoryAllocatorCreateInfo& create_info, const ApiContext& a_ctx)
+      : device(a_ctx.device),
+        block_size(create_info.block_size != 0 ? create_info.block_size : 64 * 1024 * 1024),
+        min_allocation_size(create_info.min_allocation_size != 0 ? create_info.min_allocation_size : 256) {
+        if (!std::has_single_bit(block_size) || !std::has_single_bit(min_allocation_size)) {
+            throw std::runtime_error("Memory allocator block and minimum allocation sizes must be powers of two!");
+        }
+
+        if (min_allocation_size > block_size) {
+            throw std::runtime_error("Memory allocator minimum allocation size cannot be larger than block size!");
+        }
+
+        max_order = static_cast<uint32_t>(std::countr_zero(block_size) - std::countr_zero(min_allocation_size));
+
+        vkGetPhysicalDeviceMemoryProperties(a_ctx.physical_device, &memory_properties);
+        heap_stats.resize(memory_properties.memoryHeapCount, MemoryHeapStats {});
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(a_ctx.physical_device, &properties);
+        buffer_image_granularity = properties.limits.bufferImageGranularity;
+    }
+
+    MemoryAllocator::~MemoryAllocator() {
+        for (uint32_t i = 0; i < blocks.size(); i++) {
+            if (blocks[i] != nullptr) {
+                DestroyBlock(i);
+            }
+        }
+    }
+
+    uint32_t MemoryAllocator::CreateBlock(uint32_t memory_type) {
+        auto block = std::make_unique<Block>();
+        block->memory_type = memory_type;
+        block->mapped = nullptr;
+        block->allocation_count = 0;
+
+        VkMemoryAllocateInfo alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = block_size,
+            .memoryTypeIndex = memory_type
+        };
+
+        if (vkAllocateMemory(device, &alloc_info, nullptr, &block->memory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate memory allocator block!");
+        }
+
+        // host visible blocks stay mapped for their whole lifetime
+        if ((memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+            vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped);
+        }
+
+        // whole block starts out as one big free chunk of the highest order
+        block->free_lists.resize(max_order + 1);
+        block->free_lists[max_order].insert(0);
+
+        MemoryHeapStats& stats = heap_stats[memory_properties.memoryTypes[memory_type].heapIndex];
+        stats.block_count++;
+        stats.allocated_bytes += block_size;
+
+        // reuse empty slots so block ids stay small
+        for (uint32_t i = 0; i < blocks.size(); i++) {
+            if (blocks[i] == nullptr) {
+                blocks[i] = std::move(block);
+                return i;
+            }
+        }
+
+        blocks.push_back(std::move(block));
+        return static_cast<uint32_t>(blocks.size() - 1);
+    }
+
+    void MemoryAllocator::DestroyBlock(uint32_t block_id) {
+        Block& block = *blocks[block_id];
+
+        MemoryHeapStats& stats = heap_stats[memory_properties.memoryTypes[block.memory_type].heapIndex];
+        stats.block_count--;
+        stats.allocated_bytes -= block_size;
+
+        if (block.mapped != nullptr) {
+            vkUnmapMemory(device, block.memory);
+        }
+        vkFreeMemory(device, block.memory, nullptr);
+
+        blocks[block_id].reset();
+    }
+
+    bool MemoryAllocator::AllocateFromBlock(Block& block, uint32_t order, VkDeviceSize* out_offset) {
+        // find the smallest free chunk that can fit this order
+        uint32_t found = order;
+        while (found <= max_order && block.free_lists[found].empty()) {
+            found++;
+        }
+
+        if (found > max_order) {
+            return false;
+        }
+
+        VkDeviceSize offset = *block.free_lists[found].begin();
+        block.free_lists[found].erase(block.free_lists[found].begin());
+
+        // split it in half until it's the size we want, the upper
+        //   half of every split goes back into the free lists
+        while (found > order) {
+            found--;
+            block.free_lists[found].insert(offset + (min_allocation_size << found));
+        }
+
+        *out_offset = offset;
+        return true;
+    }
+
+    MemoryAllocation MemoryAllocator::AllocateDedicated(VkDeviceSize size, uint32_t memory_type) {
+        MemoryAllocation allocation = {
+            .offset = 0,
+            .size = size,
+            .mapped = nullptr,
+            .memory_type = memory_type,
+            .block_id = DEDICATED_BLOCK,
+            .order = 0
+        };
+
+        VkMemoryAllocateInfo alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+            .allocationSize = size,
+            .memoryTypeIndex = memory_type
+        };
+
+        if (vkAllocateMemory(device, &alloc_info, nullptr, &allocation.memory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate dedicated device memory!");
+        }
+
+        if ((memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+            vkMapMemory(device, allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.mapped);
+        }
+
+        MemoryHeapStats& stats = heap_stats[memory_properties.memoryTypes[memory_type].heapIndex];
+        stats.dedicated_allocation_count++;
+        stats.allocated_bytes += size;
+        stats.used_bytes += size;
+
+        return allocation;
+    }
+
+    VkDeviceSize MemoryAllocator::GetChunkSize(const VkMemoryRequirements& requirements, bool optimal_image) const {
+        // buddy chunks are naturally aligned to their own size, so
+        //   rounding up to the alignment takes care of it for free.
+        //   optimal images also take up whole granularity pages so
+        //   they never share one with a linear resource
+        VkDeviceSize needed = std::max({requirements.size, requirements.alignment, min_allocation_size});
+        if (optimal_image) {
+            needed = std::max(needed, buffer_image_granularity);
+        }
+
+        return std::bit_ceil(needed);
+    }
+
+    MemoryAllocation MemoryAllocator::Allocate(
+        const VkMemoryRequirements& requirements,
+        VkMemoryPropertyFlags properties,
+        bool optimal_image
+    ) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        uint32_t memory_type = Utils::find_memory_type(
+            requirements.memoryTypeBits,
+            properties,
+            memory_properties
+        );
+
+        VkDeviceSize needed = GetChunkSize(requirements, optimal_image);
+        if (needed > block_size) {
+            return AllocateDedicated(requirements.size, memory_type);
+        }
+
+        uint32_t order = static_cast<uint32_t>(std::countr_zero(needed) - std::countr_zero(min_allocation_size));
+
+        // try existing blocks first, then make a new one
+        VkDeviceSize offset = 0;
+        uint32_t block_id = DEDICATED_BLOCK;
+        for (uint32_t i = 0; i < blocks.size(); i++) {
+            if (blocks[i] != nullptr && blocks[i]->memory_type == memory_type && AllocateFromBlock(*blocks[i], order, &offset)) {
+                block_id = i;
+                break;
+            }
+        }
+
+        if (block_id == DEDICATED_BLOCK) {
+            block_id = CreateBlock(memory_type);
+            AllocateFromBlock(*blocks[block_id], order, &offset);
+        }
+
+        Block& block = *blocks[block_id];
+        block.allocation_count++;
+
+        MemoryHeapStats& stats = heap_stats[memory_properties.memoryTypes[memory_type].heapIndex];
+        stats.allocation_count++;
+        stats.used_bytes += needed;
+
+        return (MemoryAllocation) {
+            .memory = block.memory,
+            .offset = offset,
+            .size = requirements.size,
+            .mapped = block.mapped != nullptr ? static_cast<uint8_t*>(block.mapped) + offset : nullptr,
+            .memory_type = memory_type,
+            .block_id = block_id,
+            .order = order
+        };
+    }
+
+    MemoryAllocation MemoryAllocator::AllocateForBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties) {
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(device, buffer, &requirements);
+        return Allocate(requirements, properties, false);
+    }
+
+    MemoryAllocation MemoryAllocator::AllocateForImage(VkImage image, VkMemoryPropertyFlags properties) {
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, image, &requirements);
+        return Allocate(requirements, properties, true);
+    }
+
+    void MemoryAllocator::Free(const MemoryAllocation& allocation) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        MemoryHeapStats& stats = heap_stats[memory_properties.memoryTypes[allocation.memory_type].heapIndex];
+
+        if (allocation.block_id == DEDICATED_BLOCK) {
+            if (allocation.mapped != nullptr) {
+                vkUnmapMemory(device, allocation.memory);
+            }
+            vkFreeMemory(device, allocation.memory, nullptr);
+
+            stats.dedicated_allocation_count--;
+            stats.allocated_bytes -= allocation.size;
+            stats.used_bytes -= allocation.size;
+            return;
+        }
+
+        Block& block = *blocks[allocation.block_id];
+        block.allocation_count--;
+        stats.allocation_count--;
+        stats.used_bytes -= min_allocation_size << allocation.order;
+
+        // merge with our buddy for as long as it's free too
+        VkDeviceSize offset = allocation.offset;
+        uint32_t order = allocation.order;
+        while (order < max_order) {
+            VkDeviceSize buddy = offset ^ (min_allocation_size << order);
+            auto it = block.free_lists[order].find(buddy);
+            if (it == block.free_lists[order].end()) {
+                break;
+            }
+
+            block.free_lists[order].erase(it);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        block.free_lists[order].insert(offset);
+
+        // give empty blocks back to the driver, but keep the last
+        //   one of each memory type around so we don't thrash
+        if (block.allocation_count == 0) {
+            for (uint32_t i = 0; i < blocks.size(); i++) {
+                if (i != allocation.block_id && blocks[i] != nullptr && blocks[i]->memory_type == block.memory_type) {
+                    DestroyBlock(allocation.block_id);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<MemoryHeapStats> MemoryAllocator::get_heap_stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return heap_stats;
+    }
+
+    VkDeviceSize MemoryAllocator::get_allocation_size(const VkMemoryRequirements& requirements, bool optimal_image) const {
+        VkDeviceSize needed = GetChunkSize(requirements, optimal_image);
+        return needed > block_size ? requirements.size : needed;
+    }
+
+    VkDeviceSize MemoryAllocator::get_block_size() const { return block_size; }
+}
@@ -0,0 +1,142 @@
+#include "base/pipeline_cache.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <cstring>
+#include "vk_utils.h"
+
+// "RTPC" in little endian
+constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x43505452;
+
+namespace rt {
+    PipelineCache::PipelineCache(const PipelineCacheCreateInfo& create_info, const ApiContext& a_ctx)
+      : device(a_ctx.device),
+        path(create_info.path != nullptr ? create_info.path : ""),
+        loaded_from_disk(false) {
+        vkGetPhysicalDeviceProperties(a_ctx.physical_device, &properties);
+
+        // ~~~ try to load existing cache data ~~~
+
+        std::string data;
+        if (!path.empty() && std::filesystem::exists(path)) {
+            uintmax_t file_size = std::filesystem::file_size(path);
+            std::ifstream file(path, std::ios::binary);
+            FileHeader header;
+
+            // check the size before trusting it so garbage files can't
+            //   make us allocate something huge
+            if (
+                file.is_open() &&
+                file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+                header.magic == PIPELINE_CACHE_MAGIC &&
+                header.data_size == file_size - sizeof(header)
+            ) {
+                data.resize(header.data_size);
+                file.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+                if (!file || !ValidateData(header, data)) {
+                    data.clear();
+                }
+            }
+        }
+        loaded_from_disk = !data.empty();
+
+        // ~~~ create cache itself ~~~
+
+        VkPipelineCacheCreateInfo cache_info = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .initialDataSize = data.size(),
+            .pInitialData = data.empty() ? nullptr : data.data()
+        };
+
+        if (vkCreatePipelineCache(device, &cache_info, nullptr, &cache) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline cache!");
+        }
+    }
+
+    PipelineCache::~PipelineCache() {
+        if (!path.empty()) {
+            // failing to save just means a cold start next time,
+            //   not worth throwing out of a destructor over
+            try {
+                Save();
+            } catch (const std::exception&) { }
+        }
+
+        vkDestroyPipelineCache(device, cache, nullptr);
+    }
+
+    bool PipelineCache::ValidateData(const FileHeader& header, const std::string& data) const {
+        if (
+            header.magic != PIPELINE_CACHE_MAGIC ||
+            header.vendor_id != properties.vendorID ||
+            header.device_id != properties.deviceID ||
+            header.driver_version != properties.driverVersion ||
+            memcmp(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+            header.data_hash != Utils::hash_bytes(data.data(), data.size())
+        ) {
+            return false;
+        }
+
+        // the driver's own header should agree with ours too
+        VkPipelineCacheHeaderVersionOne driver_header;
+        if (data.size() < sizeof(driver_header)) {
+            return false;
+        }
+        memcpy(&driver_header, data.data(), sizeof(driver_header));
+
+        return driver_header.headerSize >= sizeof(driver_header) &&
+               driver_header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               driver_header.vendorID == properties.vendorID &&
+               driver_header.deviceID == properties.deviceID &&
+               memcmp(driver_header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void PipelineCache::Save() {
+        if (path.empty()) {
+            throw std::runtime_error("Cannot save a pipeline cache that wasn't given a path!");
+        }
+
+        size_t data_size = 0;
+        vkGetPipelineCacheData(device, cache, &data_size, nullptr);
+        std::vector<char> data(data_size);
+        vkGetPipelineCacheData(device, cache, &data_size, data.data());
+
+        FileHeader header = {
+            .magic = PIPELINE_CACHE_MAGIC,
+            .vendor_id = properties.vendorID,
+            .device_id = properties.deviceID,
+            .driver_version = properties.driverVersion,
+            .data_size = data_size,
+            .data_hash = Utils::hash_bytes(data.data(), data_size)
+        };
+        memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+        // write to a temp file and swap it in so a crash
+        //   mid-write never leaves a half written cache behind
+        std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open pipeline cache file for writing: " + temp_path);
+            }
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(data.data(), static_cast<std::streamsize>(data_size));
+            file.close();
+
+            // a short write (full disk) must not replace a good cache
+            if (!file.good()) {
+                std::filesystem::remove(temp_path);
+                throw std::runtime_error("Failed to write pipeline cache file: " + temp_path);
+            }
+        }
+
+        std::filesystem::rename(temp_path, path);
+    }
+
+    VkPipelineCache PipelineCache::get_cache() const { return cache; }
+    bool PipelineCache::get_loaded_from_disk() const { return loaded_from_disk; }
+}
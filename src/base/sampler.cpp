@@ -26,8 +26,8 @@ namespace rt {
             .compareEnable = VK_TRUE,
             .compareOp = VK_COMPARE_OP_ALWAYS,
 
-            .minLod = 0.0f,
-            .maxLod = 0.0f,
+            .minLod = create_info.min_lod,
+            .maxLod = create_info.max_lod,
 
             .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
             .unnormalizedCoordinates = VK_FALSE,
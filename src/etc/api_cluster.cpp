@@ -10,13 +10,26 @@ const std::vector<const char*> DEVICE_EXTENSIONS = {
 
 namespace rt {
     ApiCluster::ApiCluster(const ApiClusterCreateInfo& create_info)
-      : window(create_info.window) {
+      : physical_device(nullptr),
+        surface(nullptr),
+        window(create_info.window),
+        headless(create_info.window == nullptr) {
         // create instance
-        instance = std::make_unique<Instance>(create_info.instance);
+        InstanceCreateInfo instance_info = create_info.instance;
+        instance_info.headless = instance_info.headless || headless;
+        instance = std::make_unique<Instance>(instance_info);
 
         // create window surface
-        if (glfwCreateWindowSurface(instance->get_instance(), window, nullptr, &surface) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create window surface!");
+        if (!headless) {
+            if (glfwCreateWindowSurface(instance->get_instance(), window, nullptr, &surface) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create window surface!");
+            }
+        }
+
+        // nothing gets presented without a surface
+        std::vector<const char*> device_extensions;
+        if (!headless) {
+            device_extensions = DEVICE_EXTENSIONS;
         }
 
         // pick physical device
@@ -32,7 +45,7 @@ namespace rt {
             vkEnumeratePhysicalDevices(instance->get_instance(), &device_count, devices.data());
 
             for (const auto& device : devices) {
-                if (Utils::is_device_suitable(device, surface, DEVICE_EXTENSIONS.data(), DEVICE_EXTENSIONS.size())) {
+                if (Utils::is_device_suitable(device, surface, device_extensions.data(), device_extensions.size())) {
                     physical_device = device;
                     break;
                 }
@@ -45,14 +58,20 @@ namespace rt {
 
         // create logical device
         {
-            QueueFamilyIndices indices = Utils::find_queue_families(physical_device, surface);
+            queue_families = Utils::find_queue_families(physical_device, surface);
 
             std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
             // we use a set so we dont have duplicate indices <3
             std::set<uint32_t> unique_queue_families = {
-                indices.graphics.value(),
-                indices.present.value()
+                queue_families.graphics.value(),
+                queue_families.present.value()
             };
+            if (queue_families.transfer.has_value()) {
+                unique_queue_families.insert(queue_families.transfer.value());
+            }
+            if (queue_families.compute.has_value()) {
+                unique_queue_families.insert(queue_families.compute.value());
+            }
 
             // priorities are used to influence scheduling order, inchresting
             float queue_priority = 1.0f;
@@ -67,18 +86,61 @@ namespace rt {
                 queue_create_infos.push_back(queue_create_info);
             }
 
-            VkPhysicalDeviceFeatures device_features = {
+            VkPhysicalDeviceFeatures supported_features;
+            vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
+
+            // indirect drawing features are optional, draw lists fall
+            //   back to one indirect draw per command without them
+            features = {
+                .multiDrawIndirect = supported_features.multiDrawIndirect,
+                .drawIndirectFirstInstance = supported_features.drawIndirectFirstInstance,
                 .samplerAnisotropy = VK_TRUE
             };
 
+            // turn on whichever optional 1.2 features the device has,
+            //   other systems check get_vulkan_12_features() before use
+            features_12 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+            };
+
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+            bool supports_12 = create_info.instance.api_version >= VK_API_VERSION_1_2 &&
+                               properties.apiVersion >= VK_API_VERSION_1_2;
+            if (supports_12) {
+                VkPhysicalDeviceVulkan12Features supported_12 = {
+                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+                };
+                VkPhysicalDeviceFeatures2 supported = {
+                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                    .pNext = &supported_12
+                };
+                vkGetPhysicalDeviceFeatures2(physical_device, &supported);
+
+                features_12.timelineSemaphore = supported_12.timelineSemaphore;
+                features_12.drawIndirectCount = supported_12.drawIndirectCount;
+
+                // descriptor indexing, see BindlessHeap::is_supported
+                features_12.descriptorIndexing = supported_12.descriptorIndexing;
+                features_12.shaderSampledImageArrayNonUniformIndexing = supported_12.shaderSampledImageArrayNonUniformIndexing;
+                features_12.shaderStorageBufferArrayNonUniformIndexing = supported_12.shaderStorageBufferArrayNonUniformIndexing;
+                features_12.descriptorBindingSampledImageUpdateAfterBind = supported_12.descriptorBindingSampledImageUpdateAfterBind;
+                features_12.descriptorBindingStorageBufferUpdateAfterBind = supported_12.descriptorBindingStorageBufferUpdateAfterBind;
+                features_12.descriptorBindingUpdateUnusedWhilePending = supported_12.descriptorBindingUpdateUnusedWhilePending;
+                features_12.descriptorBindingPartiallyBound = supported_12.descriptorBindingPartiallyBound;
+                features_12.runtimeDescriptorArray = supported_12.runtimeDescriptorArray;
+            }
+
             VkDeviceCreateInfo device_create_info = {
                 .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                .pNext = supports_12 ? &features_12 : nullptr,
                 .queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size()),
                 .pQueueCreateInfos = queue_create_infos.data(),
                 .enabledLayerCount = 0,
-                .enabledExtensionCount = static_cast<uint32_t>(DEVICE_EXTENSIONS.size()),
-                .ppEnabledExtensionNames = DEVICE_EXTENSIONS.data(),
-                .pEnabledFeatures = &device_features,
+                .enabledExtensionCount = static_cast<uint32_t>(device_extensions.size()),
+                .ppEnabledExtensionNames = device_extensions.data(),
+                .pEnabledFeatures = &features,
             };
 
             // we don't rlly need this with newer versions of vulkan since
@@ -90,14 +152,27 @@ namespace rt {
             if (vkCreateDevice(physical_device, &device_create_info, nullptr, &device) != VK_SUCCESS) {
                 throw std::runtime_error("Failed to create logical device!");
             }
+
+            features_12.pNext = nullptr;
+        }
+
+        // create pipeline cache
+        {
+            PipelineCacheCreateInfo cache_info = {
+                .path = create_info.pipeline_cache_path
+            };
+            pipeline_cache = std::make_unique<PipelineCache>(cache_info, get_api_context());
         }
     }
 
     ApiCluster::~ApiCluster() {
         vkDeviceWaitIdle(device);
 
+        pipeline_cache.reset();
         vkDestroyDevice(device, nullptr);
-        vkDestroySurfaceKHR(instance->get_instance(), surface, nullptr);
+        if (!headless) {
+            vkDestroySurfaceKHR(instance->get_instance(), surface, nullptr);
+        }
         instance.reset();
     }
 
@@ -106,6 +181,7 @@ namespace rt {
     VkDevice ApiCluster::get_device() const { return device; }
     VkSurfaceKHR ApiCluster::get_surface() const { return surface; }
     GLFWwindow* ApiCluster::get_window() const { return window; }
+    bool ApiCluster::is_headless() const { return headless; }
     ApiContext ApiCluster::get_api_context() const {
         return (ApiContext) {
             .instance = instance->get_instance(),
@@ -116,8 +192,26 @@ namespace rt {
         };
     }
     void ApiCluster::get_queues(VkQueue* out_graphics_queue, VkQueue* out_present_queue) const {
-        QueueFamilyIndices indices = Utils::find_queue_families(physical_device, surface);
-        vkGetDeviceQueue(device, indices.graphics.value(), 0, out_graphics_queue);
-        vkGetDeviceQueue(device, indices.present.value(), 0, out_present_queue);
+        vkGetDeviceQueue(device, queue_families.graphics.value(), 0, out_graphics_queue);
+        vkGetDeviceQueue(device, queue_families.present.value(), 0, out_present_queue);
+    }
+    const QueueFamilyIndices& ApiCluster::get_queue_families() const { return queue_families; }
+    VkQueue ApiCluster::get_transfer_queue() const {
+        VkQueue queue = nullptr;
+        if (queue_families.transfer.has_value()) {
+            vkGetDeviceQueue(device, queue_families.transfer.value(), 0, &queue);
+        }
+        return queue;
+    }
+    VkQueue ApiCluster::get_compute_queue() const {
+        VkQueue queue = nullptr;
+        if (queue_families.compute.has_value()) {
+            vkGetDeviceQueue(device, queue_families.compute.value(), 0, &queue);
+        }
+        return queue;
     }
+    const VkPhysicalDeviceFeatures& ApiCluster::get_features() const { return features; }
+    const VkPhysicalDeviceVulkan12Features& ApiCluster::get_vulkan_12_features() const { return features_12; }
+    VkPipelineCache ApiCluster::get_pipeline_cache() const { return pipeline_cache->get_cache(); }
+    void ApiCluster::SavePipelineCache() { pipeline_cache->Save(); }
 }
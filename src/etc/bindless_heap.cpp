@@ -0,0 +1,268 @@
+#include "etc/bindless_heap.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+
+namespace rt {
+    BindlessHeap::BindlessHeap(const BindlessHeapCreateInfo& create_info, const ApiContext& a_ctx)
+      : device(a_ctx.device),
+        retire_queue(create_info.retire_queue),
+        image_count(0),
+        sampler_count(0),
+        buffer_count(0),
+        free_lists(std::make_shared<FreeLists>()) {
+        // ~~~ check features ~~~
+
+        // supported isn't enough, the features have to be enabled on the
+        //   device, which ApiCluster does whenever the device has them
+        if (create_info.features == nullptr || !is_supported(*create_info.features)) {
+            throw std::runtime_error("Bindless descriptors are not enabled!");
+        }
+
+        // ~~~ clamp capacities ~~~
+
+        // the update after bind limits are only reported through the 1.2
+        //   properties. enabled 1.2 features imply a 1.2 device, but the
+        //   features come from the caller so check before chaining them
+        VkPhysicalDeviceProperties device_properties;
+        vkGetPhysicalDeviceProperties(a_ctx.physical_device, &device_properties);
+        if (device_properties.apiVersion < VK_API_VERSION_1_2) {
+            throw std::runtime_error("Bindless descriptors need a Vulkan 1.2 device!");
+        }
+
+        VkPhysicalDeviceVulkan12Properties properties_12 = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES
+        };
+        VkPhysicalDeviceProperties2 properties = {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &properties_12
+        };
+        vkGetPhysicalDeviceProperties2(a_ctx.physical_device, &properties);
+
+        // every binding is visible to all stages, so the per stage
+        //   limits apply as well. empty arrays aren't allowed in the pool
+        max_images = std::clamp(create_info.max_images, 1u, std::min(
+            properties_12.maxDescriptorSetUpdateAfterBindSampledImages,
+            properties_12.maxPerStageDescriptorUpdateAfterBindSampledImages
+        ));
+        max_samplers = std::clamp(create_info.max_samplers, 1u, std::min(
+            properties_12.maxDescriptorSetUpdateAfterBindSamplers,
+            properties_12.maxPerStageDescriptorUpdateAfterBindSamplers
+        ));
+        max_buffers = std::clamp(create_info.max_buffers, 1u, std::min(
+            properties_12.maxDescriptorSetUpdateAfterBindStorageBuffers,
+            properties_12.maxPerStageDescriptorUpdateAfterBindStorageBuffers
+        ));
+
+        // ~~~ create layout ~~~
+
+        std::array<VkDescriptorSetLayoutBinding, 3> bindings = {{
+            {
+                .binding = BINDLESS_IMAGE_BINDING,
+                .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                .descriptorCount = max_images,
+                .stageFlags = VK_SHADER_STAGE_ALL,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = BINDLESS_SAMPLER_BINDING,
+                .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                .descriptorCount = max_samplers,
+                .stageFlags = VK_SHADER_STAGE_ALL,
+                .pImmutableSamplers = nullptr
+            },
+            {
+                .binding = BINDLESS_BUFFER_BINDING,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = max_buffers,
+                .stageFlags = VK_SHADER_STAGE_ALL,
+                .pImmutableSamplers = nullptr
+            }
+        }};
+
+        // unused slots are never written, and slots that no pending
+        //   frame reads can be written while the set is bound
+        VkDescriptorBindingFlags binding_flag =
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        std::array<VkDescriptorBindingFlags, 3> binding_flags = {binding_flag, binding_flag, binding_flag};
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            .bindingCount = static_cast<uint32_t>(binding_flags.size()),
+            .pBindingFlags = binding_flags.data()
+        };
+
+        DescriptorSetLayoutCreateInfo layout_info = {
+            .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+            .bindings = bindings.data(),
+            .binding_count = static_cast<uint32_t>(bindings.size()),
+            .next = &flags_info
+        };
+        layout = std::make_unique<DescriptorSetLayout>(layout_info, a_ctx);
+
+        // ~~~ create pool & set ~~~
+
+        std::array<VkDescriptorPoolSize, 3> pool_sizes = {{
+            {.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, .descriptorCount = max_images},
+            {.type = VK_DESCRIPTOR_TYPE_SAMPLER, .descriptorCount = max_samplers},
+            {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = max_buffers}
+        }};
+
+        DescriptorPoolCreateInfo pool_info = {
+            .max_sets = 1,
+            .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+            .pool_sizes = pool_sizes.data(),
+            .pool_size_count = static_cast<uint32_t>(pool_sizes.size())
+        };
+        pool = std::make_unique<DescriptorPool>(pool_info, a_ctx);
+
+        VkDescriptorSetLayout set_layout = layout->get_layout();
+        VkDescriptorSetAllocateInfo alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = pool->get_pool(),
+            .descriptorSetCount = 1,
+            .pSetLayouts = &set_layout
+        };
+        if (vkAllocateDescriptorSets(device, &alloc_info, &set) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate bindless descriptor set!");
+        }
+    }
+
+    // the set goes away with its pool
+    BindlessHeap::~BindlessHeap() { }
+
+    bool BindlessHeap::is_supported(const VkPhysicalDeviceVulkan12Features& features) {
+        return features.descriptorIndexing &&
+               features.shaderSampledImageArrayNonUniformIndexing &&
+               features.shaderStorageBufferArrayNonUniformIndexing &&
+               features.descriptorBindingSampledImageUpdateAfterBind &&
+               features.descriptorBindingStorageBufferUpdateAfterBind &&
+               features.descriptorBindingUpdateUnusedWhilePending &&
+               features.descriptorBindingPartiallyBound &&
+               features.runtimeDescriptorArray;
+    }
+
+    BindlessIndex BindlessHeap::Allocate(std::vector<BindlessIndex>& free_list, uint32_t* count, uint32_t max, const char* error) {
+        if (!free_list.empty()) {
+            BindlessIndex index = free_list.back();
+            free_list.pop_back();
+            return index;
+        }
+
+        if (*count >= max) {
+            throw std::runtime_error(error);
+        }
+
+        return (*count)++;
+    }
+
+    void BindlessHeap::Release(std::vector<BindlessIndex> FreeLists::* list, BindlessIndex index) {
+        auto release = [weak_lists = std::weak_ptr<FreeLists>(free_lists), list, index] {
+            // the heap already went away
+            if (auto lists = weak_lists.lock()) {
+                ((*lists).*list).push_back(index);
+            }
+        };
+
+        if (retire_queue != nullptr) {
+            retire_queue->QueueRetire(release);
+        } else {
+            release();
+        }
+    }
+
+    void BindlessHeap::Write(
+        uint32_t binding,
+        BindlessIndex index,
+        VkDescriptorType type,
+        const VkDescriptorImageInfo* image_info,
+        const VkDescriptorBufferInfo* buffer_info
+    ) {
+        VkWriteDescriptorSet write = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = set,
+            .dstBinding = binding,
+            .dstArrayElement = index,
+            .descriptorCount = 1,
+            .descriptorType = type,
+            .pImageInfo = image_info,
+            .pBufferInfo = buffer_info,
+            .pTexelBufferView = nullptr,
+        };
+
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+
+    // ~~~ register ~~~
+
+    BindlessIndex BindlessHeap::RegisterImage(VkImageView view, VkImageLayout image_layout) {
+        BindlessIndex index = Allocate(free_lists->images, &image_count, max_images, "Bindless heap is out of image slots!");
+        UpdateImage(index, view, image_layout);
+        return index;
+    }
+
+    BindlessIndex BindlessHeap::RegisterSampler(VkSampler sampler) {
+        BindlessIndex index = Allocate(free_lists->samplers, &sampler_count, max_samplers, "Bindless heap is out of sampler slots!");
+        UpdateSampler(index, sampler);
+        return index;
+    }
+
+    BindlessIndex BindlessHeap::RegisterBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+        BindlessIndex index = Allocate(free_lists->buffers, &buffer_count, max_buffers, "Bindless heap is out of buffer slots!");
+        UpdateBuffer(index, buffer, offset, range);
+        return index;
+    }
+
+    // ~~~ update ~~~
+
+    void BindlessHeap::UpdateImage(BindlessIndex index, VkImageView view, VkImageLayout image_layout) {
+        VkDescriptorImageInfo image_info = {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = view,
+            .imageLayout = image_layout
+        };
+        Write(BINDLESS_IMAGE_BINDING, index, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, &image_info, nullptr);
+    }
+
+    void BindlessHeap::UpdateSampler(BindlessIndex index, VkSampler sampler) {
+        VkDescriptorImageInfo image_info = {
+            .sampler = sampler,
+            .imageView = VK_NULL_HANDLE,
+            .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+        Write(BINDLESS_SAMPLER_BINDING, index, VK_DESCRIPTOR_TYPE_SAMPLER, &image_info, nullptr);
+    }
+
+    void BindlessHeap::UpdateBuffer(BindlessIndex index, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+        VkDescriptorBufferInfo buffer_info = {
+            .buffer = buffer,
+            .offset = offset,
+            .range = range
+        };
+        Write(BINDLESS_BUFFER_BINDING, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &buffer_info);
+    }
+
+    // ~~~ release ~~~
+
+    void BindlessHeap::ReleaseImage(BindlessIndex index) { Release(&FreeLists::images, index); }
+    void BindlessHeap::ReleaseSampler(BindlessIndex index) { Release(&FreeLists::samplers, index); }
+    void BindlessHeap::ReleaseBuffer(BindlessIndex index) { Release(&FreeLists::buffers, index); }
+
+    void BindlessHeap::CmdBind(
+        VkCommandBuffer command_buffer,
+        VkPipelineLayout pipeline_layout,
+        VkPipelineBindPoint bind_point,
+        uint32_t set_index
+    ) const {
+        vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout, set_index, 1, &set, 0, nullptr);
+    }
+
+    VkDescriptorSetLayout BindlessHeap::get_layout() const { return layout->get_layout(); }
+    VkDescriptorSet BindlessHeap::get_set() const { return set; }
+    uint32_t BindlessHeap::get_max_images() const { return max_images; }
+    uint32_t BindlessHeap::get_max_samplers() const { return max_samplers; }
+    uint32_t BindlessHeap::get_max_buffers() const { return max_buffers; }
+}
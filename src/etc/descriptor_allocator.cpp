@@ -0,0 +1,210 @@
+#include "etc/descriptor_allocator.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace rt {
+    constexpr uint32_t DEFAULT_INITIAL_SETS = 64;
+    constexpr uint32_t DEFAULT_MAX_SETS_PER_POOL = 4096;
+
+    static const DescriptorTypeRatio DEFAULT_RATIOS[] = {
+        {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .ratio = 2.0f},
+        {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, .ratio = 1.0f},
+        {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .ratio = 2.0f},
+        {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .ratio = 4.0f},
+        {.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, .ratio = 1.0f},
+        {.type = VK_DESCRIPTOR_TYPE_SAMPLER, .ratio = 1.0f},
+        {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .ratio = 1.0f}
+    };
+
+    static bool is_image_type(VkDescriptorType type) {
+        switch (type) {
+            case VK_DESCRIPTOR_TYPE_SAMPLER:
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    template <typename T>
+    static void append_key(std::string& key, const T& value) {
+        key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    DescriptorAllocator::DescriptorAllocator(const DescriptorAllocatorCreateInfo& create_info, const ApiContext& a_ctx)
+      : a_ctx(a_ctx),
+        next_sets(create_info.initial_sets > 0 ? create_info.initial_sets : DEFAULT_INITIAL_SETS),
+        max_sets_per_pool(create_info.max_sets_per_pool > 0 ? create_info.max_sets_per_pool : DEFAULT_MAX_SETS_PER_POOL),
+        pool_count(0) {
+        if (create_info.ratios != nullptr) {
+            ratios.assign(create_info.ratios, create_info.ratios + create_info.ratio_count);
+        } else {
+            ratios.assign(std::begin(DEFAULT_RATIOS), std::end(DEFAULT_RATIOS));
+        }
+
+        if (ratios.empty()) {
+            throw std::runtime_error("Descriptor allocator needs at least one descriptor type!");
+        }
+
+        next_sets = std::min(next_sets, max_sets_per_pool);
+    }
+
+    // pools wait for the device on destruction, see DescriptorPool
+    DescriptorAllocator::~DescriptorAllocator() { }
+
+    std::unique_ptr<DescriptorPool> DescriptorAllocator::NextPool() {
+        if (!ready_pools.empty()) {
+            std::unique_ptr<DescriptorPool> pool = std::move(ready_pools.back());
+            ready_pools.pop_back();
+            return pool;
+        }
+
+        std::vector<VkDescriptorPoolSize> pool_sizes;
+        for (const auto& ratio : ratios) {
+            pool_sizes.push_back({
+                .type = ratio.type,
+                .descriptorCount = std::max(static_cast<uint32_t>(std::ceil(ratio.ratio * next_sets)), 1u)
+            });
+        }
+
+        DescriptorPoolCreateInfo pool_info = {
+            .max_sets = next_sets,
+            .flags = 0,
+            .pool_sizes = pool_sizes.data(),
+            .pool_size_count = static_cast<uint32_t>(pool_sizes.size())
+        };
+
+        auto pool = std::make_unique<DescriptorPool>(pool_info, a_ctx);
+        pool_count++;
+
+        // a frame that ran out will likely need more next time too
+        next_sets = std::min(next_sets * 2, max_sets_per_pool);
+
+        return pool;
+    }
+
+    bool DescriptorAllocator::TryAllocate(VkDescriptorSetLayout layout, VkDescriptorSet* out_set) {
+        VkDescriptorSetAllocateInfo alloc_info = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = frames.back().pools.back()->get_pool(),
+            .descriptorSetCount = 1,
+            .pSetLayouts = &layout
+        };
+
+        VkResult result = vkAllocateDescriptorSets(a_ctx.device, &alloc_info, out_set);
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+            return false;
+        } else if (result != VK_SUCCESS) {
+            throw std::runtime_error(
+                "Failed to allocate descriptor set! result: " +
+                std::to_string(static_cast<int32_t>(result))
+            );
+        }
+
+        return true;
+    }
+
+    void DescriptorAllocator::BeginFrame(uint64_t frame_number, uint64_t completed_frame_number) {
+        // ~~~ recycle retired frames ~~~
+
+        while (!frames.empty() && frames.front().frame_number <= completed_frame_number) {
+            for (auto& pool : frames.front().pools) {
+                pool->Reset();
+                ready_pools.push_back(std::move(pool));
+            }
+            frames.pop_front();
+        }
+
+        if (frames.empty() || frames.back().frame_number != frame_number) {
+            frames.push_back({.frame_number = frame_number});
+        }
+    }
+
+    VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout) {
+        // there's no frame to tie the set's lifetime to yet, and a made up
+        //   one would be reset by the first BeginFrame
+        if (frames.empty()) {
+            throw std::runtime_error("Cannot allocate descriptor sets before the first BeginFrame!");
+        }
+
+        FramePools& frame = frames.back();
+        if (frame.pools.empty()) {
+            frame.pools.push_back(NextPool());
+        }
+
+        VkDescriptorSet set;
+        if (TryAllocate(layout, &set)) {
+            return set;
+        }
+
+        // the current pool is full, chain a new one onto the frame
+        frame.pools.push_back(NextPool());
+        if (!TryAllocate(layout, &set)) {
+            throw std::runtime_error("Failed to allocate descriptor set from a fresh pool!");
+        }
+
+        return set;
+    }
+
+    VkDescriptorSet DescriptorAllocator::Get(VkDescriptorSetLayout layout, const DescriptorWrite* writes, uint32_t write_count) {
+        // ~~~ look for an identical set from this frame ~~~
+
+        // built field by field so struct padding never ends up in it
+        std::string key;
+        append_key(key, layout);
+        for (uint32_t i = 0; i < write_count; i++) {
+            const DescriptorWrite& write = writes[i];
+            append_key(key, write.binding);
+            append_key(key, write.type);
+
+            if (is_image_type(write.type)) {
+                append_key(key, write.image.sampler);
+                append_key(key, write.image.imageView);
+                append_key(key, write.image.imageLayout);
+            } else {
+                append_key(key, write.buffer.buffer);
+                append_key(key, write.buffer.offset);
+                append_key(key, write.buffer.range);
+            }
+        }
+
+        if (!frames.empty()) {
+            auto found = frames.back().cache.find(key);
+            if (found != frames.back().cache.end()) {
+                return found->second;
+            }
+        }
+
+        // ~~~ allocate & write ~~~
+
+        VkDescriptorSet set = Allocate(layout);
+
+        std::vector<VkWriteDescriptorSet> vk_writes(write_count);
+        for (uint32_t i = 0; i < write_count; i++) {
+            bool image = is_image_type(writes[i].type);
+            vk_writes[i] = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = set,
+                .dstBinding = writes[i].binding,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = writes[i].type,
+                .pImageInfo = image ? &writes[i].image : nullptr,
+                .pBufferInfo = image ? nullptr : &writes[i].buffer,
+                .pTexelBufferView = nullptr,
+            };
+        }
+
+        vkUpdateDescriptorSets(a_ctx.device, write_count, vk_writes.data(), 0, nullptr);
+
+        frames.back().cache[key] = set;
+        return set;
+    }
+
+    size_t DescriptorAllocator::get_pool_count() const { return pool_count; }
+}
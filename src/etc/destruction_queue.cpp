@@ -1,7 +1,9 @@
 #include "etc/destruction_queue.h"
 
 namespace rt {
-    DestructionQueue::DestructionQueue() { }
+    DestructionQueue::DestructionQueue()
+      : current_value(0),
+        pending_bytes(0) { }
 
     DestructionQueue::~DestructionQueue() {
         Flush();
@@ -12,6 +14,8 @@ namespace rt {
     }
 
     void DestructionQueue::Flush() {
+        Retire(UINT64_MAX);
+
         // reverse begin & end to make this flush LIFO
         for (auto i = queue.rbegin(); i != queue.rend(); i++) {
             (*i)();
@@ -19,4 +23,55 @@ namespace rt {
 
         queue.clear();
     }
+
+    void DestructionQueue::QueueRetire(std::function<void()> func, VkDeviceSize bytes) {
+        std::lock_guard<std::mutex> lock(retire_mutex);
+
+        retired.push_back({
+            .func = func,
+            .retire_value = current_value,
+            .bytes = bytes
+        });
+        pending_bytes += bytes;
+    }
+
+    void DestructionQueue::Retire(uint64_t completed_value) {
+        // pull finished entries out under the lock but run them
+        //   outside of it, they might retire more things themselves
+        std::deque<RetiredEntry> finished;
+        {
+            std::lock_guard<std::mutex> lock(retire_mutex);
+
+            // values are only ever increasing so entries are in order
+            while (!retired.empty() && retired.front().retire_value <= completed_value) {
+                pending_bytes -= retired.front().bytes;
+                finished.push_back(std::move(retired.front()));
+                retired.pop_front();
+            }
+        }
+
+        for (auto& entry : finished) {
+            entry.func();
+        }
+    }
+
+    void DestructionQueue::set_current_value(uint64_t value) {
+        std::lock_guard<std::mutex> lock(retire_mutex);
+        current_value = value;
+    }
+
+    uint64_t DestructionQueue::get_current_value() {
+        std::lock_guard<std::mutex> lock(retire_mutex);
+        return current_value;
+    }
+
+    VkDeviceSize DestructionQueue::get_pending_bytes() {
+        std::lock_guard<std::mutex> lock(retire_mutex);
+        return pending_bytes;
+    }
+
+    size_t DestructionQueue::get_pending_count() {
+        std::lock_guard<std::mutex> lock(retire_mutex);
+        return retired.size();
+    }
 }
@@ -0,0 +1,213 @@
+#include "etc/draw_list.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <tuple>
+
+namespace rt {
+    static bool batch_key_less(const DrawBatchKey& a, const DrawBatchKey& b) {
+        // pipeline first since it's by far the most expensive to switch
+        return std::tie(a.pipeline, a.vertex_buffer, a.index_buffer, a.index_type) <
+               std::tie(b.pipeline, b.vertex_buffer, b.index_buffer, b.index_type);
+    }
+
+    static bool batch_key_equal(const DrawBatchKey& a, const DrawBatchKey& b) {
+        return a.pipeline == b.pipeline &&
+               a.vertex_buffer == b.vertex_buffer &&
+               a.index_buffer == b.index_buffer &&
+               a.index_type == b.index_type;
+    }
+
+    DrawList::DrawList(const DrawListCreateInfo& create_info, const ApiContext& a_ctx)
+      : max_draws(create_info.max_draws),
+        multi_draw_indirect(create_info.multi_draw_indirect),
+        draw_indirect_first_instance(create_info.draw_indirect_first_instance),
+        draw_indirect_count(create_info.draw_indirect_count),
+        frame_index(0),
+        is_built(false) {
+        if (create_info.max_draws == 0 || create_info.frame_flight_count == 0) {
+            throw std::runtime_error("Cannot create a draw list without any draws or frames!");
+        }
+
+        draws.reserve(max_draws);
+
+        // host visible so building is just a memcpy, storage usage lets
+        //   compute passes rewrite commands and counts in place
+        BufferCreateInfo buffer_info = {
+            .size = sizeof(VkDrawIndexedIndirectCommand) * static_cast<VkDeviceSize>(max_draws),
+            .usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .allocator = create_info.allocator,
+            .retire_queue = create_info.retire_queue
+        };
+
+        frames.resize(create_info.frame_flight_count);
+        for (auto& frame : frames) {
+            frame.commands = std::make_unique<Buffer>(buffer_info, a_ctx);
+            frame.commands->Map();
+
+            if (draw_indirect_count) {
+                // worst case is every draw landing in its own batch
+                BufferCreateInfo count_info = buffer_info;
+                count_info.size = sizeof(uint32_t) * static_cast<VkDeviceSize>(max_draws);
+
+                frame.counts = std::make_unique<Buffer>(count_info, a_ctx);
+                frame.counts->Map();
+            }
+        }
+    }
+
+    DrawList::~DrawList() { }
+
+    void DrawList::Begin(uint32_t new_frame_index) {
+        frame_index = new_frame_index % static_cast<uint32_t>(frames.size());
+        draws.clear();
+        batches.clear();
+        is_built = false;
+    }
+
+    void DrawList::Add(const DrawBatchKey& key, const VkDrawIndexedIndirectCommand& command) {
+        if (is_built) {
+            throw std::runtime_error("Cannot add draws to a draw list after it was built!");
+        }
+
+        if (draws.size() >= max_draws) {
+            throw std::runtime_error("Draw list is out of room for draws!");
+        }
+
+        // invalid without the feature, drivers that don't catch it tend
+        //   to use 0 so every draw would read the first object's data
+        if (command.firstInstance != 0 && !draw_indirect_first_instance) {
+            throw std::runtime_error("Indirect draws with a first instance aren't supported by the device!");
+        }
+
+        draws.push_back({key, command});
+    }
+
+    void DrawList::Add(VkPipeline pipeline, const Mesh& mesh, uint32_t instance_count, uint32_t first_instance) {
+        Add(pipeline, mesh, mesh.get_lods()[0], instance_count, first_instance);
+    }
+
+    void DrawList::Add(VkPipeline pipeline, const Mesh& mesh, const MeshLod& lod, uint32_t instance_count, uint32_t first_instance) {
+        DrawBatchKey key = {
+            .pipeline = pipeline,
+            .vertex_buffer = mesh.get_vertex_buffer(),
+            .index_buffer = mesh.get_index_buffer(),
+            .index_type = mesh.get_index_type()
+        };
+
+        VkDrawIndexedIndirectCommand command = {
+            .indexCount = lod.index_count,
+            .instanceCount = instance_count,
+            .firstIndex = mesh.get_first_index() + lod.first_index,
+            .vertexOffset = mesh.get_vertex_offset(),
+            .firstInstance = first_instance
+        };
+
+        Add(key, command);
+    }
+
+    void DrawList::Build() {
+        if (is_built) {
+            return;
+        }
+
+        // stable so draws within a batch keep submission order
+        std::stable_sort(draws.begin(), draws.end(), [](const Draw& a, const Draw& b) {
+            return batch_key_less(a.key, b.key);
+        });
+
+        FrameBuffers& frame = frames[frame_index];
+        auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(frame.commands->get_mapped_data());
+
+        for (uint32_t i = 0; i < draws.size(); i++) {
+            commands[i] = draws[i].command;
+
+            if (batches.empty() || !batch_key_equal(batches.back().key, draws[i].key)) {
+                batches.push_back({
+                    .key = draws[i].key,
+                    .first_command = i,
+                    .command_count = 0
+                });
+            }
+            batches.back().command_count++;
+        }
+
+        if (draw_indirect_count) {
+            auto* counts = static_cast<uint32_t*>(frame.counts->get_mapped_data());
+            for (uint32_t i = 0; i < batches.size(); i++) {
+                counts[i] = batches[i].command_count;
+            }
+        }
+
+        is_built = true;
+    }
+
+    void DrawList::CmdDraw(VkCommandBuffer command_buffer) {
+        Build();
+
+        FrameBuffers& frame = frames[frame_index];
+        VkBuffer indirect_buffer = frame.commands->get_buffer();
+        constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+        // only rebind what actually changed between batches
+        VkPipeline bound_pipeline = VK_NULL_HANDLE;
+        VkBuffer bound_vertex_buffer = VK_NULL_HANDLE;
+        VkBuffer bound_index_buffer = VK_NULL_HANDLE;
+        VkIndexType bound_index_type = VK_INDEX_TYPE_MAX_ENUM;
+
+        for (uint32_t i = 0; i < batches.size(); i++) {
+            const DrawBatch& batch = batches[i];
+
+            if (batch.key.pipeline != bound_pipeline) {
+                vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, batch.key.pipeline);
+                bound_pipeline = batch.key.pipeline;
+            }
+
+            if (batch.key.vertex_buffer != bound_vertex_buffer) {
+                VkDeviceSize offset = 0;
+                vkCmdBindVertexBuffers(command_buffer, 0, 1, &batch.key.vertex_buffer, &offset);
+                bound_vertex_buffer = batch.key.vertex_buffer;
+            }
+
+            if (batch.key.index_buffer != bound_index_buffer || batch.key.index_type != bound_index_type) {
+                vkCmdBindIndexBuffer(command_buffer, batch.key.index_buffer, 0, batch.key.index_type);
+                bound_index_buffer = batch.key.index_buffer;
+                bound_index_type = batch.key.index_type;
+            }
+
+            VkDeviceSize offset = static_cast<VkDeviceSize>(batch.first_command) * stride;
+
+            if (draw_indirect_count) {
+                vkCmdDrawIndexedIndirectCount(
+                    command_buffer,
+                    indirect_buffer,
+                    offset,
+                    frame.counts->get_buffer(),
+                    sizeof(uint32_t) * static_cast<VkDeviceSize>(i),
+                    batch.command_count,
+                    stride
+                );
+            } else if (multi_draw_indirect) {
+                vkCmdDrawIndexedIndirect(command_buffer, indirect_buffer, offset, batch.command_count, stride);
+            } else {
+                // drawCount can only be 0 or 1 without the feature
+                for (uint32_t j = 0; j < batch.command_count; j++) {
+                    vkCmdDrawIndexedIndirect(command_buffer, indirect_buffer, offset + j * stride, 1, stride);
+                }
+            }
+        }
+    }
+
+    const std::vector<DrawBatch>& DrawList::get_batches() const { return batches; }
+    size_t DrawList::get_draw_count() const { return draws.size(); }
+    VkBuffer DrawList::get_command_buffer() const { return frames[frame_index].commands->get_buffer(); }
+
+    VkBuffer DrawList::get_count_buffer() const {
+        if (!draw_indirect_count) {
+            return VK_NULL_HANDLE;
+        }
+
+        return frames[frame_index].counts->get_buffer();
+    }
+}
@@ -0,0 +1,186 @@
+#include "etc/frame_readback.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include "vk_utils.h"
+
+namespace rt {
+    FrameReadback::FrameReadback(const FrameReadbackCreateInfo& create_info, const ApiContext& a_ctx)
+      : a_ctx(a_ctx),
+        allocator(create_info.allocator),
+        retire_queue(create_info.retire_queue),
+        memory_properties(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+        if (create_info.frame_flight_count == 0) {
+            throw std::runtime_error("Cannot create frame readback with a frame flight count of zero!");
+        }
+
+        slots.resize(create_info.frame_flight_count);
+
+        // cached memory makes CPU reads way faster, but
+        //   isn't guaranteed to exist alongside coherent
+        VkPhysicalDeviceMemoryProperties mem_properties;
+        vkGetPhysicalDeviceMemoryProperties(a_ctx.physical_device, &mem_properties);
+
+        VkMemoryPropertyFlags cached = memory_properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
+            if ((mem_properties.memoryTypes[i].propertyFlags & cached) == cached) {
+                memory_properties = cached;
+                break;
+            }
+        }
+    }
+
+    void FrameReadback::CmdCopyImage(
+        VkCommandBuffer command_buffer,
+        uint32_t frame_index,
+        uint64_t frame_number,
+        VkImage image,
+        VkImageLayout layout,
+        VkExtent2D extent,
+        VkFormat format,
+        ReadbackCallback callback
+    ) {
+        Slot& slot = slots.at(frame_index);
+
+        if (slot.callback != nullptr) {
+            throw std::runtime_error("Readback slot still has an undelivered frame!");
+        }
+
+        // ~~~ (re)create the buffer when the image changed size ~~~
+
+        VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * Utils::get_format_texel_size(format);
+        if (slot.buffer == nullptr || slot.size != size) {
+            BufferCreateInfo buffer_info = {
+                .size = size,
+                .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .properties = memory_properties,
+                .allocator = allocator,
+                .retire_queue = retire_queue
+            };
+
+            slot.buffer = std::make_unique<Buffer>(buffer_info, a_ctx);
+            slot.buffer->Map();
+            slot.size = size;
+        }
+
+        slot.width = extent.width;
+        slot.height = extent.height;
+        slot.format = format;
+        slot.frame_number = frame_number;
+        slot.callback = callback;
+
+        // ~~~ record copy ~~~
+
+        // copies can only read from these two layouts
+        bool needs_transition = layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL && layout != VK_IMAGE_LAYOUT_GENERAL;
+        VkImageLayout copy_layout = needs_transition ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : layout;
+
+        VkImageMemoryBarrier to_copy = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+            .oldLayout = layout,
+            .newLayout = copy_layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            }
+        };
+
+        vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &to_copy
+        );
+
+        Utils::cmd_copy_image_to_buffer(command_buffer, image, copy_layout, slot.buffer->get_buffer(), extent.width, extent.height);
+
+        // put the image back how we found it (presentation
+        //   has its own semaphore so no access mask is needed)
+        if (needs_transition) {
+            VkImageMemoryBarrier to_original = to_copy;
+            to_original.srcAccessMask = 0;
+            to_original.dstAccessMask = 0;
+            to_original.oldLayout = copy_layout;
+            to_original.newLayout = layout;
+
+            vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &to_original
+            );
+        }
+
+        // device writes need to be made visible to the host explicitly
+        VkBufferMemoryBarrier to_host = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = slot.buffer->get_buffer(),
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        };
+
+        vkCmdPipelineBarrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            0, nullptr,
+            1, &to_host,
+            0, nullptr
+        );
+    }
+
+    void FrameReadback::Deliver(uint64_t completed_frame_number) {
+        // slots are round robin, so sort to keep frames in order
+        std::vector<Slot*> ready;
+        for (auto& slot : slots) {
+            if (slot.callback != nullptr && slot.frame_number <= completed_frame_number) {
+                ready.push_back(&slot);
+            }
+        }
+
+        std::sort(ready.begin(), ready.end(), [](const Slot* a, const Slot* b) {
+            return a->frame_number < b->frame_number;
+        });
+
+        for (Slot* slot : ready) {
+            ReadbackResult result = {
+                .data = slot->buffer->get_mapped_data(),
+                .size = slot->size,
+                .width = slot->width,
+                .height = slot->height,
+                .format = slot->format,
+                .frame_number = slot->frame_number
+            };
+
+            // cleared first so the callback is free to queue another readback
+            ReadbackCallback callback = std::move(slot->callback);
+            slot->callback = nullptr;
+            callback(result);
+        }
+    }
+
+    size_t FrameReadback::get_pending_count() const {
+        return std::count_if(slots.begin(), slots.end(), [](const Slot& slot) {
+            return slot.callback != nullptr;
+        });
+    }
+}
@@ -0,0 +1,375 @@
+#include "etc/geometry_pool.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include "vk_utils.h"
+
+namespace rt {
+    void GeometryPool::RangeAllocator::Reset(uint32_t new_capacity, uint32_t new_used) {
+        free_ranges.clear();
+        capacity = new_capacity;
+        used = new_used;
+
+        if (new_used < new_capacity) {
+            free_ranges[new_used] = new_capacity - new_used;
+        }
+    }
+
+    bool GeometryPool::RangeAllocator::Allocate(uint32_t count, uint32_t* out_offset) {
+        if (count == 0) {
+            *out_offset = 0;
+            return true;
+        }
+
+        // first fit keeps allocations packed towards the front, which
+        //   leaves the big tail span alone for as long as possible
+        for (auto it = free_ranges.begin(); it != free_ranges.end(); it++) {
+            if (it->second < count) {
+                continue;
+            }
+
+            *out_offset = it->first;
+            uint32_t remaining = it->second - count;
+            uint32_t remaining_offset = it->first + count;
+
+            free_ranges.erase(it);
+            if (remaining > 0) {
+                free_ranges[remaining_offset] = remaining;
+            }
+
+            used += count;
+            return true;
+        }
+
+        return false;
+    }
+
+    void GeometryPool::RangeAllocator::Free(uint32_t offset, uint32_t count) {
+        if (count == 0) {
+            return;
+        }
+
+        used -= count;
+
+        auto next = free_ranges.lower_bound(offset);
+
+        // merge with the span right before us
+        if (next != free_ranges.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                offset = prev->first;
+                count += prev->second;
+                free_ranges.erase(prev);
+            }
+        }
+
+        // and the one right after
+        if (next != free_ranges.end() && offset + count == next->first) {
+            count += next->second;
+            free_ranges.erase(next);
+        }
+
+        free_ranges[offset] = count;
+    }
+
+    GeometryPool::GeometryPool(const GeometryPoolCreateInfo& create_info, const ApiContext& a_ctx)
+      : a_ctx(a_ctx),
+        vertex_size(create_info.vertex_size),
+        index_type(create_info.index_type),
+        index_size(create_info.index_type == VK_INDEX_TYPE_UINT16 ? 2 : 4),
+        allocator(create_info.allocator),
+        retire_queue(create_info.retire_queue),
+        arenas(std::make_shared<Arenas>()) {
+        if (create_info.vertex_size == 0 || create_info.vertex_capacity == 0 || create_info.index_capacity == 0) {
+            throw std::runtime_error("Cannot create an empty geometry pool!");
+        }
+
+        if (create_info.index_type != VK_INDEX_TYPE_UINT16 && create_info.index_type != VK_INDEX_TYPE_UINT32) {
+            throw std::runtime_error("Geometry pool indices must be either 16 or 32 bits!");
+        }
+
+        vertex_buffer = CreateArena(vertex_size * create_info.vertex_capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        index_buffer = CreateArena(index_size * create_info.index_capacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+        arenas->vertices.Reset(create_info.vertex_capacity, 0);
+        arenas->indices.Reset(create_info.index_capacity, 0);
+    }
+
+    GeometryPool::~GeometryPool() { }
+
+    std::unique_ptr<Buffer> GeometryPool::CreateArena(VkDeviceSize size, VkBufferUsageFlags usage) {
+        BufferCreateInfo buffer_info = {
+            .size = size,
+            // transfer src so compaction can copy out of the old arena,
+            //   storage so compute passes can read or generate geometry
+            .usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            .properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            .allocator = allocator,
+            .retire_queue = retire_queue
+        };
+
+        return std::make_unique<Buffer>(buffer_info, a_ctx);
+    }
+
+    GeometryHandle GeometryPool::Allocate(uint32_t vertex_count, uint32_t index_count) {
+        uint32_t vertex_offset;
+        if (!arenas->vertices.Allocate(vertex_count, &vertex_offset)) {
+            throw std::runtime_error("Geometry pool is out of room for vertices!");
+        }
+
+        uint32_t first_index;
+        if (!arenas->indices.Allocate(index_count, &first_index)) {
+            arenas->vertices.Free(vertex_offset, vertex_count);
+            throw std::runtime_error("Geometry pool is out of room for indices!");
+        }
+
+        GeometryHandle handle;
+        if (!free_slots.empty()) {
+            handle = free_slots.back();
+            free_slots.pop_back();
+        } else {
+            handle = static_cast<GeometryHandle>(slots.size());
+            slots.emplace_back();
+        }
+
+        slots[handle] = {
+            .range = {
+                .vertex_offset = static_cast<int32_t>(vertex_offset),
+                .vertex_count = vertex_count,
+                .first_index = first_index,
+                .index_count = index_count
+            },
+            .live = true
+        };
+
+        return handle;
+    }
+
+    void GeometryPool::Free(GeometryHandle handle) {
+        Slot& slot = slots.at(handle);
+        if (!slot.live) {
+            throw std::runtime_error("Geometry handle was already freed!");
+        }
+
+        slot.live = false;
+        free_slots.push_back(handle);
+
+        GeometryRange range = slot.range;
+        auto release = [weak_arenas = std::weak_ptr<Arenas>(arenas), range] {
+            // a compaction or the pool going away already dropped this range
+            if (auto arenas = weak_arenas.lock()) {
+                arenas->vertices.Free(static_cast<uint32_t>(range.vertex_offset), range.vertex_count);
+                arenas->indices.Free(range.first_index, range.index_count);
+            }
+        };
+
+        if (retire_queue != nullptr) {
+            retire_queue->QueueRetire(release);
+        } else {
+            release();
+        }
+    }
+
+    void GeometryPool::Write(GeometryHandle handle, const void* vertices, const void* indices, UploadContext& upload) {
+        const GeometryRange& range = get_range(handle);
+        VkDeviceSize vertex_bytes = vertex_size * range.vertex_count;
+        VkDeviceSize index_bytes = index_size * range.index_count;
+
+        // one staging buffer for both halves, indices start 4 byte aligned for the copy
+        VkDeviceSize index_staging_offset = (vertex_bytes + 3) / 4 * 4;
+
+        BufferCreateInfo staging_info = {
+            .size = std::max<VkDeviceSize>(index_staging_offset + index_bytes, 4),
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .allocator = allocator,
+            // staging buffer has to stay alive until the GPU is done reading it
+            .retire_queue = &upload.get_retire_queue()
+        };
+        Buffer staging_buffer(staging_info, a_ctx);
+
+        staging_buffer.Map();
+        staging_buffer.CopyFromHost(vertices, static_cast<size_t>(vertex_bytes), 0);
+        staging_buffer.CopyFromHost(indices, static_cast<size_t>(index_bytes), index_staging_offset);
+        staging_buffer.Unmap();
+
+        VkCommandBuffer command_buffer = upload.AcquireCommandBuffer();
+
+        if (vertex_bytes > 0) {
+            VkBufferCopy region = {
+                .srcOffset = 0,
+                .dstOffset = vertex_size * static_cast<VkDeviceSize>(range.vertex_offset),
+                .size = vertex_bytes
+            };
+            vkCmdCopyBuffer(command_buffer, staging_buffer.get_buffer(), vertex_buffer->get_buffer(), 1, &region);
+        }
+
+        if (index_bytes > 0) {
+            VkBufferCopy region = {
+                .srcOffset = index_staging_offset,
+                .dstOffset = index_size * range.first_index,
+                .size = index_bytes
+            };
+            vkCmdCopyBuffer(command_buffer, staging_buffer.get_buffer(), index_buffer->get_buffer(), 1, &region);
+        }
+
+        ReleaseRange(range, upload);
+    }
+
+    void GeometryPool::Write(GeometryHandle handle, const void* vertices, const void* indices, StagingRing& staging) {
+        const GeometryRange& range = get_range(handle);
+
+        staging.CopyToBuffer(
+            vertices,
+            vertex_size * range.vertex_count,
+            *vertex_buffer,
+            vertex_size * static_cast<VkDeviceSize>(range.vertex_offset)
+        );
+        staging.CopyToBuffer(
+            indices,
+            index_size * range.index_count,
+            *index_buffer,
+            index_size * range.first_index
+        );
+
+        ReleaseRange(range, staging.get_upload_context());
+    }
+
+    void GeometryPool::ReleaseRange(const GeometryRange& range, UploadContext& upload) {
+        // only the written range changes queues, the rest of the arena
+        //   can still be in use by the graphics queue. barriers can't be
+        //   empty, so zero sized halves are skipped
+        if (range.vertex_count > 0) {
+            upload.ReleaseBuffer(
+                vertex_buffer->get_buffer(),
+                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                vertex_size * static_cast<VkDeviceSize>(range.vertex_offset),
+                vertex_size * range.vertex_count
+            );
+        }
+
+        if (range.index_count > 0) {
+            upload.ReleaseBuffer(
+                index_buffer->get_buffer(),
+                VK_ACCESS_INDEX_READ_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                index_size * range.first_index,
+                index_size * range.index_count
+            );
+        }
+    }
+
+    void GeometryPool::CmdCompact(VkCommandBuffer command_buffer) {
+        if (retire_queue == nullptr) {
+            throw std::runtime_error("Cannot compact a geometry pool without a retire queue!");
+        }
+
+        // ~~~ lay live ranges out back to back, keeping their order ~~~
+
+        std::vector<GeometryHandle> live;
+        for (GeometryHandle i = 0; i < slots.size(); i++) {
+            if (slots[i].live) {
+                live.push_back(i);
+            }
+        }
+
+        std::sort(live.begin(), live.end(), [this](GeometryHandle a, GeometryHandle b) {
+            return slots[a].range.vertex_offset < slots[b].range.vertex_offset;
+        });
+
+        std::vector<VkBufferCopy> vertex_regions;
+        std::vector<VkBufferCopy> index_regions;
+        uint32_t vertex_head = 0;
+        uint32_t index_head = 0;
+
+        for (GeometryHandle handle : live) {
+            GeometryRange& range = slots[handle].range;
+
+            if (range.vertex_count > 0) {
+                vertex_regions.push_back({
+                    .srcOffset = vertex_size * static_cast<VkDeviceSize>(range.vertex_offset),
+                    .dstOffset = vertex_size * vertex_head,
+                    .size = vertex_size * range.vertex_count
+                });
+                range.vertex_offset = static_cast<int32_t>(vertex_head);
+                vertex_head += range.vertex_count;
+            }
+
+            if (range.index_count > 0) {
+                index_regions.push_back({
+                    .srcOffset = index_size * range.first_index,
+                    .dstOffset = index_size * index_head,
+                    .size = index_size * range.index_count
+                });
+                range.first_index = index_head;
+                index_head += range.index_count;
+            }
+        }
+
+        // ~~~ copy into fresh arenas, overlapping copies within one buffer aren't allowed ~~~
+
+        std::unique_ptr<Buffer> new_vertex_buffer = CreateArena(vertex_buffer->get_size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        std::unique_ptr<Buffer> new_index_buffer = CreateArena(index_buffer->get_size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+        if (!vertex_regions.empty()) {
+            vkCmdCopyBuffer(
+                command_buffer,
+                vertex_buffer->get_buffer(),
+                new_vertex_buffer->get_buffer(),
+                static_cast<uint32_t>(vertex_regions.size()),
+                vertex_regions.data()
+            );
+        }
+
+        if (!index_regions.empty()) {
+            vkCmdCopyBuffer(
+                command_buffer,
+                index_buffer->get_buffer(),
+                new_index_buffer->get_buffer(),
+                static_cast<uint32_t>(index_regions.size()),
+                index_regions.data()
+            );
+        }
+
+        Utils::cmd_memory_barrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+        );
+
+        // old arenas retire with this frame, after the copy and any
+        //   earlier frames still drawing from them are done
+        vertex_buffer = std::move(new_vertex_buffer);
+        index_buffer = std::move(new_index_buffer);
+
+        // frees still waiting to retire point into the old layout, a new
+        //   allocator state makes them expire instead
+        uint32_t vertex_capacity = arenas->vertices.capacity;
+        uint32_t index_capacity = arenas->indices.capacity;
+
+        arenas = std::make_shared<Arenas>();
+        arenas->vertices.Reset(vertex_capacity, vertex_head);
+        arenas->indices.Reset(index_capacity, index_head);
+    }
+
+    const GeometryRange& GeometryPool::get_range(GeometryHandle handle) const {
+        const Slot& slot = slots.at(handle);
+        if (!slot.live) {
+            throw std::runtime_error("Geometry handle was freed!");
+        }
+
+        return slot.range;
+    }
+
+    VkBuffer GeometryPool::get_vertex_buffer() const { return vertex_buffer->get_buffer(); }
+    VkBuffer GeometryPool::get_index_buffer() const { return index_buffer->get_buffer(); }
+    VkIndexType GeometryPool::get_index_type() const { return index_type; }
+    VkDeviceSize GeometryPool::get_vertex_size() const { return vertex_size; }
+    uint32_t GeometryPool::get_used_vertices() const { return arenas->vertices.used; }
+    uint32_t GeometryPool::get_used_indices() const { return arenas->indices.used; }
+    size_t GeometryPool::get_free_range_count() const { return arenas->vertices.free_ranges.size() + arenas->indices.free_ranges.size(); }
+}
@@ -17,18 +17,47 @@ namespace rt {
     GraphicsManager::GraphicsManager(const GraphicsManagerCreateInfo& create_info)
       : api_cluster(create_info.api_cluster),
         device(api_cluster->get_device()),
+        headless(api_cluster->is_headless()),
         framebuffer_resized(false),
         on_resize_callback(create_info.on_swapchain_recreate_callback),
-        clear_value(create_info.clear_value) {
+        clear_value(create_info.clear_value),
+        frame_number(1),
+        completed_frame_number(0),
+        use_timeline_semaphore(create_info.use_timeline_semaphore),
+        frame_timeline(nullptr),
+        in_render_pass(false),
+        compute_written(false),
+        graphics_written(false) {
+        retire_queue.set_current_value(frame_number);
+
+        if (use_timeline_semaphore && !api_cluster->get_vulkan_12_features().timelineSemaphore) {
+            throw std::runtime_error("Timeline semaphores were requested but aren't supported by the device!");
+        }
+
         api_cluster->get_queues(&graphics_queue, &present_queue);
 
         CreateCommandPool(create_info);
+        CreateUploadContext(create_info);
         CreateFrameDataAndCommandBuffers(create_info);
         CreateRenderObjects(create_info);
         CreateSyncObjects(create_info);
+        CreateWorkerPools(create_info);
+
+        FrameReadbackCreateInfo readback_info = {
+            .frame_flight_count = create_info.swap_chain.frame_flight_count,
+            .retire_queue = &retire_queue
+        };
+        readback = std::make_shared<FrameReadback>(readback_info, get_api_context());
     }
 
     GraphicsManager::~GraphicsManager() {
+        vkDeviceWaitIdle(device);
+
+        // everything's finished, so don't drop any frames on the floor
+        readback->Deliver(UINT64_MAX);
+        readback.reset();
+
+        retire_queue.Flush();
         destruction_queue.Flush();
     }
 
@@ -37,13 +66,21 @@ namespace rt {
         if (create_info.main_render_pass != nullptr) {
             render_pass = create_info.main_render_pass;
         } else {
-            SwapChainSupportDetails details = Utils::query_swap_chain_support(
-                api_cluster->get_physical_device(),
-                api_cluster->get_surface()
-            );
-            VkSurfaceFormatKHR surface_format = create_info.swap_chain.surface_format.value_or(
-                Utils::choose_swap_surface_format(details.formats)
-            );
+            VkSurfaceFormatKHR surface_format;
+            if (create_info.swap_chain.surface_format.has_value()) {
+                surface_format = create_info.swap_chain.surface_format.value();
+            } else if (headless) {
+                surface_format = {
+                    .format = OFFSCREEN_DEFAULT_FORMAT,
+                    .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR
+                };
+            } else {
+                SwapChainSupportDetails details = Utils::query_swap_chain_support(
+                    api_cluster->get_physical_device(),
+                    api_cluster->get_surface()
+                );
+                surface_format = Utils::choose_swap_surface_format(details.formats);
+            }
             VkFormat depth_format = create_info.swap_chain.depth_format.value_or(
                 Utils::find_depth_format(api_cluster->get_physical_device())
             );
@@ -56,7 +93,8 @@ namespace rt {
                 .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
                 .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
                 .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+                // offscreen targets are left ready to be copied out of
+                .finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
             };
 
             VkAttachmentReference color_attachment_ref = {
@@ -96,6 +134,22 @@ namespace rt {
                 .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
             };
 
+            // there's no present semaphore to order against headless
+            //   copies, so make color writes visible to transfers
+            VkSubpassDependency transfer_dependency = {
+                .srcSubpass = 0,
+                .dstSubpass = VK_SUBPASS_EXTERNAL,
+                .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+            };
+
+            std::array<VkSubpassDependency, 2> dependencies = {
+                dependency,
+                transfer_dependency
+            };
+
             std::array<VkAttachmentDescription, 2> attachments = {
                 color_attachment,
                 depth_attachment
@@ -106,14 +160,33 @@ namespace rt {
                 .attachment_count = static_cast<uint32_t>(attachments.size()),
                 .subpasses = &subpass,
                 .subpass_count = 1,
-                .dependencies = &dependency,
-                .dependency_count = 1
+                .dependencies = dependencies.data(),
+                .dependency_count = headless ? 2u : 1u
             };
 
             render_pass = std::make_shared<RenderPass>(render_pass_info, get_api_context());
         }
         destruction_queue.QueueDelete([this] { render_pass.reset(); });
 
+        // with a compiler the graphics pipeline only needs the render pass,
+        //   so it builds while the swap chain is being created. without
+        //   one it's built right here, a thread for one pipeline isn't
+        //   worth it
+        PipelineFuture pipeline_future;
+        {
+            GraphicsPipelineCreateInfo pipeline_info = create_info.graphics_pipeline;
+            pipeline_info.render_pass = render_pass->get_render_pass();
+            if (pipeline_info.pipeline_cache == nullptr) {
+                pipeline_info.pipeline_cache = api_cluster->get_pipeline_cache();
+            }
+
+            if (create_info.pipeline_compiler != nullptr) {
+                pipeline_future = create_info.pipeline_compiler->Compile(pipeline_info);
+            } else {
+                pipeline = std::make_shared<GraphicsPipeline>(pipeline_info, get_api_context());
+            }
+        }
+
         // create swapchain
         {
             swap_chain_create_info = create_info.swap_chain;
@@ -126,11 +199,9 @@ namespace rt {
         }
         destruction_queue.QueueDelete([this] { swap_chain.reset(); });
 
-        // create graphics pipeline
-        {
-            GraphicsPipelineCreateInfo pipeline_info = create_info.graphics_pipeline;
-            pipeline_info.render_pass = render_pass->get_render_pass();
-            pipeline = std::make_shared<GraphicsPipeline>(pipeline_info, get_api_context());
+        // compile errors are rethrown here
+        if (pipeline_future.valid()) {
+            pipeline = pipeline_future.get();
         }
         destruction_queue.QueueDelete([this] { pipeline.reset(); });
     }
@@ -156,6 +227,38 @@ namespace rt {
         });
     }
 
+    void GraphicsManager::CreateUploadContext(const GraphicsManagerCreateInfo& create_info) {
+        QueueFamilyIndices indices = Utils::find_queue_families(
+            api_cluster->get_physical_device(),
+            api_cluster->get_surface()
+        );
+
+        UploadContextCreateInfo upload_info = {
+            .queue = graphics_queue,
+            .queue_family_index = indices.graphics.value()
+        };
+
+        VkQueue transfer_queue = api_cluster->get_transfer_queue();
+        if (create_info.use_transfer_queue && transfer_queue != nullptr) {
+            upload_info.queue = transfer_queue;
+            upload_info.queue_family_index = api_cluster->get_queue_families().transfer.value();
+            upload_info.dst_queue_family_index = indices.graphics.value();
+        }
+
+        upload_context = std::make_shared<UploadContext>(upload_info, get_api_context());
+        destruction_queue.QueueDelete([this] { upload_context.reset(); });
+
+        if (create_info.staging_ring_size > 0) {
+            StagingRingCreateInfo ring_info = {
+                .size = create_info.staging_ring_size,
+                .upload_context = upload_context
+            };
+
+            staging_ring = std::make_shared<StagingRing>(ring_info, get_api_context());
+            destruction_queue.QueueDelete([this] { staging_ring.reset(); });
+        }
+    }
+
     void GraphicsManager::CreateFrameDataAndCommandBuffers(const GraphicsManagerCreateInfo& create_info) {
         frame_datas.resize(create_info.swap_chain.frame_flight_count);
         for (size_t i = 0; i < frame_datas.size(); i++) {
@@ -169,6 +272,16 @@ namespace rt {
             if (vkAllocateCommandBuffers(device, &alloc_info, &frame_datas[i].command_buffer) != VK_SUCCESS) {
                 throw std::runtime_error("Failed to allocate command buffer for a frame!");
             }
+
+            // only ever recorded when uploads come from another queue
+            frame_datas[i].acquire_command_buffer = nullptr;
+            if (upload_context->get_transfers_ownership()) {
+                if (vkAllocateCommandBuffers(device, &alloc_info, &frame_datas[i].acquire_command_buffer) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to allocate acquire command buffer for a frame!");
+                }
+            }
+
+            frame_datas[i].frame_number = 0;
         }
     }
 
@@ -214,8 +327,32 @@ namespace rt {
             }
         });
 
-        // create render finished semaphores
-        {
+        // frame timeline semaphore
+        if (use_timeline_semaphore) {
+            VkSemaphoreTypeCreateInfo type_create_info = {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                // frame numbers start at 1 so 0 means nothing is done yet
+                .initialValue = 0
+            };
+
+            VkSemaphoreCreateInfo timeline_create_info = {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                .pNext = &type_create_info
+            };
+
+            if (vkCreateSemaphore(device, &timeline_create_info, nullptr, &frame_timeline) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create frame timeline semaphore!");
+            }
+
+            destruction_queue.QueueDelete([this] {
+                vkDestroySemaphore(device, frame_timeline, nullptr);
+            });
+        }
+
+        // create render finished semaphores, headless frames
+        //   are never presented so they don't need any
+        if (!headless) {
             // we make one semaphore for every single swap
             //   chain image rather than each frame in flight
             render_finished_semaphores.resize(swap_chain->get_image_count());
@@ -232,24 +369,66 @@ namespace rt {
         });
     }
 
+    void GraphicsManager::CreateWorkerPools(const GraphicsManagerCreateInfo& create_info) {
+        if (create_info.worker_count == 0) {
+            return;
+        }
+
+        QueueFamilyIndices indices = Utils::find_queue_families(
+            api_cluster->get_physical_device(),
+            api_cluster->get_surface()
+        );
+
+        // command pools aren't thread safe, so every worker gets
+        //   its own for every frame in flight. they're reset in one
+        //   go instead of resetting individual command buffers
+        VkCommandPoolCreateInfo pool_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = indices.graphics.value()
+        };
+
+        for (auto& data : frame_datas) {
+            data.worker_pools.resize(create_info.worker_count);
+            for (auto& worker : data.worker_pools) {
+                worker.used_count = 0;
+                if (vkCreateCommandPool(device, &pool_info, nullptr, &worker.pool) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create worker command pool!");
+                }
+            }
+        }
+
+        destruction_queue.QueueDelete([this] {
+            for (auto& data : frame_datas) {
+                for (auto& worker : data.worker_pools) {
+                    vkDestroyCommandPool(device, worker.pool, nullptr);
+                }
+            }
+        });
+    }
+
     void GraphicsManager::RecreateSwapChain() {
-        // handle minimization (when dimensions are zero)
-        int width = 0;
-        int height = 0;
-        glfwGetFramebufferSize(api_cluster->get_window(), &width, &height);
-        while (width == 0 || height == 0) {
+        // headless targets keep whatever extent they were last given
+        if (!headless) {
+            // handle minimization (when dimensions are zero)
+            int width = 0;
+            int height = 0;
             glfwGetFramebufferSize(api_cluster->get_window(), &width, &height);
-            glfwWaitEvents();
+            while (width == 0 || height == 0) {
+                glfwGetFramebufferSize(api_cluster->get_window(), &width, &height);
+                glfwWaitEvents();
+            }
+
+            swap_chain_create_info.extent = {
+                static_cast<uint32_t>(width),
+                static_cast<uint32_t>(height)
+            };
         }
 
         vkDeviceWaitIdle(device);
 
         swap_chain.reset();
 
-        swap_chain_create_info.extent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
         swap_chain = std::make_shared<SwapChain>(
             swap_chain_create_info,
             get_graphics_context(),
@@ -269,13 +448,10 @@ namespace rt {
         VkSemaphore image_available_semaphore = frame_datas[frame_index].image_available_semaphore;
         VkFence in_flight_fence = frame_datas[frame_index].in_flight_fence;
 
-        vkWaitForFences(
-            device,
-            1,
-            &in_flight_fence,
-            VK_TRUE,
-            UINT64_MAX
-        );
+        // everything this frame data was last used for is done after this
+        WaitForFrame(frame_datas[frame_index].frame_number);
+        readback->Deliver(completed_frame_number);
+        retire_queue.Retire(completed_frame_number);
 
         VkResult result = swap_chain->NextImage(image_available_semaphore, nullptr);
 
@@ -289,9 +465,17 @@ namespace rt {
         VkCommandBuffer command_buffer = frame_datas[frame_index].command_buffer;
 
         // only reset things if we're submitting work
-        vkResetFences(device, 1, &in_flight_fence);
+        if (!use_timeline_semaphore) {
+            vkResetFences(device, 1, &in_flight_fence);
+        }
         vkResetCommandBuffer(command_buffer, 0);
 
+        for (auto& worker : frame_datas[frame_index].worker_pools) {
+            vkResetCommandPool(device, worker.pool, 0);
+            worker.used_count = 0;
+            worker.recorded.clear();
+        }
+
         // ~~~ recording command buffer <3 ~~~
 
         VkCommandBufferBeginInfo begin_info = {
@@ -303,9 +487,35 @@ namespace rt {
         if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
             throw std::runtime_error("Failed to begin command buffer recording!");
         }
+
+        // earlier frames may still be reading what a dispatch is about to overwrite
+        graphics_written = true;
+        compute_written = false;
+    }
+
+    void GraphicsManager::CmdSetDefaultState(VkCommandBuffer command_buffer) {
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->get_pipeline());
+
+        // ~~~ set up dynamic state stuff ~~~
+
+        VkViewport viewport = {
+            .x = 0.0f,
+            .y = 0.0f,
+            .width = static_cast<float>(swap_chain->get_extent().width),
+            .height = static_cast<float>(swap_chain->get_extent().height),
+            .minDepth = 0.0f,
+            .maxDepth = 1.0f
+        };
+        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+        VkRect2D scissor = {
+            .offset = {0, 0},
+            .extent = swap_chain->get_extent()
+        };
+        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
     }
 
-    void GraphicsManager::CmdStartRenderPass() {
+    void GraphicsManager::CmdStartRenderPass(VkSubpassContents contents) {
         uint32_t frame_index = swap_chain->get_frame_index();
         VkCommandBuffer command_buffer = frame_datas[frame_index].command_buffer;
 
@@ -317,6 +527,9 @@ namespace rt {
             (VkClearValue) {.depthStencil = {1.0f, 0}}
         };
 
+        CmdSyncComputeToGraphics(command_buffer);
+        in_render_pass = true;
+
         VkRenderPassBeginInfo render_pass_begin_info = {
             .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
             .renderPass = render_pass->get_render_pass(),
@@ -329,33 +542,187 @@ namespace rt {
             .pClearValues = clear_values.data()
         };
 
-        vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, contents);
 
-        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->get_pipeline());
+        // secondary command buffers set up their own state, the
+        //   primary isn't allowed to record anything else in this case
+        if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+            CmdSetDefaultState(command_buffer);
+        }
+    }
 
-        // ~~~ set up dynamic state stuff ~~~
+    void GraphicsManager::CmdEndRenderPass() {
+        uint32_t frame_index = swap_chain->get_frame_index();
+        VkCommandBuffer command_buffer = frame_datas[frame_index].command_buffer;
+        vkCmdEndRenderPass(command_buffer);
 
-        VkViewport viewport = {
-            .x = 0.0f,
-            .y = 0.0f,
-            .width = static_cast<float>(swap_chain->get_extent().width),
-            .height = static_cast<float>(swap_chain->get_extent().height),
-            .minDepth = 0.0f,
-            .maxDepth = 1.0f
+        in_render_pass = false;
+        graphics_written = true;
+    }
+
+    void GraphicsManager::CmdSyncComputeToGraphics(VkCommandBuffer command_buffer) {
+        if (!compute_written) {
+            return;
+        }
+
+        // covers everything compute usually feeds: indirect args,
+        //   vertices (skinning, particles) and shader resources
+        Utils::cmd_memory_barrier(
+            command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+        );
+        compute_written = false;
+    }
+
+    void GraphicsManager::CmdDispatch(
+        const ComputePipeline& pipeline,
+        const VkDescriptorSet* descriptor_sets,
+        uint32_t descriptor_set_count,
+        uint32_t group_count_x,
+        uint32_t group_count_y,
+        uint32_t group_count_z
+    ) {
+        if (in_render_pass) {
+            throw std::runtime_error("Cannot dispatch compute work inside a render pass!");
+        }
+
+        uint32_t frame_index = swap_chain->get_frame_index();
+        VkCommandBuffer command_buffer = frame_datas[frame_index].command_buffer;
+
+        if (graphics_written) {
+            // waits on earlier reads too, so dispatches can safely
+            //   overwrite buffers the last frame was drawing from
+            Utils::cmd_memory_barrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+            );
+            graphics_written = false;
+        }
+
+        pipeline.CmdDispatch(command_buffer, descriptor_sets, descriptor_set_count, group_count_x, group_count_y, group_count_z);
+        compute_written = true;
+    }
+
+    void GraphicsManager::CmdComputeBarrier() {
+        uint32_t frame_index = swap_chain->get_frame_index();
+        Utils::cmd_memory_barrier(
+            frame_datas[frame_index].command_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+        );
+    }
+
+    VkCommandBuffer GraphicsManager::BeginWorkerCB(uint32_t worker_index) {
+        uint32_t frame_index = swap_chain->get_frame_index();
+        WorkerCommandPool& worker = frame_datas[frame_index].worker_pools.at(worker_index);
+
+        // pools are reset every frame so we can reuse
+        //   every command buffer allocated from them
+        if (worker.used_count == worker.command_buffers.size()) {
+            VkCommandBufferAllocateInfo alloc_info = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = worker.pool,
+                .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+                .commandBufferCount = 1
+            };
+
+            VkCommandBuffer new_buffer;
+            if (vkAllocateCommandBuffers(device, &alloc_info, &new_buffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate worker command buffer!");
+            }
+            worker.command_buffers.push_back(new_buffer);
+        }
+
+        VkCommandBuffer command_buffer = worker.command_buffers[worker.used_count];
+        worker.used_count++;
+
+        VkCommandBufferInheritanceInfo inheritance_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+            .renderPass = render_pass->get_render_pass(),
+            .subpass = 0,
+            .framebuffer = swap_chain->get_current_framebuffer()
         };
-        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
 
-        VkRect2D scissor = {
-            .offset = {0, 0},
-            .extent = swap_chain->get_extent()
+        VkCommandBufferBeginInfo begin_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+            .pInheritanceInfo = &inheritance_info
         };
-        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+        if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin worker command buffer recording!");
+        }
+
+        CmdSetDefaultState(command_buffer);
+
+        return command_buffer;
     }
 
-    void GraphicsManager::CmdEndRenderPass() {
+    void GraphicsManager::EndWorkerCB(uint32_t worker_index, VkCommandBuffer command_buffer) {
         uint32_t frame_index = swap_chain->get_frame_index();
-        VkCommandBuffer command_buffer = frame_datas[frame_index].command_buffer;
-        vkCmdEndRenderPass(command_buffer);
+        WorkerCommandPool& worker = frame_datas[frame_index].worker_pools.at(worker_index);
+
+        if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to end worker command buffer recording!");
+        }
+
+        worker.recorded.push_back(command_buffer);
+    }
+
+    void GraphicsManager::CmdExecuteWorkerCBs() {
+        uint32_t frame_index = swap_chain->get_frame_index();
+        FrameData& data = frame_datas[frame_index];
+
+        std::vector<VkCommandBuffer> recorded;
+        for (auto& worker : data.worker_pools) {
+            recorded.insert(recorded.end(), worker.recorded.begin(), worker.recorded.end());
+            worker.recorded.clear();
+        }
+
+        if (!recorded.empty()) {
+            vkCmdExecuteCommands(data.command_buffer, static_cast<uint32_t>(recorded.size()), recorded.data());
+        }
+    }
+
+    void GraphicsManager::CmdReadbackFrame(ReadbackCallback callback) {
+        if ((swap_chain->get_image_usage() & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == 0) {
+            throw std::runtime_error("Swap chain images don't support being read back!");
+        }
+
+        uint32_t frame_index = swap_chain->get_frame_index();
+        uint32_t image_index = swap_chain->get_image_index();
+
+        // matches the final layout of the default render pass
+        VkImageLayout layout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        readback->CmdCopyImage(
+            frame_datas[frame_index].command_buffer,
+            frame_index,
+            frame_number,
+            swap_chain->get_images()[image_index],
+            layout,
+            swap_chain->get_extent(),
+            swap_chain->get_image_format(),
+            callback
+        );
+    }
+
+    void GraphicsManager::PollReadbacks() {
+        if (frame_number > 1) {
+            IsFrameComplete(frame_number - 1);
+        }
+        readback->Deliver(completed_frame_number);
     }
 
     void GraphicsManager::EndCBAndPresentFrame() {
@@ -365,33 +732,139 @@ namespace rt {
         VkSemaphore image_available_semaphore = frame_datas[frame_index].image_available_semaphore;
         VkFence in_flight_fence = frame_datas[frame_index].in_flight_fence;
 
+        // dispatches after the render pass feed the next frame's draws
+        CmdSyncComputeToGraphics(command_buffer);
+
         if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
             throw std::runtime_error("Failed to end command buffer recording!");
         }
 
-        // ~~~ submitting queue ~~~
+        // ~~~ taking ownership of uploads ~~~
 
-        VkPipelineStageFlags wait_stages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        VkSubmitInfo submit_info = {
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .waitSemaphoreCount = 1,
+        std::vector<VkCommandBuffer> command_buffers;
+        std::vector<VkSemaphore> wait_semaphores;
+        std::vector<VkPipelineStageFlags> wait_stages;
+
+        // headless targets don't need to be acquired first
+        if (!headless) {
             // image available semaphores are linked to frame flight .
             //   once it's available we will use swapchain and its image
             //   index with inner systems
-            .pWaitSemaphores = &image_available_semaphore,
-            .pWaitDstStageMask = wait_stages,
-            .commandBufferCount = 1,
-            .pCommandBuffers = &command_buffer,
-            .signalSemaphoreCount = 1,
+            wait_semaphores.push_back(image_available_semaphore);
+            wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        }
+
+        UploadHandoff handoff;
+        bool has_handoff = false;
+        if (upload_context->get_transfers_ownership()) {
+            // anything that was recorded is submitted now so it can be
+            //   acquired below, otherwise it would wait for the next frame
+            upload_context->Submit();
+            has_handoff = upload_context->TakeHandoff(&handoff);
+        }
+
+        if (has_handoff) {
+            VkCommandBuffer acquire_command_buffer = frame_datas[frame_index].acquire_command_buffer;
+            vkResetCommandBuffer(acquire_command_buffer, 0);
+
+            VkCommandBufferBeginInfo begin_info = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+            };
+
+            if (vkBeginCommandBuffer(acquire_command_buffer, &begin_info) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to begin acquire command buffer recording!");
+            }
+
+            // the semaphore wait already orders us after the release,
+            //   so the acquire has nothing to wait on besides that
+            vkCmdPipelineBarrier(
+                acquire_command_buffer,
+                VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                handoff.dst_stages,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(handoff.buffer_barriers.size()), handoff.buffer_barriers.data(),
+                static_cast<uint32_t>(handoff.image_barriers.size()), handoff.image_barriers.data()
+            );
+
+            for (auto& record : handoff.commands) {
+                record(acquire_command_buffer);
+            }
+
+            if (vkEndCommandBuffer(acquire_command_buffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to end acquire command buffer recording!");
+            }
+
+            command_buffers.push_back(acquire_command_buffer);
+            for (VkSemaphore semaphore : handoff.semaphores) {
+                wait_semaphores.push_back(semaphore);
+                wait_stages.push_back(handoff.dst_stages);
+            }
+
+            // binary semaphores can be signaled again once this frame's wait is done
+            retire_queue.QueueRetire([this, semaphores = std::move(handoff.semaphores)] {
+                upload_context->RecycleSemaphores(semaphores);
+            });
+        }
+        command_buffers.push_back(command_buffer);
+
+        // ~~~ submitting queue ~~~
+
+        // in timeline mode we signal the frame number alongside the
+        //   binary semaphore, presentation can't wait on timelines.
+        //   headless frames aren't presented so they skip the binary one
+        std::array<VkSemaphore, 2> signal_semaphores;
+        std::array<uint64_t, 2> signal_values;
+        uint32_t signal_count = 0;
+        if (!headless) {
+            signal_semaphores[signal_count] = render_finished_semaphores[image_index];
+            signal_values[signal_count] = 0; // ignored for binary semaphores
+            signal_count++;
+        }
+        if (use_timeline_semaphore) {
+            signal_semaphores[signal_count] = frame_timeline;
+            signal_values[signal_count] = frame_number;
+            signal_count++;
+        }
+
+        VkTimelineSemaphoreSubmitInfo timeline_submit_info = {
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .signalSemaphoreValueCount = signal_count,
+            .pSignalSemaphoreValues = signal_values.data()
+        };
+
+        VkSubmitInfo submit_info = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size()),
+            .pWaitSemaphores = wait_semaphores.data(),
+            .pWaitDstStageMask = wait_stages.data(),
+            .commandBufferCount = static_cast<uint32_t>(command_buffers.size()),
+            .pCommandBuffers = command_buffers.data(),
+            .signalSemaphoreCount = signal_count,
             // we use more semaphores here! one for each swap
             //  chain image to keep them entirely separate
-            .pSignalSemaphores = &render_finished_semaphores[image_index]
+            .pSignalSemaphores = signal_semaphores.data()
         };
 
+        if (use_timeline_semaphore) {
+            submit_info.pNext = &timeline_submit_info;
+            in_flight_fence = nullptr;
+        }
+
         if (vkQueueSubmit(graphics_queue, 1, &submit_info, in_flight_fence) != VK_SUCCESS) {
             throw std::runtime_error("Failed to submit draw command buffer to graphics queue!");
         }
 
+        frame_datas[frame_index].frame_number = frame_number;
+        frame_number++;
+        retire_queue.set_current_value(frame_number);
+
+        if (headless) {
+            swap_chain->NextFrame();
+            return;
+        }
+
         // ~~~ presenting !!! ~~~
 
         VkSwapchainKHR sc = swap_chain->get_swap_chain();
@@ -417,13 +890,73 @@ namespace rt {
         swap_chain->NextFrame();
     }
 
+    bool GraphicsManager::IsFrameComplete(uint64_t frame) {
+        if (frame <= completed_frame_number) {
+            return true;
+        }
+
+        if (use_timeline_semaphore) {
+            uint64_t value = 0;
+            vkGetSemaphoreCounterValue(device, frame_timeline, &value);
+            completed_frame_number = std::max(completed_frame_number, value);
+        } else {
+            for (const auto& data : frame_datas) {
+                if (data.frame_number > completed_frame_number && vkGetFenceStatus(device, data.in_flight_fence) == VK_SUCCESS) {
+                    completed_frame_number = data.frame_number;
+                }
+            }
+        }
+
+        return frame <= completed_frame_number;
+    }
+
+    void GraphicsManager::WaitForFrame(uint64_t frame) {
+        if (frame <= completed_frame_number) {
+            return;
+        }
+
+        if (frame >= frame_number) {
+            throw std::runtime_error("Cannot wait for a frame that hasn't been submitted yet!");
+        }
+
+        if (use_timeline_semaphore) {
+            VkSemaphoreWaitInfo wait_info = {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                .semaphoreCount = 1,
+                .pSemaphores = &frame_timeline,
+                .pValues = &frame
+            };
+            vkWaitSemaphores(device, &wait_info, UINT64_MAX);
+        } else {
+            // frame datas are used round robin so this frame's
+            //   data is the one whose last submit was this frame
+            for (const auto& data : frame_datas) {
+                if (data.frame_number == frame) {
+                    vkWaitForFences(device, 1, &data.in_flight_fence, VK_TRUE, UINT64_MAX);
+                    break;
+                }
+            }
+        }
+
+        completed_frame_number = frame;
+    }
+
     VkCommandBuffer GraphicsManager::get_command_buffer() const { return frame_datas[swap_chain->get_frame_index()].command_buffer; }
+    uint32_t GraphicsManager::get_worker_count() const { return static_cast<uint32_t>(frame_datas[0].worker_pools.size()); }
     VkClearValue GraphicsManager::get_clear_value() const { return clear_value; }
     VkCommandPool GraphicsManager::get_command_pool() const { return command_pool; }
+    bool GraphicsManager::is_headless() const { return headless; }
     VkDevice GraphicsManager::get_device() const { return api_cluster->get_device(); }
     VkPhysicalDevice GraphicsManager::get_physical_device() const { return api_cluster->get_physical_device(); }
     VkQueue GraphicsManager::get_graphics_queue() const { return graphics_queue; }
     VkQueue GraphicsManager::get_present_queue() const { return present_queue; }
+    std::shared_ptr<UploadContext> GraphicsManager::get_upload_context() const { return upload_context; }
+    std::shared_ptr<StagingRing> GraphicsManager::get_staging_ring() const { return staging_ring; }
+    std::shared_ptr<FrameReadback> GraphicsManager::get_frame_readback() const { return readback; }
+    DestructionQueue& GraphicsManager::get_retire_queue() { return retire_queue; }
+    uint64_t GraphicsManager::get_frame_number() const { return frame_number; }
+    uint64_t GraphicsManager::get_completed_frame_number() const { return completed_frame_number; }
+    VkSemaphore GraphicsManager::get_frame_timeline() const { return frame_timeline; }
     std::shared_ptr<RenderPass> GraphicsManager::get_render_pass() const { return render_pass; }
     std::shared_ptr<GraphicsPipeline> GraphicsManager::get_graphics_pipeline() const { return pipeline; }
     std::shared_ptr<SwapChain> GraphicsManager::get_swap_chain() const { return swap_chain; }
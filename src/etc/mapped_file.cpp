@@ -0,0 +1,46 @@
+#include "etc/mapped_file.h"
+
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace rt {
+    MappedFile::MappedFile(const std::string& path, bool sequential)
+      : data(nullptr),
+        size(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+
+        // empty files can't be mapped
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("Failed to read file: " + path);
+        }
+
+        size = static_cast<size_t>(file_stat.st_size);
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+
+        if (sequential) {
+            madvise(data, size, MADV_SEQUENTIAL);
+            madvise(data, size, MADV_WILLNEED);
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        munmap(data, size);
+    }
+
+    const void* MappedFile::get_data() const { return data; }
+    size_t MappedFile::get_size() const { return size; }
+}
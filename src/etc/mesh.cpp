@@ -1,59 +1,192 @@
 #include "etc/mesh.h"
+#include "etc/upload_context.h"
+#include <stdexcept>
+#include <cmath>
 
 namespace rt {
+    void Mesh::ReleaseToReader(const Buffer& buffer, VkBufferUsageFlags usage, UploadContext& upload) {
+        VkAccessFlags access = usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT ? VK_ACCESS_INDEX_READ_BIT : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        upload.ReleaseBuffer(buffer.get_buffer(), access, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    }
+
+    std::unique_ptr<Buffer> Mesh::CreateDeviceBuffer(
+        const void* data,
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        const MeshCreateInfo& create_info,
+        const GraphicsContext& g_ctx,
+        const ApiContext& a_ctx
+    ) {
+        BufferCreateInfo buffer_info = {
+            .size = size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+            .properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            .allocator = create_info.allocator,
+            .retire_queue = create_info.retire_queue
+        };
+
+        // actual buffer! can't be accessed directly from CPU
+        auto buffer = std::make_unique<Buffer>(buffer_info, a_ctx);
+
+        if (create_info.staging_ring != nullptr) {
+            create_info.staging_ring->CopyToBuffer(data, size, *buffer);
+            ReleaseToReader(*buffer, usage, create_info.staging_ring->get_upload_context());
+            return buffer;
+        }
+
+        // intermediary buffer so we don't have to always be using a
+        //  buffer that is accessible by CPU host (faster that way)
+        buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        buffer_info.properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        if (create_info.upload_context != nullptr) {
+            // batch the copy, staging buffer is kept alive until it's done
+            UploadContext& upload = *create_info.upload_context;
+            buffer_info.retire_queue = &upload.get_retire_queue();
+
+            Buffer staging_buffer(buffer_info, a_ctx);
+            staging_buffer.CopyFromHostAuto(data, size);
+            buffer->CmdCopyFromBuffer(staging_buffer, upload.AcquireCommandBuffer());
+            ReleaseToReader(*buffer, usage, upload);
+        } else {
+            buffer_info.retire_queue = nullptr;
+
+            Buffer staging_buffer(buffer_info, a_ctx);
+            staging_buffer.CopyFromHostAuto(data, size);
+            buffer->CopyFromBuffer(staging_buffer, g_ctx, a_ctx);
+        }
+
+        return buffer;
+    }
+
     Mesh::Mesh(const MeshCreateInfo& create_info, const GraphicsContext& g_ctx, const ApiContext& a_ctx)
       : device(a_ctx.device),
+        geometry_pool(create_info.geometry_pool),
+        geometry_handle(0),
         num_vertices(create_info.num_vertices),
-        num_indices(create_info.num_indices) {
+        num_indices(create_info.num_indices),
+        index_type(create_info.index_size == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32),
+        upload_token(0) {
+        if (create_info.index_size != 2 && create_info.index_size != 4) {
+            throw std::runtime_error("Mesh indices must be either 16 or 32 bits!");
+        }
 
-        // vertex buffer
-        {
-            // intermediary buffer so we don't have to always be using a
-            //  buffer that is accessible by CPU host (faster that way)
-            BufferCreateInfo vert_create_info = {
-                .size = create_info.vertex_size * create_info.num_vertices,
-                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            };
+        if (create_info.lod_count > 0) {
+            lods.assign(create_info.lods, create_info.lods + create_info.lod_count);
+        } else {
+            lods.push_back({.first_index = 0, .index_count = num_indices, .error = 0.0f});
+        }
 
-            Buffer staging_buffer(vert_create_info, a_ctx);
-            staging_buffer.CopyFromHostAuto(create_info.vertices, create_info.vertex_size * create_info.num_vertices);
+        for (const auto& lod : lods) {
+            if (static_cast<uint64_t>(lod.first_index) + lod.index_count > num_indices) {
+                throw std::runtime_error("Mesh level of detail is out of range of its indices!");
+            }
+        }
 
-            // actual vertex buffer! can't be accessed directly from CPU
-            vert_create_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-            vert_create_info.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-            vertex_buffer = std::make_unique<Buffer>(vert_create_info, a_ctx);
+        if (geometry_pool != nullptr) {
+            if (geometry_pool->get_vertex_size() != create_info.vertex_size || geometry_pool->get_index_type() != index_type) {
+                throw std::runtime_error("Mesh vertex size or index type doesn't match its geometry pool!");
+            }
 
-            vertex_buffer->CopyFromBuffer(staging_buffer, g_ctx, a_ctx);
-        }
+            if (create_info.staging_ring == nullptr && create_info.upload_context == nullptr) {
+                throw std::runtime_error("Pooled meshes need an upload context or staging ring!");
+            }
+
+            geometry_handle = geometry_pool->Allocate(num_vertices, num_indices);
+
+            // the destructor won't run if this throws, so the range has
+            //   to go back to the pool here. Free retires it like any
+            //   other, in case part of the write was recorded
+            try {
+                if (create_info.staging_ring != nullptr) {
+                    geometry_pool->Write(geometry_handle, create_info.vertices, create_info.indices, *create_info.staging_ring);
+                    upload_token = create_info.staging_ring->get_upload_context().get_recording_token();
+                } else {
+                    geometry_pool->Write(geometry_handle, create_info.vertices, create_info.indices, *create_info.upload_context);
+                    upload_token = create_info.upload_context->get_recording_token();
+                }
+            } catch (...) {
+                geometry_pool->Free(geometry_handle);
+                throw;
+            }
 
-        // index buffer
-        {
-            // intermediary buffer so we don't have to always be using a
-            //  buffer that is accessible by CPU host (faster that way)
-            BufferCreateInfo ind_create_info = {
-                .size = create_info.index_size * create_info.num_indices,
-                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            };
+            return;
+        }
 
-            Buffer staging_buffer(ind_create_info, a_ctx);
-            staging_buffer.CopyFromHostAuto(create_info.indices, create_info.index_size * create_info.num_indices);
+        vertex_buffer = CreateDeviceBuffer(
+            create_info.vertices,
+            create_info.vertex_size * create_info.num_vertices,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            create_info,
+            g_ctx,
+            a_ctx
+        );
 
-            // actual index buffer! can't be accessed directly from CPU
-            ind_create_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-            ind_create_info.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-            index_buffer = std::make_unique<Buffer>(ind_create_info, a_ctx);
+        index_buffer = CreateDeviceBuffer(
+            create_info.indices,
+            create_info.index_size * create_info.num_indices,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            create_info,
+            g_ctx,
+            a_ctx
+        );
 
-            index_buffer->CopyFromBuffer(staging_buffer, g_ctx, a_ctx);
+        if (create_info.staging_ring != nullptr) {
+            upload_token = create_info.staging_ring->get_upload_context().get_recording_token();
+        } else if (create_info.upload_context != nullptr) {
+            upload_token = create_info.upload_context->get_recording_token();
         }
     }
 
     Mesh::~Mesh() {
+        if (geometry_pool != nullptr) {
+            geometry_pool->Free(geometry_handle);
+        }
+    }
+
+    VkBuffer Mesh::get_vertex_buffer() const {
+        return geometry_pool != nullptr ? geometry_pool->get_vertex_buffer() : vertex_buffer->get_buffer();
+    }
+
+    VkBuffer Mesh::get_index_buffer() const {
+        return geometry_pool != nullptr ? geometry_pool->get_index_buffer() : index_buffer->get_buffer();
+    }
+
+    int32_t Mesh::get_vertex_offset() const {
+        return geometry_pool != nullptr ? geometry_pool->get_range(geometry_handle).vertex_offset : 0;
+    }
+
+    uint32_t Mesh::get_first_index() const {
+        return geometry_pool != nullptr ? geometry_pool->get_range(geometry_handle).first_index : 0;
     }
 
-    VkBuffer Mesh::get_vertex_buffer() const { return vertex_buffer->get_buffer(); }
-    VkBuffer Mesh::get_index_buffer() const { return index_buffer->get_buffer(); }
+    const MeshLod& Mesh::SelectLod(float projected_size, float max_pixel_error) const {
+        // errors only grow down the chain, so stop at the first level
+        //   that would be visibly wrong
+        size_t selected = 0;
+        for (size_t i = 1; i < lods.size(); i++) {
+            if (lods[i].error * projected_size > max_pixel_error) {
+                break;
+            }
+            selected = i;
+        }
+
+        return lods[selected];
+    }
+
+    float Mesh::get_projected_size(float diagonal, float distance, float fov_y, float viewport_height) {
+        // inside (or right at) the bounds, always full detail
+        if (distance <= 0.0f) {
+            return INFINITY;
+        }
+
+        return diagonal / (2.0f * distance * std::tan(fov_y * 0.5f)) * viewport_height;
+    }
+
+    const std::vector<MeshLod>& Mesh::get_lods() const { return lods; }
+
     uint32_t Mesh::get_num_vertices() const { return num_vertices; }
     uint32_t Mesh::get_num_indices() const { return num_indices; }
+    VkIndexType Mesh::get_index_type() const { return index_type; }
+    UploadToken Mesh::get_upload_token() const { return upload_token; }
 }
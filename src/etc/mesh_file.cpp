@@ -0,0 +1,199 @@
+#include "etc/mesh_file.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include "vk_utils.h"
+
+namespace rt {
+    MeshFile::MeshFile(const std::string& path)
+      : mapping(path),
+        header(nullptr) {
+        size_t size = mapping.get_size();
+        if (size < sizeof(MeshFileHeader)) {
+            throw std::runtime_error("Mesh file is truncated or corrupt: " + path);
+        }
+
+        // ~~~ validate, nothing is parsed but a bad file can't reach the GPU ~~~
+
+        header = static_cast<const MeshFileHeader*>(mapping.get_data());
+
+        uint64_t tables_end = sizeof(MeshFileHeader) +
+                              sizeof(MeshFileAttribute) * static_cast<uint64_t>(header->attribute_count) +
+                              sizeof(MeshFileLod) * static_cast<uint64_t>(header->lod_count);
+
+        const char* error = nullptr;
+        if (header->magic != MESH_FILE_MAGIC) {
+            error = "Not a mesh file: ";
+        } else if (header->version != MESH_FILE_VERSION) {
+            error = "Unsupported mesh file version: ";
+        } else if (header->vertex_size == 0 || (header->index_size != 2 && header->index_size != 4)) {
+            error = "Mesh file has an invalid vertex or index size: ";
+        } else if (
+            tables_end > size ||
+            header->vertex_offset < tables_end ||
+            header->vertex_offset > size ||
+            header->vertex_offset % MESH_FILE_ALIGNMENT != 0 ||
+            header->index_offset % MESH_FILE_ALIGNMENT != 0 ||
+            header->vertex_bytes > size - header->vertex_offset ||
+            header->index_offset > size ||
+            header->index_bytes > size - header->index_offset ||
+            header->vertex_bytes % header->vertex_size != 0 ||
+            header->index_bytes % header->index_size != 0
+        ) {
+            error = "Mesh file is truncated or corrupt: ";
+        } else if (header->vertex_bytes / header->vertex_size > UINT32_MAX || header->index_bytes / header->index_size > UINT32_MAX) {
+            error = "Mesh file has more vertices or indices than fit in 32 bits: ";
+        } else if (!IndicesInRange()) {
+            error = "Mesh file has an index out of range of its vertices: ";
+        } else {
+            for (uint32_t i = 0; i < header->lod_count; i++) {
+                const MeshFileLod& lod = get_lods()[i];
+                if (static_cast<uint64_t>(lod.first_index) + lod.index_count > get_num_indices()) {
+                    error = "Mesh file has an out of range level of detail: ";
+                    break;
+                }
+            }
+        }
+
+        if (error != nullptr) {
+            throw std::runtime_error(error + path);
+        }
+
+        for (uint32_t i = 0; i < header->lod_count; i++) {
+            const MeshFileLod& lod = get_lods()[i];
+            lods.push_back({.first_index = lod.first_index, .index_count = lod.index_count, .error = lod.error});
+        }
+    }
+
+    MeshFile::~MeshFile() { }
+
+    bool MeshFile::IndicesInRange() const {
+        uint32_t num_vertices = get_num_vertices();
+        uint32_t num_indices = get_num_indices();
+
+        // only the largest matters, which keeps the scan free of branches
+        uint32_t max_index = 0;
+        if (header->index_size == 2) {
+            const uint16_t* indices = static_cast<const uint16_t*>(get_indices());
+            for (uint32_t i = 0; i < num_indices; i++) {
+                max_index = std::max<uint32_t>(max_index, indices[i]);
+            }
+        } else {
+            const uint32_t* indices = static_cast<const uint32_t*>(get_indices());
+            for (uint32_t i = 0; i < num_indices; i++) {
+                max_index = std::max(max_index, indices[i]);
+            }
+        }
+
+        return num_indices == 0 || max_index < num_vertices;
+    }
+
+    void MeshFile::Write(const std::string& path, const MeshFileWriteInfo& write_info) {
+        if (write_info.index_size != 2 && write_info.index_size != 4) {
+            throw std::runtime_error("Mesh file indices must be either 16 or 32 bits!");
+        }
+
+        MeshFileLod full_lod = {
+            .first_index = 0,
+            .index_count = write_info.num_indices,
+            .error = 0.0f,
+            .reserved = 0
+        };
+
+        const MeshFileLod* lods = write_info.lod_count > 0 ? write_info.lods : &full_lod;
+        uint32_t lod_count = write_info.lod_count > 0 ? write_info.lod_count : 1;
+
+        uint64_t tables_end = sizeof(MeshFileHeader) +
+                              sizeof(MeshFileAttribute) * static_cast<uint64_t>(write_info.attribute_count) +
+                              sizeof(MeshFileLod) * static_cast<uint64_t>(lod_count);
+
+        MeshFileHeader header = {
+            .magic = MESH_FILE_MAGIC,
+            .version = MESH_FILE_VERSION,
+            .vertex_size = write_info.vertex_size,
+            .index_size = write_info.index_size,
+            .attribute_count = write_info.attribute_count,
+            .lod_count = lod_count,
+            .vertex_offset = Utils::align_up(tables_end, MESH_FILE_ALIGNMENT),
+            .vertex_bytes = static_cast<uint64_t>(write_info.vertex_size) * write_info.num_vertices,
+            .index_offset = 0,
+            .index_bytes = static_cast<uint64_t>(write_info.index_size) * write_info.num_indices
+        };
+        header.index_offset = Utils::align_up(header.vertex_offset + header.vertex_bytes, MESH_FILE_ALIGNMENT);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file for writing: " + path);
+        }
+
+        const char padding[MESH_FILE_ALIGNMENT] = {};
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(write_info.attributes), sizeof(MeshFileAttribute) * write_info.attribute_count);
+        file.write(reinterpret_cast<const char*>(lods), sizeof(MeshFileLod) * lod_count);
+        file.write(padding, static_cast<std::streamsize>(header.vertex_offset - tables_end));
+        file.write(static_cast<const char*>(write_info.vertices), static_cast<std::streamsize>(header.vertex_bytes));
+        file.write(padding, static_cast<std::streamsize>(header.index_offset - header.vertex_offset - header.vertex_bytes));
+        file.write(static_cast<const char*>(write_info.indices), static_cast<std::streamsize>(header.index_bytes));
+
+        if (!file.good()) {
+            throw std::runtime_error("Failed to write file: " + path);
+        }
+    }
+
+    MeshCreateInfo MeshFile::get_mesh_create_info() const {
+        MeshCreateInfo create_info = {
+            .vertices = get_vertices(),
+            .vertex_size = header->vertex_size,
+            .num_vertices = get_num_vertices(),
+            .indices = get_indices(),
+            .index_size = header->index_size,
+            .num_indices = get_num_indices(),
+            .lods = lods.data(),
+            .lod_count = static_cast<uint32_t>(lods.size())
+        };
+
+        return create_info;
+    }
+
+    VkVertexInputBindingDescription MeshFile::get_binding_description(uint32_t binding) const {
+        VkVertexInputBindingDescription description = {
+            .binding = binding,
+            .stride = header->vertex_size,
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+        };
+
+        return description;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> MeshFile::get_attribute_descriptions(uint32_t binding) const {
+        std::vector<VkVertexInputAttributeDescription> descriptions(header->attribute_count);
+        for (uint32_t i = 0; i < header->attribute_count; i++) {
+            descriptions[i] = {
+                .location = get_attributes()[i].location,
+                .binding = binding,
+                .format = static_cast<VkFormat>(get_attributes()[i].format),
+                .offset = get_attributes()[i].offset
+            };
+        }
+
+        return descriptions;
+    }
+
+    const MeshFileHeader& MeshFile::get_header() const { return *header; }
+
+    const MeshFileAttribute* MeshFile::get_attributes() const {
+        return reinterpret_cast<const MeshFileAttribute*>(static_cast<const uint8_t*>(mapping.get_data()) + sizeof(MeshFileHeader));
+    }
+
+    const MeshFileLod* MeshFile::get_lods() const {
+        return reinterpret_cast<const MeshFileLod*>(get_attributes() + header->attribute_count);
+    }
+
+    const void* MeshFile::get_vertices() const { return static_cast<const uint8_t*>(mapping.get_data()) + header->vertex_offset; }
+    const void* MeshFile::get_indices() const { return static_cast<const uint8_t*>(mapping.get_data()) + header->index_offset; }
+    uint32_t MeshFile::get_num_vertices() const { return static_cast<uint32_t>(header->vertex_bytes / header->vertex_size); }
+    uint32_t MeshFile::get_num_indices() const { return static_cast<uint32_t>(header->index_bytes / header->index_size); }
+}
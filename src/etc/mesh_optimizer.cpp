@@ -0,0 +1,500 @@
+#include "etc/mesh_optimizer.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <atomic>
+#include <exception>
+
+namespace rt {
+    constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+    constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+    // ~~~ helpers ~~~
+
+    static std::vector<uint32_t> read_indices(const MeshCreateInfo& source) {
+        if (source.index_size != 2 && source.index_size != 4) {
+            throw std::runtime_error("Mesh indices must be either 16 or 32 bits!");
+        }
+
+        // an empty mesh may not have an index pointer at all
+        std::vector<uint32_t> indices(source.num_indices);
+        if (source.num_indices == 0) {
+            return indices;
+        }
+
+        if (source.index_size == 2) {
+            const uint16_t* short_indices = static_cast<const uint16_t*>(source.indices);
+            std::copy(short_indices, short_indices + source.num_indices, indices.begin());
+        } else {
+            std::memcpy(indices.data(), source.indices, sizeof(uint32_t) * source.num_indices);
+        }
+
+        for (uint32_t index : indices) {
+            if (index >= source.num_vertices) {
+                throw std::runtime_error("Mesh index is out of range of its vertices!");
+            }
+        }
+
+        return indices;
+    }
+
+    // vertex -> triangles, laid out flat with an offset per vertex
+    struct Adjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+        std::vector<uint32_t> counts;
+    };
+
+    static Adjacency build_adjacency(const std::vector<uint32_t>& indices, uint32_t num_vertices) {
+        Adjacency adjacency;
+        adjacency.counts.assign(num_vertices, 0);
+        for (uint32_t index : indices) {
+            adjacency.counts[index]++;
+        }
+
+        adjacency.offsets.resize(num_vertices + 1);
+        adjacency.offsets[0] = 0;
+        for (uint32_t v = 0; v < num_vertices; v++) {
+            adjacency.offsets[v + 1] = adjacency.offsets[v] + adjacency.counts[v];
+        }
+
+        std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        adjacency.triangles.resize(indices.size());
+        for (uint32_t i = 0; i < indices.size(); i++) {
+            adjacency.triangles[cursor[indices[i]]++] = i / 3;
+        }
+
+        return adjacency;
+    }
+
+    // ~~~ tipsify ~~~
+
+    // returns triangle order, cluster_starts gets the output triangle
+    //   index of every spot where the fan had to jump somewhere non local
+    static std::vector<uint32_t> tipsify(
+        const std::vector<uint32_t>& indices,
+        uint32_t num_vertices,
+        uint32_t cache_size,
+        std::vector<uint32_t>* cluster_starts
+    ) {
+        uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+        Adjacency adjacency = build_adjacency(indices, num_vertices);
+
+        // live triangle counts go down as triangles get emitted
+        std::vector<uint32_t> live = adjacency.counts;
+        std::vector<uint32_t> cache_time(num_vertices, 0);
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<uint32_t> dead_end;
+        std::vector<uint32_t> candidates;
+
+        std::vector<uint32_t> order;
+        order.reserve(triangle_count);
+
+        // starting past the cache size means nothing is cached yet
+        uint32_t time = cache_size + 1;
+        uint32_t cursor = 0;
+        int64_t fan = num_vertices > 0 ? 0 : -1;
+        bool jumped = true;
+
+        while (fan >= 0) {
+            if (jumped) {
+                cluster_starts->push_back(static_cast<uint32_t>(order.size()));
+                jumped = false;
+            }
+
+            candidates.clear();
+
+            // emit every remaining triangle around the fanning vertex
+            for (uint32_t i = adjacency.offsets[fan]; i < adjacency.offsets[fan + 1]; i++) {
+                uint32_t triangle = adjacency.triangles[i];
+                if (emitted[triangle]) {
+                    continue;
+                }
+
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    uint32_t v = indices[triangle * 3 + corner];
+                    dead_end.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+
+                    if (time - cache_time[v] > cache_size) {
+                        cache_time[v] = time;
+                        time++;
+                    }
+                }
+
+                emitted[triangle] = true;
+                order.push_back(triangle);
+            }
+
+            // next fan is the candidate that will still be in the cache
+            //   after its remaining triangles are emitted, and oldest in it.
+            //   anything that won't stay cached goes through the dead end
+            //   stack instead, like in the paper
+            int64_t best = -1;
+            int64_t best_priority = 0;
+            for (uint32_t v : candidates) {
+                if (live[v] == 0) {
+                    continue;
+                }
+
+                int64_t priority = 0;
+                if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+                    priority = time - cache_time[v];
+                }
+
+                if (priority > best_priority) {
+                    best = v;
+                    best_priority = priority;
+                }
+            }
+
+            if (best >= 0) {
+                fan = best;
+                continue;
+            }
+
+            // dead end, back track through recently used vertices first
+            //   then fall back to scanning for anything left
+            fan = -1;
+            jumped = true;
+            while (!dead_end.empty()) {
+                uint32_t v = dead_end.back();
+                dead_end.pop_back();
+                if (live[v] > 0) {
+                    fan = v;
+                    break;
+                }
+            }
+
+            while (fan < 0 && cursor < num_vertices) {
+                if (live[cursor] > 0) {
+                    fan = cursor;
+                }
+                cursor++;
+            }
+        }
+
+        return order;
+    }
+
+    // ~~~ overdraw ~~~
+
+    static void read_position(const std::vector<uint8_t>& vertices, uint32_t vertex_size, uint32_t offset, uint32_t index, float out[3]) {
+        std::memcpy(out, vertices.data() + static_cast<size_t>(vertex_size) * index + offset, sizeof(float) * 3);
+    }
+
+    // sorts clusters by how much they face away from the mesh's center,
+    //   outward facing clusters are the likeliest to occlude the rest
+    static std::vector<uint32_t> sort_clusters(
+        const std::vector<uint32_t>& indices,
+        const std::vector<uint32_t>& order,
+        const std::vector<uint32_t>& cluster_starts,
+        const std::vector<uint8_t>& vertices,
+        uint32_t vertex_size,
+        uint32_t position_offset
+    ) {
+        struct Cluster {
+            uint32_t begin;
+            uint32_t end;
+            float centroid[3];
+            float normal[3];
+            float area;
+            float sort_key;
+        };
+
+        std::vector<Cluster> clusters;
+        float mesh_centroid[3] = {0.0f, 0.0f, 0.0f};
+        float mesh_area = 0.0f;
+
+        for (size_t c = 0; c < cluster_starts.size(); c++) {
+            Cluster cluster = {};
+            cluster.begin = cluster_starts[c];
+            cluster.end = c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : static_cast<uint32_t>(order.size());
+
+            for (uint32_t t = cluster.begin; t < cluster.end; t++) {
+                float p[3][3];
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    read_position(vertices, vertex_size, position_offset, indices[order[t] * 3 + corner], p[corner]);
+                }
+
+                float e1[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+                float e2[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+                float n[3] = {
+                    e1[1] * e2[2] - e1[2] * e2[1],
+                    e1[2] * e2[0] - e1[0] * e2[2],
+                    e1[0] * e2[1] - e1[1] * e2[0]
+                };
+
+                // cross product length is twice the area, the factor cancels out
+                float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    cluster.centroid[axis] += (p[0][axis] + p[1][axis] + p[2][axis]) / 3.0f * area;
+                    cluster.normal[axis] += n[axis];
+                }
+                cluster.area += area;
+            }
+
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                mesh_centroid[axis] += cluster.centroid[axis];
+            }
+            mesh_area += cluster.area;
+
+            if (cluster.area > 0.0f) {
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    cluster.centroid[axis] /= cluster.area;
+                }
+            }
+
+            clusters.push_back(cluster);
+        }
+
+        if (mesh_area > 0.0f) {
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                mesh_centroid[axis] /= mesh_area;
+            }
+        }
+
+        for (auto& cluster : clusters) {
+            float length = std::sqrt(
+                cluster.normal[0] * cluster.normal[0] +
+                cluster.normal[1] * cluster.normal[1] +
+                cluster.normal[2] * cluster.normal[2]
+            );
+
+            cluster.sort_key = 0.0f;
+            if (length > 0.0f) {
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    cluster.sort_key += (cluster.centroid[axis] - mesh_centroid[axis]) * cluster.normal[axis] / length;
+                }
+            }
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+            return a.sort_key > b.sort_key;
+        });
+
+        std::vector<uint32_t> sorted;
+        sorted.reserve(order.size());
+        for (const auto& cluster : clusters) {
+            sorted.insert(sorted.end(), order.begin() + cluster.begin, order.begin() + cluster.end);
+        }
+
+        return sorted;
+    }
+
+    static std::vector<uint32_t> apply_order(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& order) {
+        std::vector<uint32_t> reordered(indices.size());
+        for (uint32_t t = 0; t < order.size(); t++) {
+            std::copy_n(indices.begin() + order[t] * 3, 3, reordered.begin() + t * 3);
+        }
+
+        return reordered;
+    }
+
+    // ~~~ public ~~~
+
+    MeshCacheStats MeshOptimizer::AnalyzeCache(const uint32_t* indices, uint32_t num_indices, uint32_t num_vertices, uint32_t cache_size) {
+        if (cache_size == 0) {
+            cache_size = DEFAULT_CACHE_SIZE;
+        }
+
+        // same timestamp trick as tipsify, a vertex is cached if it
+        //   was last transformed within the last cache_size misses
+        std::vector<uint32_t> cache_time(num_vertices, 0);
+        uint32_t time = cache_size + 1;
+        uint32_t misses = 0;
+
+        for (uint32_t i = 0; i < num_indices; i++) {
+            uint32_t v = indices[i];
+            if (v >= num_vertices) {
+                throw std::runtime_error("Mesh index is out of range of its vertices!");
+            }
+
+            if (time - cache_time[v] > cache_size) {
+                cache_time[v] = time;
+                time++;
+                misses++;
+            }
+        }
+
+        uint32_t triangle_count = num_indices / 3;
+        MeshCacheStats stats = {
+            .acmr = triangle_count > 0 ? static_cast<float>(misses) / triangle_count : 0.0f,
+            .atvr = num_vertices > 0 ? static_cast<float>(misses) / num_vertices : 0.0f
+        };
+
+        return stats;
+    }
+
+    OptimizedMesh MeshOptimizer::Optimize(const MeshCreateInfo& source, const MeshOptimizerSettings& settings) {
+        if (source.num_indices % 3 != 0) {
+            throw std::runtime_error("Only triangle lists can be optimized!");
+        }
+
+        if (settings.optimize_overdraw && settings.position_offset + sizeof(float) * 3 > source.vertex_size) {
+            throw std::runtime_error("Mesh position offset is outside of its vertices!");
+        }
+
+        uint32_t cache_size = settings.cache_size > 0 ? settings.cache_size : DEFAULT_CACHE_SIZE;
+        uint32_t vertex_size = static_cast<uint32_t>(source.vertex_size);
+
+        OptimizedMesh result = {};
+        result.vertex_size = vertex_size;
+        result.num_vertices = source.num_vertices;
+        result.num_indices = source.num_indices;
+
+        const uint8_t* source_vertices = static_cast<const uint8_t*>(source.vertices);
+        result.vertices.assign(source_vertices, source_vertices + static_cast<size_t>(vertex_size) * source.num_vertices);
+
+        std::vector<uint32_t> indices = read_indices(source);
+        result.before = AnalyzeCache(indices.data(), source.num_indices, source.num_vertices, cache_size);
+
+        // nothing to reorder, the vertices are passed through as they are
+        if (indices.empty()) {
+            result.after = result.before;
+            result.index_size = static_cast<uint32_t>(source.index_size);
+            return result;
+        }
+
+        // ~~~ triangle order ~~~
+
+        std::vector<uint32_t> cluster_starts;
+        std::vector<uint32_t> order = tipsify(indices, source.num_vertices, cache_size, &cluster_starts);
+        std::vector<uint32_t> optimized = apply_order(indices, order);
+
+        if (settings.optimize_overdraw && cluster_starts.size() > 1) {
+            std::vector<uint32_t> sorted = apply_order(
+                indices,
+                sort_clusters(indices, order, cluster_starts, result.vertices, vertex_size, settings.position_offset)
+            );
+
+            // clusters break up cache locality where they get shuffled,
+            //   so only keep the new order if that didn't cost too much
+            float threshold = settings.overdraw_threshold >= 1.0f ? settings.overdraw_threshold : DEFAULT_OVERDRAW_THRESHOLD;
+            float tipsify_acmr = AnalyzeCache(optimized.data(), source.num_indices, source.num_vertices, cache_size).acmr;
+            float sorted_acmr = AnalyzeCache(sorted.data(), source.num_indices, source.num_vertices, cache_size).acmr;
+
+            if (sorted_acmr <= tipsify_acmr * threshold) {
+                optimized = std::move(sorted);
+            }
+        }
+
+        // ~~~ vertex order ~~~
+
+        if (settings.optimize_vertex_fetch) {
+            constexpr uint32_t UNUSED = UINT32_MAX;
+            std::vector<uint32_t> remap(source.num_vertices, UNUSED);
+            uint32_t next_vertex = 0;
+
+            for (uint32_t& index : optimized) {
+                if (remap[index] == UNUSED) {
+                    remap[index] = next_vertex++;
+                }
+                index = remap[index];
+            }
+
+            std::vector<uint8_t> fetch_ordered(static_cast<size_t>(vertex_size) * next_vertex);
+            for (uint32_t v = 0; v < source.num_vertices; v++) {
+                if (remap[v] != UNUSED) {
+                    std::memcpy(
+                        fetch_ordered.data() + static_cast<size_t>(vertex_size) * remap[v],
+                        result.vertices.data() + static_cast<size_t>(vertex_size) * v,
+                        vertex_size
+                    );
+                }
+            }
+
+            result.vertices = std::move(fetch_ordered);
+            result.num_vertices = next_vertex;
+        }
+
+        result.after = AnalyzeCache(optimized.data(), source.num_indices, result.num_vertices, cache_size);
+
+        // ~~~ index output ~~~
+
+        // 0xFFFF is left alone since it restarts primitives when enabled
+        bool use_short = source.index_size == 2 || (settings.downcast_indices && result.num_vertices < UINT16_MAX);
+        if (use_short) {
+            result.index_size = 2;
+            result.indices.resize(sizeof(uint16_t) * optimized.size());
+
+            uint16_t* short_indices = reinterpret_cast<uint16_t*>(result.indices.data());
+            for (size_t i = 0; i < optimized.size(); i++) {
+                short_indices[i] = static_cast<uint16_t>(optimized[i]);
+            }
+        } else {
+            result.index_size = 4;
+            result.indices.resize(sizeof(uint32_t) * optimized.size());
+            std::memcpy(result.indices.data(), optimized.data(), result.indices.size());
+        }
+
+        return result;
+    }
+
+    std::vector<OptimizedMesh> MeshOptimizer::OptimizeAll(
+        const MeshCreateInfo* sources,
+        uint32_t source_count,
+        const MeshOptimizerSettings& settings,
+        uint32_t thread_count
+    ) {
+        std::vector<OptimizedMesh> results(source_count);
+
+        if (thread_count == 0) {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        thread_count = std::min(thread_count, source_count);
+
+        // meshes vary a lot in size, so workers pull the next one
+        //   whenever they finish rather than getting a fixed share
+        std::atomic<uint32_t> next(0);
+        std::vector<std::exception_ptr> errors(source_count);
+
+        auto work = [&] {
+            uint32_t i;
+            while ((i = next.fetch_add(1)) < source_count) {
+                try {
+                    results[i] = Optimize(sources[i], settings);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < thread_count; i++) {
+            workers.emplace_back(work);
+        }
+        // the calling thread pitches in too
+        work();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        for (auto& error : errors) {
+            if (error != nullptr) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        return results;
+    }
+
+    MeshCreateInfo OptimizedMesh::get_mesh_create_info(const MeshCreateInfo& base) const {
+        MeshCreateInfo create_info = base;
+        create_info.vertices = vertices.data();
+        create_info.vertex_size = vertex_size;
+        create_info.num_vertices = num_vertices;
+        create_info.indices = indices.data();
+        create_info.index_size = index_size;
+        create_info.num_indices = num_indices;
+
+        return create_info;
+    }
+}
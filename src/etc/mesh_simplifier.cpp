@@ -0,0 +1,488 @@
+#include "etc/mesh_simplifier.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
+namespace rt {
+    constexpr uint32_t DEFAULT_LOD_COUNT = 4;
+    constexpr float DEFAULT_REDUCTION = 0.5f;
+    // a level that removes less than this share of its parent's
+    //   triangles isn't worth the memory and ends the chain
+    constexpr float MIN_LEVEL_REDUCTION = 0.05f;
+
+    // ~~~ quadrics ~~~
+
+    // symmetric 4x4 matrix of the squared distance to a set of planes,
+    //   weight is the summed area so errors come back as distances
+    struct Quadric {
+        double a2, ab, ac, ad;
+        double b2, bc, bd;
+        double c2, cd;
+        double d2;
+        double weight;
+
+        void Add(const Quadric& other) {
+            a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+            b2 += other.b2; bc += other.bc; bd += other.bd;
+            c2 += other.c2; cd += other.cd;
+            d2 += other.d2;
+            weight += other.weight;
+        }
+
+        // root mean squared distance of p to the planes
+        double Error(const float p[3]) const {
+            double x = p[0], y = p[1], z = p[2];
+            double error = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+                           b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+                           c2 * z * z + 2 * cd * z +
+                           d2;
+
+            return weight > 0.0 ? std::sqrt(std::max(error, 0.0) / weight) : 0.0;
+        }
+    };
+
+    static Quadric plane_quadric(const float p0[3], const float p1[3], const float p2[3]) {
+        double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        double n[3] = {
+            e1[1] * e2[2] - e1[2] * e2[1],
+            e1[2] * e2[0] - e1[0] * e2[2],
+            e1[0] * e2[1] - e1[1] * e2[0]
+        };
+
+        double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0.0) {
+            return Quadric{};
+        }
+
+        double a = n[0] / length, b = n[1] / length, c = n[2] / length;
+        double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+        double area = length * 0.5;
+
+        Quadric quadric = {
+            .a2 = a * a * area, .ab = a * b * area, .ac = a * c * area, .ad = a * d * area,
+            .b2 = b * b * area, .bc = b * c * area, .bd = b * d * area,
+            .c2 = c * c * area, .cd = c * d * area,
+            .d2 = d * d * area,
+            .weight = area
+        };
+
+        return quadric;
+    }
+
+    static void triangle_normal(const float p0[3], const float p1[3], const float p2[3], float out[3]) {
+        float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        out[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        out[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        out[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    // ~~~ simplifier ~~~
+
+    // collapses work on positions, vertices split by other attributes
+    //   (uv seams, hard normals) all move together so seams stay closed
+    struct SimplifyState {
+        std::vector<float> positions;
+        // first vertex found at each vertex's position, quadrics and
+        //   locks are only kept for these
+        std::vector<uint32_t> canonical;
+        // ring through every vertex sharing a position
+        std::vector<uint32_t> next_twin;
+        std::vector<Quadric> quadrics;
+        // border vertices never move, collapsing them would pull the
+        //   open edge inwards
+        std::vector<bool> locked;
+    };
+
+    // from and to are canonical vertices
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double error;
+    };
+
+    static SimplifyState build_state(const MeshCreateInfo& source, uint32_t position_offset, const std::vector<uint32_t>& indices) {
+        SimplifyState state;
+        state.positions.resize(static_cast<size_t>(source.num_vertices) * 3);
+        state.quadrics.assign(source.num_vertices, Quadric{});
+        state.locked.assign(source.num_vertices, false);
+        state.canonical.resize(source.num_vertices);
+        state.next_twin.resize(source.num_vertices);
+
+        const uint8_t* vertices = static_cast<const uint8_t*>(source.vertices);
+        for (uint32_t v = 0; v < source.num_vertices; v++) {
+            std::memcpy(&state.positions[v * 3], vertices + source.vertex_size * v + position_offset, sizeof(float) * 3);
+        }
+
+        struct PositionHash {
+            size_t operator()(const std::array<float, 3>& p) const {
+                uint32_t bits[3];
+                std::memcpy(bits, p.data(), sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+
+        std::unordered_map<std::array<float, 3>, uint32_t, PositionHash> first_at_position;
+        std::vector<uint32_t>& canonical = state.canonical;
+        for (uint32_t v = 0; v < source.num_vertices; v++) {
+            std::array<float, 3> p = {state.positions[v * 3], state.positions[v * 3 + 1], state.positions[v * 3 + 2]};
+            auto [it, inserted] = first_at_position.emplace(p, v);
+            canonical[v] = it->second;
+            state.next_twin[v] = v;
+            if (!inserted) {
+                state.next_twin[v] = state.next_twin[it->second];
+                state.next_twin[it->second] = v;
+            }
+        }
+
+        // border edges only have a triangle on one side
+        std::unordered_map<uint64_t, uint32_t> edge_counts;
+        for (size_t t = 0; t < indices.size(); t += 3) {
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                uint32_t a = canonical[indices[t + corner]];
+                uint32_t b = canonical[indices[t + (corner + 1) % 3]];
+                edge_counts[static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b)]++;
+            }
+
+            Quadric quadric = plane_quadric(
+                &state.positions[indices[t] * 3],
+                &state.positions[indices[t + 1] * 3],
+                &state.positions[indices[t + 2] * 3]
+            );
+
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                state.quadrics[canonical[indices[t + corner]]].Add(quadric);
+            }
+        }
+
+        for (const auto& [edge, count] : edge_counts) {
+            if (count == 1) {
+                state.locked[static_cast<uint32_t>(edge >> 32)] = true;
+                state.locked[static_cast<uint32_t>(edge)] = true;
+            }
+        }
+
+        // locking a canonical vertex has to lock its twins too
+        for (uint32_t v = 0; v < source.num_vertices; v++) {
+            if (state.locked[canonical[v]]) {
+                state.locked[v] = true;
+            }
+        }
+
+        return state;
+    }
+
+    static bool has_position(const SimplifyState& state, const uint32_t* triangle, uint32_t position) {
+        return state.canonical[triangle[0]] == position || state.canonical[triangle[1]] == position || state.canonical[triangle[2]] == position;
+    }
+
+    // would moving from onto to flip (or flatten) any triangle around from
+    static bool collapse_flips(const SimplifyState& state, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangles, uint32_t from, uint32_t to) {
+        for (uint32_t t : triangles) {
+            const uint32_t* triangle = &indices[t * 3];
+            if (has_position(state, triangle, to)) {
+                continue;
+            }
+
+            const float* before[3];
+            const float* after[3];
+            for (uint32_t corner = 0; corner < 3; corner++) {
+                before[corner] = &state.positions[triangle[corner] * 3];
+                after[corner] = state.canonical[triangle[corner]] == from ? &state.positions[to * 3] : before[corner];
+            }
+
+            float n_before[3], n_after[3];
+            triangle_normal(before[0], before[1], before[2], n_before);
+            triangle_normal(after[0], after[1], after[2], n_after);
+
+            if (n_before[0] * n_after[0] + n_before[1] * n_after[1] + n_before[2] * n_after[2] <= 0.0f) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // collapses edges cheapest first until the index count reaches target,
+    //   returns the largest error any collapse introduced
+    static double simplify(SimplifyState& state, std::vector<uint32_t>& indices, size_t target_index_count, double max_error) {
+        uint32_t num_vertices = static_cast<uint32_t>(state.locked.size());
+        double level_error = 0.0;
+
+        while (indices.size() > target_index_count) {
+            // ~~~ candidate collapses, each edge in its cheaper direction ~~~
+
+            std::vector<uint64_t> edges;
+            edges.reserve(indices.size());
+            for (size_t t = 0; t < indices.size(); t += 3) {
+                for (uint32_t corner = 0; corner < 3; corner++) {
+                    uint32_t a = state.canonical[indices[t + corner]];
+                    uint32_t b = state.canonical[indices[t + (corner + 1) % 3]];
+                    edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            std::vector<Collapse> collapses;
+            for (uint64_t edge : edges) {
+                uint32_t a = static_cast<uint32_t>(edge >> 32);
+                uint32_t b = static_cast<uint32_t>(edge);
+                if (a == b) {
+                    continue;
+                }
+
+                Quadric combined = state.quadrics[a];
+                combined.Add(state.quadrics[b]);
+
+                Collapse best = {.from = 0, .to = 0, .error = -1.0};
+                if (!state.locked[a]) {
+                    best = {.from = a, .to = b, .error = combined.Error(&state.positions[b * 3])};
+                }
+                if (!state.locked[b]) {
+                    double error = combined.Error(&state.positions[a * 3]);
+                    if (best.error < 0.0 || error < best.error) {
+                        best = {.from = b, .to = a, .error = error};
+                    }
+                }
+
+                if (best.error >= 0.0 && (max_error <= 0.0 || best.error <= max_error)) {
+                    collapses.push_back(best);
+                }
+            }
+
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+                return a.error < b.error;
+            });
+
+            // ~~~ vertex -> triangle adjacency ~~~
+
+            std::vector<uint32_t> offsets(num_vertices + 1, 0);
+            for (uint32_t index : indices) {
+                offsets[index + 1]++;
+            }
+            for (uint32_t v = 0; v < num_vertices; v++) {
+                offsets[v + 1] += offsets[v];
+            }
+
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            std::vector<uint32_t> adjacency(indices.size());
+            for (size_t i = 0; i < indices.size(); i++) {
+                adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            // ~~~ collapse ~~~
+
+            // a collapse touches every triangle around from, nothing else
+            //   in that neighbourhood moves again this pass so the flip
+            //   test above always sees up to date triangles
+            std::vector<uint32_t> remap(num_vertices);
+            for (uint32_t v = 0; v < num_vertices; v++) {
+                remap[v] = v;
+            }
+            std::vector<bool> touched(num_vertices, false);
+
+            size_t triangle_count = indices.size() / 3;
+            size_t target_triangles = target_index_count / 3;
+            size_t collapsed = 0;
+
+            for (const auto& collapse : collapses) {
+                if (triangle_count <= target_triangles) {
+                    break;
+                }
+
+                if (touched[collapse.from] || touched[collapse.to]) {
+                    continue;
+                }
+
+                std::vector<uint32_t> triangles;
+                uint32_t twin = collapse.from;
+                do {
+                    triangles.insert(triangles.end(), adjacency.begin() + offsets[twin], adjacency.begin() + offsets[twin + 1]);
+                    twin = state.next_twin[twin];
+                } while (twin != collapse.from);
+
+                if (collapse_flips(state, indices, triangles, collapse.from, collapse.to)) {
+                    continue;
+                }
+
+                for (uint32_t t : triangles) {
+                    const uint32_t* triangle = &indices[t * 3];
+                    if (has_position(state, triangle, collapse.to)) {
+                        triangle_count--;
+                    }
+
+                    for (uint32_t corner = 0; corner < 3; corner++) {
+                        touched[state.canonical[triangle[corner]]] = true;
+                    }
+                }
+
+                // each twin follows the edge it shares with a twin of to so
+                //   attributes carry across the seam, twins with no such
+                //   edge land on to itself
+                twin = collapse.from;
+                do {
+                    remap[twin] = collapse.to;
+                    for (uint32_t i = offsets[twin]; i < offsets[twin + 1]; i++) {
+                        const uint32_t* triangle = &indices[adjacency[i] * 3];
+                        for (uint32_t corner = 0; corner < 3; corner++) {
+                            if (state.canonical[triangle[corner]] == collapse.to) {
+                                remap[twin] = triangle[corner];
+                            }
+                        }
+                    }
+                    twin = state.next_twin[twin];
+                } while (twin != collapse.from);
+
+                state.quadrics[collapse.to].Add(state.quadrics[collapse.from]);
+                level_error = std::max(level_error, collapse.error);
+                collapsed++;
+            }
+
+            if (collapsed == 0) {
+                break;
+            }
+
+            // drop triangles that lost an edge, twins on either side of a
+            //   seam can land on different vertices at the same position
+            size_t write = 0;
+            for (size_t t = 0; t < indices.size(); t += 3) {
+                uint32_t a = remap[indices[t]];
+                uint32_t b = remap[indices[t + 1]];
+                uint32_t c = remap[indices[t + 2]];
+                if (state.canonical[a] == state.canonical[b] || state.canonical[b] == state.canonical[c] || state.canonical[c] == state.canonical[a]) {
+                    continue;
+                }
+
+                indices[write++] = a;
+                indices[write++] = b;
+                indices[write++] = c;
+            }
+            indices.resize(write);
+        }
+
+        return level_error;
+    }
+
+    // ~~~ public ~~~
+
+    MeshLodChain MeshSimplifier::GenerateLods(const MeshCreateInfo& source, const MeshLodSettings& settings) {
+        if (source.index_size != 2 && source.index_size != 4) {
+            throw std::runtime_error("Mesh indices must be either 16 or 32 bits!");
+        }
+
+        if (source.num_indices % 3 != 0) {
+            throw std::runtime_error("Only triangle lists can be simplified!");
+        }
+
+        if (settings.position_offset + sizeof(float) * 3 > source.vertex_size) {
+            throw std::runtime_error("Mesh position offset is outside of its vertices!");
+        }
+
+        uint32_t max_lod_count = settings.max_lod_count > 0 ? settings.max_lod_count : DEFAULT_LOD_COUNT;
+        float reduction = settings.reduction > 0.0f && settings.reduction < 1.0f ? settings.reduction : DEFAULT_REDUCTION;
+
+        // an empty mesh is its own only level, and may not have index
+        //   or vertex pointers at all
+        if (source.num_indices == 0) {
+            MeshLodChain result = {};
+            result.lods.push_back({.first_index = 0, .index_count = 0, .error = 0.0f});
+            result.index_size = static_cast<uint32_t>(source.index_size);
+            result.num_indices = 0;
+            return result;
+        }
+
+        std::vector<uint32_t> indices(source.num_indices);
+        if (source.index_size == 2) {
+            const uint16_t* short_indices = static_cast<const uint16_t*>(source.indices);
+            std::copy(short_indices, short_indices + source.num_indices, indices.begin());
+        } else {
+            std::memcpy(indices.data(), source.indices, sizeof(uint32_t) * source.num_indices);
+        }
+
+        for (uint32_t index : indices) {
+            if (index >= source.num_vertices) {
+                throw std::runtime_error("Mesh index is out of range of its vertices!");
+            }
+        }
+
+        SimplifyState state = build_state(source, settings.position_offset, indices);
+
+        // errors are stored relative to the bounding box diagonal
+        float min[3] = {INFINITY, INFINITY, INFINITY};
+        float max[3] = {-INFINITY, -INFINITY, -INFINITY};
+        for (uint32_t v = 0; v < source.num_vertices; v++) {
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                min[axis] = std::min(min[axis], state.positions[v * 3 + axis]);
+                max[axis] = std::max(max[axis], state.positions[v * 3 + axis]);
+            }
+        }
+
+        double scale = 0.0;
+        if (source.num_vertices > 0) {
+            double dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+            scale = std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+        double max_error = settings.max_error > 0.0f ? settings.max_error * scale : 0.0;
+
+        // ~~~ build the chain, each level simplifies the one before it ~~~
+
+        std::vector<uint32_t> chain = indices;
+        MeshLodChain result = {};
+        result.lods.push_back({.first_index = 0, .index_count = source.num_indices, .error = 0.0f});
+
+        double error = 0.0;
+        while (result.lods.size() < max_lod_count && scale > 0.0) {
+            size_t previous_count = indices.size();
+            size_t target = static_cast<size_t>(previous_count / 3 * reduction) * 3;
+
+            double level_error = simplify(state, indices, target, max_error);
+            if (indices.empty() || indices.size() > previous_count * (1.0f - MIN_LEVEL_REDUCTION)) {
+                break;
+            }
+
+            // each level is at least as wrong as the ones it was built from
+            error = std::max(error, level_error);
+
+            result.lods.push_back({
+                .first_index = static_cast<uint32_t>(chain.size()),
+                .index_count = static_cast<uint32_t>(indices.size()),
+                .error = static_cast<float>(error / scale)
+            });
+            chain.insert(chain.end(), indices.begin(), indices.end());
+        }
+
+        // ~~~ output, same index size as the source ~~~
+
+        result.index_size = static_cast<uint32_t>(source.index_size);
+        result.num_indices = static_cast<uint32_t>(chain.size());
+        result.indices.resize(result.index_size * chain.size());
+
+        if (result.index_size == 2) {
+            uint16_t* short_indices = reinterpret_cast<uint16_t*>(result.indices.data());
+            for (size_t i = 0; i < chain.size(); i++) {
+                short_indices[i] = static_cast<uint16_t>(chain[i]);
+            }
+        } else {
+            std::memcpy(result.indices.data(), chain.data(), result.indices.size());
+        }
+
+        return result;
+    }
+
+    MeshCreateInfo MeshLodChain::get_mesh_create_info(const MeshCreateInfo& base) const {
+        MeshCreateInfo create_info = base;
+        create_info.indices = indices.data();
+        create_info.index_size = index_size;
+        create_info.num_indices = num_indices;
+        create_info.lods = lods.data();
+        create_info.lod_count = static_cast<uint32_t>(lods.size());
+
+        return create_info;
+    }
+}
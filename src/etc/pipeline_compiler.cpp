@@ -0,0 +1,177 @@
+#include "etc/pipeline_compiler.h"
+
+#include <algorithm>
+
+namespace rt {
+    PipelineCompiler::PipelineCompiler(const PipelineCompilerCreateInfo& create_info, const ApiContext& a_ctx)
+      : a_ctx(a_ctx),
+        pipeline_cache(create_info.pipeline_cache),
+        retire_queue(create_info.retire_queue),
+        registry(create_info.registry),
+        active_jobs(0),
+        stopping(false) {
+        uint32_t thread_count = create_info.thread_count;
+        if (thread_count == 0) {
+            // hardware_concurrency is allowed to return 0 when unknown
+            thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        for (uint32_t i = 0; i < thread_count; i++) {
+            workers.emplace_back(&PipelineCompiler::WorkerLoop, this);
+        }
+    }
+
+    PipelineCompiler::~PipelineCompiler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        job_available.notify_all();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void PipelineCompiler::WorkerLoop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                job_available.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+                // queued jobs are drained before stopping so
+                //   no future is ever left without a value
+                if (jobs.empty()) {
+                    return;
+                }
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                active_jobs++;
+            }
+
+            // pipeline caches are internally synchronized, so
+            //   workers can all create against the same one
+            std::shared_ptr<GraphicsPipeline> pipeline;
+            try {
+                pipeline = registry != nullptr
+                    ? registry->Get(job.state->get_create_info())
+                    : std::make_shared<GraphicsPipeline>(job.state->get_create_info(), a_ctx);
+                job.promise.set_value(pipeline);
+            } catch (...) {
+                job.promise.set_exception(std::current_exception());
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ResolveRequest(job.state, pipeline);
+                active_jobs--;
+            }
+            jobs_done.notify_all();
+        }
+    }
+
+    void PipelineCompiler::ResolveRequest(
+        const std::shared_ptr<const GraphicsPipelineState>& state,
+        const std::shared_ptr<GraphicsPipeline>& pipeline
+    ) {
+        // Clear may have dropped it already
+        auto bucket_it = requests.find(state->get_hash());
+        if (bucket_it == requests.end()) {
+            return;
+        }
+
+        std::vector<Request>& bucket = bucket_it->second;
+        for (auto it = bucket.begin(); it != bucket.end(); it++) {
+            if (it->state != state) {
+                continue;
+            }
+
+            if (pipeline != nullptr) {
+                it->future = {};
+                it->pipeline = pipeline;
+            } else {
+                bucket.erase(it);
+            }
+            break;
+        }
+
+        if (bucket.empty()) {
+            requests.erase(bucket_it);
+        }
+    }
+
+    PipelineFuture PipelineCompiler::Compile(const GraphicsPipelineCreateInfo& create_info) {
+        GraphicsPipelineCreateInfo info = create_info;
+        if (info.pipeline_cache == VK_NULL_HANDLE) {
+            info.pipeline_cache = pipeline_cache;
+        }
+        // deduplicated pipelines are handed to every requester, so they
+        //   can't retire through whichever queue the first one passed
+        info.retire_queue = retire_queue;
+
+        // copying and hashing happens outside the lock
+        auto state = std::make_shared<const GraphicsPipelineState>(info);
+
+        PipelineFuture future;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            std::vector<Request>& bucket = requests[state->get_hash()];
+            for (auto it = bucket.begin(); it != bucket.end(); it++) {
+                if (*it->state != *state) {
+                    continue;
+                }
+
+                // still compiling
+                if (it->future.valid()) {
+                    return it->future;
+                }
+
+                // finished and still alive somewhere, otherwise it's
+                //   compiled again like a new request
+                if (std::shared_ptr<GraphicsPipeline> pipeline = it->pipeline.lock()) {
+                    std::promise<std::shared_ptr<GraphicsPipeline>> ready;
+                    ready.set_value(std::move(pipeline));
+                    return ready.get_future().share();
+                }
+
+                bucket.erase(it);
+                break;
+            }
+
+            Job job = {.state = state};
+            future = job.promise.get_future().share();
+
+            bucket.push_back({.state = state, .future = future});
+            jobs.push_back(std::move(job));
+        }
+        job_available.notify_one();
+
+        return future;
+    }
+
+    std::vector<PipelineFuture> PipelineCompiler::Compile(const GraphicsPipelineCreateInfo* create_infos, uint32_t count) {
+        std::vector<PipelineFuture> futures;
+        futures.reserve(count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            futures.push_back(Compile(create_infos[i]));
+        }
+
+        return futures;
+    }
+
+    void PipelineCompiler::WaitIdle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobs_done.wait(lock, [this] { return jobs.empty() && active_jobs == 0; });
+    }
+
+    void PipelineCompiler::Clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.clear();
+    }
+
+    uint32_t PipelineCompiler::get_thread_count() const { return static_cast<uint32_t>(workers.size()); }
+}
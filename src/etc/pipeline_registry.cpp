@@ -0,0 +1,153 @@
+#include "etc/pipeline_registry.h"
+
+#include <stdexcept>
+#include "etc/destruction_queue.h"
+#include "vk_utils.h"
+
+namespace rt {
+    PipelineRegistry::LayoutStore::~LayoutStore() {
+        std::vector<VkPipelineLayout> to_destroy;
+        for (auto& [hash, bucket] : entries) {
+            for (auto& entry : bucket) {
+                to_destroy.push_back(entry.layout);
+            }
+        }
+
+        auto destroy = [device = device, to_destroy = std::move(to_destroy)] {
+            for (VkPipelineLayout layout : to_destroy) {
+                vkDestroyPipelineLayout(device, layout, nullptr);
+            }
+        };
+
+        if (retire_queue != nullptr) {
+            retire_queue->QueueRetire(destroy);
+        } else {
+            vkDeviceWaitIdle(device);
+            destroy();
+        }
+    }
+
+    PipelineRegistry::PipelineRegistry(const PipelineRegistryCreateInfo& create_info, const ApiContext& a_ctx)
+      : a_ctx(a_ctx),
+        pipeline_cache(create_info.pipeline_cache),
+        retire_queue(create_info.retire_queue),
+        layouts(std::make_shared<LayoutStore>(LayoutStore{
+            .device = a_ctx.device,
+            .retire_queue = create_info.retire_queue
+        })),
+        pipeline_count(0),
+        layout_count(0),
+        hit_count(0),
+        miss_count(0) { }
+
+    PipelineRegistry::~PipelineRegistry() {
+        // the layouts go with whichever of this or the last pipeline
+        //   still held elsewhere is released last
+        pipelines.clear();
+        layouts.reset();
+    }
+
+    VkPipelineLayout PipelineRegistry::GetLayoutLocked(const VkPipelineLayoutCreateInfo& layout_info) {
+        std::vector<uint8_t> key = GraphicsPipelineState::MakeLayoutKey(layout_info);
+
+        std::vector<LayoutEntry>& bucket = layouts->entries[Utils::hash_bytes(key.data(), key.size())];
+        for (const auto& entry : bucket) {
+            if (entry.key == key) {
+                return entry.layout;
+            }
+        }
+
+        VkPipelineLayout layout;
+        if (vkCreatePipelineLayout(a_ctx.device, &layout_info, nullptr, &layout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline layout!");
+        }
+
+        bucket.push_back({.key = std::move(key), .layout = layout});
+        layout_count++;
+
+        return layout;
+    }
+
+    std::shared_ptr<GraphicsPipeline> PipelineRegistry::Get(const GraphicsPipelineCreateInfo& create_info) {
+        GraphicsPipelineCreateInfo info = create_info;
+        if (info.pipeline_cache == VK_NULL_HANDLE) {
+            info.pipeline_cache = pipeline_cache;
+        }
+        // the pipeline is shared with every later request for the same
+        //   state, so it can't be retired through whichever queue the
+        //   first one happened to pass
+        info.retire_queue = retire_queue;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (info.pipeline_layout == VK_NULL_HANDLE && info.layout_create_info != nullptr) {
+                info.pipeline_layout = GetLayoutLocked(*info.layout_create_info);
+            }
+        }
+
+        // keyed with the shared layout handle, so layouts that dedupe
+        //   also let their pipelines dedupe
+        auto state = std::make_shared<const GraphicsPipelineState>(info);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& entry : pipelines[state->get_hash()]) {
+                if (*entry.state == *state) {
+                    hit_count++;
+                    return entry.pipeline;
+                }
+            }
+        }
+
+        // built outside the lock so other threads can keep getting hits
+        //   (and building other pipelines) while this one compiles.
+        //   the deleter holds the layouts until the pipeline is gone
+        std::shared_ptr<GraphicsPipeline> pipeline(
+            new GraphicsPipeline(state->get_create_info(), a_ctx),
+            [layouts = layouts](GraphicsPipeline* created) { delete created; }
+        );
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<PipelineEntry>& bucket = pipelines[state->get_hash()];
+
+        // another thread may have finished the same state first,
+        //   keep theirs so everyone shares one pipeline
+        for (const auto& entry : bucket) {
+            if (*entry.state == *state) {
+                hit_count++;
+                return entry.pipeline;
+            }
+        }
+
+        bucket.push_back({.state = state, .pipeline = pipeline});
+        pipeline_count++;
+        miss_count++;
+
+        return pipeline;
+    }
+
+    VkPipelineLayout PipelineRegistry::GetLayout(const VkPipelineLayoutCreateInfo& layout_info) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return GetLayoutLocked(layout_info);
+    }
+
+    size_t PipelineRegistry::get_pipeline_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pipeline_count;
+    }
+
+    size_t PipelineRegistry::get_layout_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return layout_count;
+    }
+
+    uint64_t PipelineRegistry::get_hit_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hit_count;
+    }
+
+    uint64_t PipelineRegistry::get_miss_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return miss_count;
+    }
+}
@@ -0,0 +1,374 @@
+#include "etc/pipeline_state.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <type_traits>
+#include "vk_utils.h"
+
+// appends a single field, structs are never written whole
+//   since their padding bytes would make equal keys differ
+template <typename T>
+static void write_key(std::vector<uint8_t>& key, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    key.insert(key.end(), bytes, bytes + sizeof(T));
+}
+
+static void write_key_bytes(std::vector<uint8_t>& key, const void* data, size_t size) {
+    write_key(key, static_cast<uint64_t>(size));
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    key.insert(key.end(), bytes, bytes + size);
+}
+
+template <typename T>
+static std::vector<T> copy_array(const T* data, uint32_t count) {
+    if (data == nullptr || count == 0) {
+        return {};
+    }
+    return std::vector<T>(data, data + count);
+}
+
+static void check_no_pnext(const void* p_next) {
+    if (p_next != nullptr) {
+        throw std::runtime_error("Pipeline state with pNext chains cannot be copied!");
+    }
+}
+
+namespace rt {
+    GraphicsPipelineState::GraphicsPipelineState(const GraphicsPipelineCreateInfo& create_info)
+      : create_info(create_info),
+        hash(0) {
+        CopyState(create_info);
+        PointAtStorage();
+        BuildKey();
+    }
+
+    void GraphicsPipelineState::CopyState(const GraphicsPipelineCreateInfo& source) {
+        stages = copy_array(source.shader_stages, source.shader_stage_count);
+        for (const auto& stage : stages) {
+            check_no_pnext(stage.pNext);
+            stage_names.emplace_back(stage.pName);
+
+            if (stage.pSpecializationInfo == nullptr) {
+                specializations.emplace_back();
+                continue;
+            }
+
+            const VkSpecializationInfo& info = *stage.pSpecializationInfo;
+            const uint8_t* data = static_cast<const uint8_t*>(info.pData);
+            specializations.push_back(SpecializationStorage {
+                .info = info,
+                .entries = copy_array(info.pMapEntries, info.mapEntryCount),
+                .data = data == nullptr ? std::vector<uint8_t>() : std::vector<uint8_t>(data, data + info.dataSize)
+            });
+        }
+
+        if (source.vertex_input != nullptr) {
+            check_no_pnext(source.vertex_input->pNext);
+            vertex_input = *source.vertex_input;
+            vertex_bindings = copy_array(vertex_input->pVertexBindingDescriptions, vertex_input->vertexBindingDescriptionCount);
+            vertex_attributes = copy_array(vertex_input->pVertexAttributeDescriptions, vertex_input->vertexAttributeDescriptionCount);
+        }
+
+        if (source.input_assembly != nullptr) {
+            check_no_pnext(source.input_assembly->pNext);
+            input_assembly = *source.input_assembly;
+        }
+
+        if (source.viewport != nullptr) {
+            check_no_pnext(source.viewport->pNext);
+            viewport = *source.viewport;
+            viewports = copy_array(viewport->pViewports, viewport->viewportCount);
+            scissors = copy_array(viewport->pScissors, viewport->scissorCount);
+        }
+
+        if (source.rasterizer != nullptr) {
+            check_no_pnext(source.rasterizer->pNext);
+            rasterizer = *source.rasterizer;
+        }
+
+        if (source.multisample != nullptr) {
+            check_no_pnext(source.multisample->pNext);
+            multisample = *source.multisample;
+            // one mask word per 32 samples
+            uint32_t mask_count = (static_cast<uint32_t>(multisample->rasterizationSamples) + 31) / 32;
+            sample_mask = copy_array(multisample->pSampleMask, mask_count);
+        }
+
+        if (source.depth_stencil != nullptr) {
+            check_no_pnext(source.depth_stencil->pNext);
+            depth_stencil = *source.depth_stencil;
+        }
+
+        if (source.color_blend != nullptr) {
+            check_no_pnext(source.color_blend->pNext);
+            color_blend = *source.color_blend;
+            blend_attachments = copy_array(color_blend->pAttachments, color_blend->attachmentCount);
+        }
+
+        if (source.dynamic_state != nullptr) {
+            check_no_pnext(source.dynamic_state->pNext);
+            dynamic_state = *source.dynamic_state;
+            dynamic_states = copy_array(dynamic_state->pDynamicStates, dynamic_state->dynamicStateCount);
+        }
+
+        if (source.layout_create_info != nullptr) {
+            check_no_pnext(source.layout_create_info->pNext);
+            layout_create_info = *source.layout_create_info;
+            set_layouts = copy_array(layout_create_info->pSetLayouts, layout_create_info->setLayoutCount);
+            push_constant_ranges = copy_array(layout_create_info->pPushConstantRanges, layout_create_info->pushConstantRangeCount);
+        }
+    }
+
+    void GraphicsPipelineState::PointAtStorage() {
+        for (size_t i = 0; i < stages.size(); i++) {
+            stages[i].pName = stage_names[i].c_str();
+
+            if (specializations[i].has_value()) {
+                SpecializationStorage& spec = *specializations[i];
+                spec.info.pMapEntries = spec.entries.data();
+                spec.info.pData = spec.data.data();
+                stages[i].pSpecializationInfo = &spec.info;
+            }
+        }
+        create_info.shader_stages = stages.data();
+
+        if (vertex_input.has_value()) {
+            vertex_input->pVertexBindingDescriptions = vertex_bindings.data();
+            vertex_input->pVertexAttributeDescriptions = vertex_attributes.data();
+        }
+        create_info.vertex_input = vertex_input.has_value() ? &*vertex_input : nullptr;
+
+        create_info.input_assembly = input_assembly.has_value() ? &*input_assembly : nullptr;
+
+        // null viewports and scissors are valid when they're dynamic
+        if (viewport.has_value()) {
+            viewport->pViewports = viewports.empty() ? nullptr : viewports.data();
+            viewport->pScissors = scissors.empty() ? nullptr : scissors.data();
+        }
+        create_info.viewport = viewport.has_value() ? &*viewport : nullptr;
+
+        create_info.rasterizer = rasterizer.has_value() ? &*rasterizer : nullptr;
+
+        if (multisample.has_value()) {
+            multisample->pSampleMask = sample_mask.empty() ? nullptr : sample_mask.data();
+        }
+        create_info.multisample = multisample.has_value() ? &*multisample : nullptr;
+
+        create_info.depth_stencil = depth_stencil.has_value() ? &*depth_stencil : nullptr;
+
+        if (color_blend.has_value()) {
+            color_blend->pAttachments = blend_attachments.data();
+        }
+        create_info.color_blend = color_blend.has_value() ? &*color_blend : nullptr;
+
+        if (dynamic_state.has_value()) {
+            dynamic_state->pDynamicStates = dynamic_states.data();
+        }
+        create_info.dynamic_state = dynamic_state.has_value() ? &*dynamic_state : nullptr;
+
+        if (layout_create_info.has_value()) {
+            layout_create_info->pSetLayouts = set_layouts.data();
+            layout_create_info->pPushConstantRanges = push_constant_ranges.data();
+        }
+        create_info.layout_create_info = layout_create_info.has_value() ? &*layout_create_info : nullptr;
+    }
+
+    void GraphicsPipelineState::BuildKey() {
+        // pipeline_cache and retire_queue don't change the pipeline
+        //   that gets built, so they're left out of the key. whoever
+        //   shares pipelines by key sets retire_queue to its own
+
+        write_key(key, static_cast<uint32_t>(stages.size()));
+        for (size_t i = 0; i < stages.size(); i++) {
+            write_key(key, stages[i].flags);
+            write_key(key, stages[i].stage);
+            write_key(key, stages[i].module);
+            write_key_bytes(key, stage_names[i].data(), stage_names[i].size());
+
+            write_key(key, specializations[i].has_value());
+            if (specializations[i].has_value()) {
+                const SpecializationStorage& spec = *specializations[i];
+                write_key(key, static_cast<uint32_t>(spec.entries.size()));
+                for (const auto& entry : spec.entries) {
+                    write_key(key, entry.constantID);
+                    write_key(key, entry.offset);
+                    write_key(key, static_cast<uint64_t>(entry.size));
+                }
+                write_key_bytes(key, spec.data.data(), spec.data.size());
+            }
+        }
+
+        write_key(key, vertex_input.has_value());
+        if (vertex_input.has_value()) {
+            write_key(key, vertex_input->flags);
+            write_key(key, static_cast<uint32_t>(vertex_bindings.size()));
+            for (const auto& binding : vertex_bindings) {
+                write_key(key, binding.binding);
+                write_key(key, binding.stride);
+                write_key(key, binding.inputRate);
+            }
+            write_key(key, static_cast<uint32_t>(vertex_attributes.size()));
+            for (const auto& attribute : vertex_attributes) {
+                write_key(key, attribute.location);
+                write_key(key, attribute.binding);
+                write_key(key, attribute.format);
+                write_key(key, attribute.offset);
+            }
+        }
+
+        write_key(key, input_assembly.has_value());
+        if (input_assembly.has_value()) {
+            write_key(key, input_assembly->flags);
+            write_key(key, input_assembly->topology);
+            write_key(key, input_assembly->primitiveRestartEnable);
+        }
+
+        write_key(key, viewport.has_value());
+        if (viewport.has_value()) {
+            write_key(key, viewport->flags);
+            write_key(key, viewport->viewportCount);
+            write_key(key, viewport->scissorCount);
+            for (const auto& v : viewports) {
+                write_key(key, v.x);
+                write_key(key, v.y);
+                write_key(key, v.width);
+                write_key(key, v.height);
+                write_key(key, v.minDepth);
+                write_key(key, v.maxDepth);
+            }
+            for (const auto& s : scissors) {
+                write_key(key, s.offset.x);
+                write_key(key, s.offset.y);
+                write_key(key, s.extent.width);
+                write_key(key, s.extent.height);
+            }
+        }
+
+        write_key(key, rasterizer.has_value());
+        if (rasterizer.has_value()) {
+            write_key(key, rasterizer->flags);
+            write_key(key, rasterizer->depthClampEnable);
+            write_key(key, rasterizer->rasterizerDiscardEnable);
+            write_key(key, rasterizer->polygonMode);
+            write_key(key, rasterizer->cullMode);
+            write_key(key, rasterizer->frontFace);
+            write_key(key, rasterizer->depthBiasEnable);
+            write_key(key, rasterizer->depthBiasConstantFactor);
+            write_key(key, rasterizer->depthBiasClamp);
+            write_key(key, rasterizer->depthBiasSlopeFactor);
+            write_key(key, rasterizer->lineWidth);
+        }
+
+        write_key(key, multisample.has_value());
+        if (multisample.has_value()) {
+            write_key(key, multisample->flags);
+            write_key(key, multisample->rasterizationSamples);
+            write_key(key, multisample->sampleShadingEnable);
+            write_key(key, multisample->minSampleShading);
+            write_key(key, static_cast<uint32_t>(sample_mask.size()));
+            for (VkSampleMask mask : sample_mask) {
+                write_key(key, mask);
+            }
+            write_key(key, multisample->alphaToCoverageEnable);
+            write_key(key, multisample->alphaToOneEnable);
+        }
+
+        auto write_stencil_op = [this](const VkStencilOpState& op) {
+            write_key(key, op.failOp);
+            write_key(key, op.passOp);
+            write_key(key, op.depthFailOp);
+            write_key(key, op.compareOp);
+            write_key(key, op.compareMask);
+            write_key(key, op.writeMask);
+            write_key(key, op.reference);
+        };
+
+        write_key(key, depth_stencil.has_value());
+        if (depth_stencil.has_value()) {
+            write_key(key, depth_stencil->flags);
+            write_key(key, depth_stencil->depthTestEnable);
+            write_key(key, depth_stencil->depthWriteEnable);
+            write_key(key, depth_stencil->depthCompareOp);
+            write_key(key, depth_stencil->depthBoundsTestEnable);
+            write_key(key, depth_stencil->stencilTestEnable);
+            write_stencil_op(depth_stencil->front);
+            write_stencil_op(depth_stencil->back);
+            write_key(key, depth_stencil->minDepthBounds);
+            write_key(key, depth_stencil->maxDepthBounds);
+        }
+
+        write_key(key, color_blend.has_value());
+        if (color_blend.has_value()) {
+            write_key(key, color_blend->flags);
+            write_key(key, color_blend->logicOpEnable);
+            write_key(key, color_blend->logicOp);
+            write_key(key, static_cast<uint32_t>(blend_attachments.size()));
+            for (const auto& attachment : blend_attachments) {
+                write_key(key, attachment.blendEnable);
+                write_key(key, attachment.srcColorBlendFactor);
+                write_key(key, attachment.dstColorBlendFactor);
+                write_key(key, attachment.colorBlendOp);
+                write_key(key, attachment.srcAlphaBlendFactor);
+                write_key(key, attachment.dstAlphaBlendFactor);
+                write_key(key, attachment.alphaBlendOp);
+                write_key(key, attachment.colorWriteMask);
+            }
+            for (float constant : color_blend->blendConstants) {
+                write_key(key, constant);
+            }
+        }
+
+        write_key(key, dynamic_state.has_value());
+        if (dynamic_state.has_value()) {
+            write_key(key, dynamic_state->flags);
+            write_key(key, static_cast<uint32_t>(dynamic_states.size()));
+            for (VkDynamicState state : dynamic_states) {
+                write_key(key, state);
+            }
+        }
+
+        // a shared layout handle wins over the create info, same as
+        //   in GraphicsPipeline, so only one of them goes in the key
+        write_key(key, create_info.pipeline_layout);
+        if (create_info.pipeline_layout == VK_NULL_HANDLE) {
+            write_key(key, layout_create_info.has_value());
+            if (layout_create_info.has_value()) {
+                std::vector<uint8_t> layout_key = MakeLayoutKey(*layout_create_info);
+                key.insert(key.end(), layout_key.begin(), layout_key.end());
+            }
+        }
+
+        write_key(key, create_info.render_pass);
+        write_key(key, create_info.subpass_index);
+
+        hash = Utils::hash_bytes(key.data(), key.size());
+    }
+
+    std::vector<uint8_t> GraphicsPipelineState::MakeLayoutKey(const VkPipelineLayoutCreateInfo& layout_info) {
+        check_no_pnext(layout_info.pNext);
+
+        std::vector<uint8_t> layout_key;
+        write_key(layout_key, layout_info.flags);
+        write_key(layout_key, layout_info.setLayoutCount);
+        for (uint32_t i = 0; i < layout_info.setLayoutCount; i++) {
+            write_key(layout_key, layout_info.pSetLayouts[i]);
+        }
+        write_key(layout_key, layout_info.pushConstantRangeCount);
+        for (uint32_t i = 0; i < layout_info.pushConstantRangeCount; i++) {
+            const VkPushConstantRange& range = layout_info.pPushConstantRanges[i];
+            write_key(layout_key, range.stageFlags);
+            write_key(layout_key, range.offset);
+            write_key(layout_key, range.size);
+        }
+
+        return layout_key;
+    }
+
+    bool GraphicsPipelineState::operator==(const GraphicsPipelineState& other) const {
+        return hash == other.hash && key == other.key;
+    }
+
+    const GraphicsPipelineCreateInfo& GraphicsPipelineState::get_create_info() const { return create_info; }
+    uint64_t GraphicsPipelineState::get_hash() const { return hash; }
+}
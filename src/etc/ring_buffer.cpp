@@ -1,4 +1,5 @@
 #include "etc/ring_buffer.h"
+#include <algorithm>
 #include <array>
 #include <stdexcept>
 
@@ -6,11 +7,29 @@ namespace rt {
     RingBuffer::RingBuffer(const RingBufferCreateInfo& create_info, const ApiContext& a_ctx)
       : device(a_ctx.device),
         descriptor_type(create_info.descriptor_type),
+        dynamic(
+            create_info.descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+            create_info.descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC
+        ),
         max_elements(create_info.max_elements),
         buffer_offset(0),
-        descriptor_index(0) {
+        descriptor_index(0),
+        used(0),
+        used_descriptors(0) {
         // ~~~ create buffer ~~~
-        size_t element_size = (create_info.element_size + 255) / 256 * 256;
+
+        // offsets into the buffer have to respect the device's alignment
+        //   for whichever kind of buffer descriptor this is
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(a_ctx.physical_device, &properties);
+
+        bool storage = create_info.descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+                       create_info.descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+        alignment = storage ? properties.limits.minStorageBufferOffsetAlignment
+                            : properties.limits.minUniformBufferOffsetAlignment;
+        alignment = std::max<uint64_t>(alignment, 1);
+
+        element_size = (create_info.element_size + alignment - 1) / alignment * alignment;
         BufferCreateInfo buffer_info = {
             .size = element_size * static_cast<size_t>(create_info.max_elements),
             .usage = create_info.usage,
@@ -20,12 +39,16 @@ namespace rt {
         buffer->Map();
 
         // ~~~ create pool ~~~
+
+        // a dynamic ring only ever needs the one set
+        uint32_t set_count = dynamic ? 1 : create_info.max_elements;
+
         VkDescriptorPoolSize pool_size = {
             .type = create_info.descriptor_type,
-            .descriptorCount = create_info.max_elements
+            .descriptorCount = set_count
         };
         DescriptorPoolCreateInfo pool_info = {
-            .max_sets = create_info.max_elements,
+            .max_sets = set_count,
             .flags = 0,
             .pool_sizes = &pool_size,
             .pool_size_count = 1
@@ -33,41 +56,123 @@ namespace rt {
         pool = std::make_unique<DescriptorPool>(pool_info, a_ctx);
 
         // ~~~ allocate descriptors ~~~
-        descriptor_sets.resize(max_elements);
+        descriptor_sets.resize(set_count);
 
         // create a vector of duplicate layouts for all our identical descriptors
-        std::vector<VkDescriptorSetLayout> layouts(create_info.max_elements, create_info.layout);
+        std::vector<VkDescriptorSetLayout> layouts(set_count, create_info.layout);
         VkDescriptorSetAllocateInfo alloc_info = {
             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
             .descriptorPool = pool->get_pool(),
-            .descriptorSetCount = create_info.max_elements,
+            .descriptorSetCount = set_count,
             .pSetLayouts = layouts.data()
         };
         if (vkAllocateDescriptorSets(device, &alloc_info, descriptor_sets.data()) != VK_SUCCESS) {
             throw std::runtime_error("Failed to allocate ring buffer descriptor sets!");
         }
+
+        // ~~~ point the dynamic set at the start of the buffer ~~~
+
+        // the dynamic offset passed at bind time is added on top
+        if (dynamic) {
+            VkDescriptorBufferInfo dynamic_info = {
+                .buffer = buffer->get_buffer(),
+                .offset = 0,
+                .range = static_cast<VkDeviceSize>(create_info.element_size)
+            };
+
+            VkWriteDescriptorSet write = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptor_sets[0],
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = descriptor_type,
+                .pImageInfo = nullptr,
+                .pBufferInfo = &dynamic_info,
+                .pTexelBufferView = nullptr,
+            };
+
+            vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+        }
     }
 
     RingBuffer::~RingBuffer() { }
 
+    uint64_t RingBuffer::Reserve(uint64_t size) {
+        uint64_t capacity = static_cast<uint64_t>(buffer->get_size());
+        if (size > capacity) {
+            throw std::runtime_error("Ring buffer write is larger than the whole buffer!");
+        }
+
+        // regions never wrap, the tail end is skipped instead and
+        //   stays used until the frame that skipped it retires
+        uint64_t offset = buffer_offset;
+        uint64_t padding = 0;
+        if (offset + size > capacity) {
+            padding = capacity - offset;
+            offset = 0;
+        }
+
+        // nothing is committed until the write is known to fit, so a
+        //   failed reserve leaves the ring as it was
+        if (!frames.empty()) {
+            if (used + padding + size > capacity) {
+                throw std::runtime_error("Ring buffer is full, frames in flight still use all of it!");
+            }
+
+            used += padding + size;
+            frames.back().size += padding + size;
+        }
+
+        buffer_offset = offset + size;
+        return offset;
+    }
+
+    void RingBuffer::BeginFrame(uint64_t frame_number, uint64_t completed_frame_number) {
+        // frames are written in order, so freeing the oldest ones moves
+        //   the tail of the ring forward
+        while (!frames.empty() && frames.front().frame_number <= completed_frame_number) {
+            used -= frames.front().size;
+            used_descriptors -= frames.front().descriptor_count;
+            frames.pop_front();
+        }
+
+        if (frames.empty() || frames.back().frame_number != frame_number) {
+            frames.push_back({.frame_number = frame_number, .size = 0, .descriptor_count = 0});
+        }
+    }
+
     VkDescriptorSet RingBuffer::CopyToNextRegion(void* data, size_t size) {
+        if (dynamic) {
+            throw std::runtime_error("Dynamic ring buffers are written with Push!");
+        }
+
+        // small writes take less than an element's bytes, so sets can run
+        //   out before the bytes do. rewriting one a frame in flight still
+        //   binds isn't allowed
+        if (!frames.empty() && used_descriptors >= max_elements) {
+            throw std::runtime_error("Ring buffer is out of descriptor sets, frames in flight still use all of them!");
+        }
+
         //~~~ map and copy data into buffer ~~~
 
-        // size needs to be a multiple of 256 for alignment
-        size_t reserve_size = (size + 255) / 256 * 256;
+        // size needs to be a multiple of the offset alignment
+        uint64_t reserve_size = (size + alignment - 1) / alignment * alignment;
+        uint64_t offset = Reserve(reserve_size);
 
-        if (buffer_offset + (uint64_t)reserve_size >= (uint64_t)buffer->get_size()) {
-            buffer_offset = 0;
+        if (!frames.empty()) {
+            used_descriptors++;
+            frames.back().descriptor_count++;
         }
 
-        buffer->CopyFromHost(data, size, buffer_offset);
+        buffer->CopyFromHost(data, size, offset);
 
         // ~~~ write new offset info to descriptor ~~~
 
         VkDescriptorSet descriptor = descriptor_sets[descriptor_index];
         VkDescriptorBufferInfo buffer_info = {
             .buffer = buffer->get_buffer(),
-            .offset = static_cast<VkDeviceSize>(buffer_offset),
+            .offset = static_cast<VkDeviceSize>(offset),
             .range = static_cast<VkDeviceSize>(size)
         };
 
@@ -91,11 +196,70 @@ namespace rt {
             nullptr
         );
 
-        // ~~~ update offsets & indices ~~~
-        buffer_offset += (uint64_t)reserve_size;
+        // ~~~ update indices ~~~
         descriptor_index++;
         descriptor_index %= max_elements;
 
         return descriptor;
     }
+
+    uint32_t RingBuffer::Push(const void* data, size_t size) {
+        return PushMany(data, size, 1);
+    }
+
+    uint32_t RingBuffer::PushMany(const void* data, size_t size, uint32_t count, uint32_t* out_offsets) {
+        if (!dynamic) {
+            throw std::runtime_error("Only dynamic ring buffers can be written with Push!");
+        }
+
+        // anything past the stride would run into the next element
+        if (size > element_size) {
+            throw std::runtime_error("Ring buffer element is larger than its stride!");
+        }
+
+        // the whole batch goes in one contiguous region
+        uint64_t first_offset = Reserve(element_size * count);
+
+        // elements that are already aligned are one copy, others get
+        //   spread out to their aligned slots
+        if (size == element_size) {
+            buffer->CopyFromHost(data, size * count, first_offset);
+        } else {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (uint32_t i = 0; i < count; i++) {
+                buffer->CopyFromHost(bytes + size * i, size, first_offset + element_size * i);
+            }
+        }
+
+        if (out_offsets != nullptr) {
+            for (uint32_t i = 0; i < count; i++) {
+                out_offsets[i] = static_cast<uint32_t>(first_offset + element_size * i);
+            }
+        }
+
+        return static_cast<uint32_t>(first_offset);
+    }
+
+    void RingBuffer::CmdBind(
+        VkCommandBuffer command_buffer,
+        VkPipelineLayout pipeline_layout,
+        VkPipelineBindPoint bind_point,
+        uint32_t set_index,
+        uint32_t dynamic_offset
+    ) const {
+        vkCmdBindDescriptorSets(
+            command_buffer,
+            bind_point,
+            pipeline_layout,
+            set_index,
+            1,
+            &descriptor_sets[0],
+            1,
+            &dynamic_offset
+        );
+    }
+
+    VkDescriptorSet RingBuffer::get_descriptor_set() const { return descriptor_sets[0]; }
+    uint64_t RingBuffer::get_stride() const { return element_size; }
+    uint64_t RingBuffer::get_alignment() const { return alignment; }
 }
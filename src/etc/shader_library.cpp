@@ -0,0 +1,580 @@
+#include "etc/shader_library.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <map>
+#include <algorithm>
+#include "vk_utils.h"
+#include "etc/mapped_file.h"
+
+// ~~~ just enough of the SPIR-V spec to find descriptors ~~~
+
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+constexpr uint32_t OP_ENTRY_POINT = 15;
+constexpr uint32_t OP_TYPE_INT = 21;
+constexpr uint32_t OP_TYPE_FLOAT = 22;
+constexpr uint32_t OP_TYPE_VECTOR = 23;
+constexpr uint32_t OP_TYPE_MATRIX = 24;
+constexpr uint32_t OP_TYPE_IMAGE = 25;
+constexpr uint32_t OP_TYPE_SAMPLER = 26;
+constexpr uint32_t OP_TYPE_SAMPLED_IMAGE = 27;
+constexpr uint32_t OP_TYPE_ARRAY = 28;
+constexpr uint32_t OP_TYPE_RUNTIME_ARRAY = 29;
+constexpr uint32_t OP_TYPE_STRUCT = 30;
+constexpr uint32_t OP_TYPE_POINTER = 32;
+constexpr uint32_t OP_CONSTANT = 43;
+constexpr uint32_t OP_VARIABLE = 59;
+constexpr uint32_t OP_DECORATE = 71;
+constexpr uint32_t OP_MEMBER_DECORATE = 72;
+
+constexpr uint32_t DECORATION_BLOCK = 2;
+constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+constexpr uint32_t DECORATION_ARRAY_STRIDE = 6;
+constexpr uint32_t DECORATION_MATRIX_STRIDE = 7;
+constexpr uint32_t DECORATION_BINDING = 33;
+constexpr uint32_t DECORATION_DESCRIPTOR_SET = 34;
+constexpr uint32_t DECORATION_OFFSET = 35;
+
+constexpr uint32_t STORAGE_CLASS_UNIFORM_CONSTANT = 0;
+constexpr uint32_t STORAGE_CLASS_UNIFORM = 2;
+constexpr uint32_t STORAGE_CLASS_PUSH_CONSTANT = 9;
+constexpr uint32_t STORAGE_CLASS_STORAGE_BUFFER = 12;
+
+// set layouts are sized by their largest binding on some drivers, so
+//   anything past this is treated as a broken module
+constexpr uint32_t MAX_DESCRIPTOR_BINDING = 4096;
+
+constexpr uint32_t DIM_BUFFER = 5;
+constexpr uint32_t DIM_SUBPASS_DATA = 6;
+
+// everything we care about for a single result id
+struct SpirvId {
+    uint32_t opcode = 0;
+    // pointee, element, component, column or image type depending on opcode
+    uint32_t type_id = 0;
+    uint32_t storage_class = 0;
+    // constant value, vector/column count, scalar width or image dim
+    uint32_t value = 0;
+    uint32_t image_sampled = 0;
+    // array length constant id
+    uint32_t length_id = 0;
+    std::vector<uint32_t> members;
+
+    uint32_t set = 0;
+    uint32_t binding = 0;
+    bool has_binding = false;
+    bool block = false;
+    bool buffer_block = false;
+    uint32_t array_stride = 0;
+    std::vector<uint32_t> member_offsets;
+    std::vector<uint32_t> member_matrix_strides;
+};
+
+static VkShaderStageFlagBits stage_from_execution_model(uint32_t model) {
+    switch (model) {
+        case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+        default: throw std::runtime_error("Unsupported SPIR-V execution model!");
+    }
+}
+
+// words up to and including the last fixed operand Reflect reads, so
+//   a shorter instruction would read into the next one
+static uint32_t min_instruction_length(uint32_t opcode) {
+    switch (opcode) {
+        case OP_TYPE_SAMPLER:
+        case OP_TYPE_STRUCT:
+            return 2;
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+        case OP_TYPE_SAMPLED_IMAGE:
+        case OP_TYPE_RUNTIME_ARRAY:
+        case OP_DECORATE:
+            return 3;
+        case OP_TYPE_VECTOR:
+        case OP_TYPE_MATRIX:
+        case OP_TYPE_ARRAY:
+        case OP_TYPE_POINTER:
+        case OP_CONSTANT:
+        case OP_VARIABLE:
+        case OP_MEMBER_DECORATE:
+            return 4;
+        case OP_TYPE_IMAGE:
+            return 8;
+        default:
+            return 1;
+    }
+}
+
+static const SpirvId& checked_id(const std::vector<SpirvId>& ids, uint32_t id) {
+    if (id >= ids.size()) {
+        throw std::runtime_error("SPIR-V id is out of bounds!");
+    }
+    return ids[id];
+}
+
+static uint32_t type_size(const std::vector<SpirvId>& ids, uint32_t id, uint32_t matrix_stride = 0) {
+    const SpirvId& type = checked_id(ids, id);
+
+    switch (type.opcode) {
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+            return type.value / 8;
+        case OP_TYPE_VECTOR:
+            return type.value * type_size(ids, type.type_id);
+        case OP_TYPE_MATRIX:
+            // columns are padded out to the stride when there is one
+            return type.value * (matrix_stride != 0 ? matrix_stride : type_size(ids, type.type_id));
+        case OP_TYPE_ARRAY: {
+            uint32_t stride = type.array_stride != 0 ? type.array_stride : type_size(ids, type.type_id, matrix_stride);
+            return checked_id(ids, type.length_id).value * stride;
+        }
+        case OP_TYPE_STRUCT: {
+            uint32_t size = 0;
+            for (size_t i = 0; i < type.members.size(); i++) {
+                uint32_t offset = i < type.member_offsets.size() ? type.member_offsets[i] : 0;
+                uint32_t stride = i < type.member_matrix_strides.size() ? type.member_matrix_strides[i] : 0;
+                size = std::max(size, offset + type_size(ids, type.members[i], stride));
+            }
+            return size;
+        }
+        default:
+            return 0;
+    }
+}
+
+namespace rt {
+    VkPipelineShaderStageCreateInfo ShaderModule::get_stage_create_info() const {
+        return {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = reflection.stage,
+            .module = module,
+            .pName = reflection.entry_point.c_str()
+        };
+    }
+
+    VkPipelineLayoutCreateInfo ShaderLayout::get_layout_create_info() const {
+        return {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = static_cast<uint32_t>(set_layouts.size()),
+            .pSetLayouts = set_layouts.data(),
+            .pushConstantRangeCount = static_cast<uint32_t>(push_constant_ranges.size()),
+            .pPushConstantRanges = push_constant_ranges.data()
+        };
+    }
+
+    ShaderLibrary::ShaderLibrary(const ShaderLibraryCreateInfo& create_info, const ApiContext& a_ctx)
+      : a_ctx(a_ctx),
+        runtime_array_size(create_info.runtime_array_size != 0 ? create_info.runtime_array_size : 1) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(a_ctx.physical_device, &properties);
+        max_bound_descriptor_sets = properties.limits.maxBoundDescriptorSets;
+    }
+
+    ShaderLibrary::~ShaderLibrary() {
+        // modules aren't needed once pipelines are created
+        //   from them, so there's nothing to wait on here
+        for (auto& [hash, bucket] : modules) {
+            for (auto& entry : bucket) {
+                vkDestroyShaderModule(a_ctx.device, entry.shader->module, nullptr);
+            }
+        }
+    }
+
+    ShaderReflection ShaderLibrary::Reflect(const uint32_t* code, size_t word_count) const {
+        if (word_count < 5 || code[0] != SPIRV_MAGIC) {
+            throw std::runtime_error("Shader code is not valid SPIR-V!");
+        }
+
+        // every id is defined by an instruction of at least two words, so
+        //   a bound past the word count is a broken (or hostile) header
+        //   that would only get a huge allocation out of us
+        uint32_t bound = code[3];
+        if (bound > word_count) {
+            throw std::runtime_error("SPIR-V id bound is larger than the module!");
+        }
+        std::vector<SpirvId> ids(bound);
+        std::vector<uint32_t> variables;
+        ShaderReflection reflection = {};
+        bool found_entry_point = false;
+
+        auto id_at = [&](uint32_t id) -> SpirvId& {
+            if (id >= bound) {
+                throw std::runtime_error("SPIR-V id is out of bounds!");
+            }
+            return ids[id];
+        };
+
+        // ~~~ gather types, decorations and variables ~~~
+
+        size_t i = 5;
+        while (i < word_count) {
+            const uint32_t* ins = code + i;
+            uint32_t opcode = ins[0] & 0xffff;
+            uint32_t length = ins[0] >> 16;
+
+            if (length == 0 || i + length > word_count) {
+                throw std::runtime_error("Malformed SPIR-V instruction stream!");
+            }
+            if (length < min_instruction_length(opcode)) {
+                throw std::runtime_error("SPIR-V instruction is missing operands!");
+            }
+
+            switch (opcode) {
+                case OP_ENTRY_POINT:
+                    // resources aren't tied to entry points before SPIR-V
+                    //   1.4, so with several of them the layout would pick
+                    //   up bindings the chosen one never uses
+                    if (found_entry_point) {
+                        throw std::runtime_error("SPIR-V modules with more than one entry point aren't supported!");
+                    }
+                    if (length >= 4) {
+                        reflection.stage = stage_from_execution_model(ins[1]);
+                        const char* name = reinterpret_cast<const char*>(ins + 3);
+                        reflection.entry_point = std::string(name, strnlen(name, (length - 3) * 4));
+                        found_entry_point = true;
+                    }
+                    break;
+                case OP_TYPE_INT:
+                case OP_TYPE_FLOAT:
+                    id_at(ins[1]).opcode = opcode;
+                    id_at(ins[1]).value = ins[2];
+                    break;
+                case OP_TYPE_VECTOR:
+                case OP_TYPE_MATRIX:
+                    id_at(ins[1]).opcode = opcode;
+                    id_at(ins[1]).type_id = ins[2];
+                    id_at(ins[1]).value = ins[3];
+                    break;
+                case OP_TYPE_IMAGE:
+                    id_at(ins[1]).opcode = opcode;
+                    id_at(ins[1]).value = ins[3];
+                    id_at(ins[1]).image_sampled = ins[7];
+                    break;
+                case OP_TYPE_SAMPLER:
+                    id_at(ins[1]).opcode = opcode;
+                    break;
+                case OP_TYPE_SAMPLED_IMAGE:
+                case OP_TYPE_RUNTIME_ARRAY:
+                    id_at(ins[1]).opcode = opcode;
+                    id_at(ins[1]).type_id = ins[2];
+                    break;
+                case OP_TYPE_ARRAY:
+                    id_at(ins[1]).opcode = opcode;
+                    id_at(ins[1]).type_id = ins[2];
+                    id_at(ins[1]).length_id = ins[3];
+                    break;
+                case OP_TYPE_STRUCT:
+                    id_at(ins[1]).opcode = opcode;
+                    id_at(ins[1]).members.assign(ins + 2, ins + length);
+                    break;
+                case OP_TYPE_POINTER:
+                    id_at(ins[1]).opcode = opcode;
+                    id_at(ins[1]).storage_class = ins[2];
+                    id_at(ins[1]).type_id = ins[3];
+                    break;
+                case OP_CONSTANT:
+                    id_at(ins[2]).opcode = opcode;
+                    id_at(ins[2]).value = ins[3];
+                    break;
+                case OP_VARIABLE:
+                    id_at(ins[2]).opcode = opcode;
+                    id_at(ins[2]).type_id = ins[1];
+                    id_at(ins[2]).storage_class = ins[3];
+                    variables.push_back(ins[2]);
+                    break;
+                case OP_DECORATE: {
+                    SpirvId& target = id_at(ins[1]);
+                    if (length < 4 && (ins[2] == DECORATION_ARRAY_STRIDE || ins[2] == DECORATION_DESCRIPTOR_SET || ins[2] == DECORATION_BINDING)) {
+                        throw std::runtime_error("SPIR-V decoration is missing its operand!");
+                    }
+
+                    switch (ins[2]) {
+                        case DECORATION_BLOCK: target.block = true; break;
+                        case DECORATION_BUFFER_BLOCK: target.buffer_block = true; break;
+                        case DECORATION_ARRAY_STRIDE: target.array_stride = ins[3]; break;
+                        case DECORATION_DESCRIPTOR_SET: target.set = ins[3]; break;
+                        case DECORATION_BINDING:
+                            target.binding = ins[3];
+                            target.has_binding = true;
+                            break;
+                    }
+                    break;
+                }
+                case OP_MEMBER_DECORATE: {
+                    SpirvId& target = id_at(ins[1]);
+                    uint32_t member = ins[2];
+                    if (length < 5 && (ins[3] == DECORATION_OFFSET || ins[3] == DECORATION_MATRIX_STRIDE)) {
+                        throw std::runtime_error("SPIR-V decoration is missing its operand!");
+                    }
+
+                    if (ins[3] == DECORATION_OFFSET) {
+                        if (target.member_offsets.size() <= member) {
+                            target.member_offsets.resize(member + 1, 0);
+                        }
+                        target.member_offsets[member] = ins[4];
+                    } else if (ins[3] == DECORATION_MATRIX_STRIDE) {
+                        if (target.member_matrix_strides.size() <= member) {
+                            target.member_matrix_strides.resize(member + 1, 0);
+                        }
+                        target.member_matrix_strides[member] = ins[4];
+                    }
+                    break;
+                }
+            }
+
+            i += length;
+        }
+
+        if (!found_entry_point) {
+            throw std::runtime_error("SPIR-V module has no entry point!");
+        }
+
+        // ~~~ turn variables into bindings and push constants ~~~
+
+        for (uint32_t variable_id : variables) {
+            const SpirvId& variable = ids[variable_id];
+            const SpirvId& pointer = id_at(variable.type_id);
+            uint32_t type_id = pointer.type_id;
+
+            if (variable.storage_class == STORAGE_CLASS_PUSH_CONSTANT) {
+                const SpirvId& type = id_at(type_id);
+                uint32_t offset = type.member_offsets.empty()
+                    ? 0
+                    : *std::min_element(type.member_offsets.begin(), type.member_offsets.end());
+
+                reflection.push_constant_ranges.push_back({
+                    .stageFlags = static_cast<VkShaderStageFlags>(reflection.stage),
+                    .offset = offset,
+                    .size = type_size(ids, type_id) - offset
+                });
+                continue;
+            }
+
+            if (!variable.has_binding) {
+                continue;
+            }
+
+            // CreateLayout allocates a list per set up to the largest one
+            if (variable.set >= max_bound_descriptor_sets) {
+                throw std::runtime_error("SPIR-V descriptor set is past the device's maxBoundDescriptorSets!");
+            }
+            if (variable.binding > MAX_DESCRIPTOR_BINDING) {
+                throw std::runtime_error("SPIR-V descriptor binding is implausibly large!");
+            }
+
+            // arrays of descriptors become the descriptor count
+            uint32_t count = 1;
+            while (id_at(type_id).opcode == OP_TYPE_ARRAY || id_at(type_id).opcode == OP_TYPE_RUNTIME_ARRAY) {
+                const SpirvId& array = ids[type_id];
+                count *= array.opcode == OP_TYPE_ARRAY ? id_at(array.length_id).value : runtime_array_size;
+                type_id = array.type_id;
+            }
+
+            const SpirvId& type = ids[type_id];
+            VkDescriptorType descriptor_type;
+
+            if (variable.storage_class == STORAGE_CLASS_STORAGE_BUFFER) {
+                descriptor_type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            } else if (variable.storage_class == STORAGE_CLASS_UNIFORM) {
+                descriptor_type = type.buffer_block ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            } else if (variable.storage_class == STORAGE_CLASS_UNIFORM_CONSTANT && type.opcode == OP_TYPE_SAMPLER) {
+                descriptor_type = VK_DESCRIPTOR_TYPE_SAMPLER;
+            } else if (variable.storage_class == STORAGE_CLASS_UNIFORM_CONSTANT && type.opcode == OP_TYPE_SAMPLED_IMAGE) {
+                descriptor_type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            } else if (variable.storage_class == STORAGE_CLASS_UNIFORM_CONSTANT && type.opcode == OP_TYPE_IMAGE) {
+                // sampled == 2 means used without a sampler (storage)
+                if (type.value == DIM_BUFFER) {
+                    descriptor_type = type.image_sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                } else if (type.value == DIM_SUBPASS_DATA) {
+                    descriptor_type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                } else {
+                    descriptor_type = type.image_sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                }
+            } else {
+                throw std::runtime_error("Unsupported descriptor type in SPIR-V module!");
+            }
+
+            reflection.bindings.push_back({
+                .set = variable.set,
+                .binding = variable.binding,
+                .type = descriptor_type,
+                .count = count,
+                .stages = static_cast<VkShaderStageFlags>(reflection.stage)
+            });
+        }
+
+        std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const auto& a, const auto& b) {
+            return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+        });
+
+        return reflection;
+    }
+
+    const ShaderModule& ShaderLibrary::LoadLocked(const uint32_t* code, size_t size) {
+        if (size == 0 || size % 4 != 0) {
+            throw std::runtime_error("SPIR-V code size must be a non-zero multiple of 4!");
+        }
+
+        size_t word_count = size / 4;
+        uint64_t hash = Utils::hash_bytes(code, size);
+
+        std::vector<ModuleEntry>& bucket = modules[hash];
+        for (const auto& entry : bucket) {
+            if (entry.code.size() == word_count && std::memcmp(entry.code.data(), code, size) == 0) {
+                return *entry.shader;
+            }
+        }
+
+        // reflect first so bad code never makes it to the driver
+        ShaderReflection reflection = Reflect(code, word_count);
+
+        VkShaderModuleCreateInfo module_info = {
+            .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = size,
+            .pCode = code
+        };
+
+        VkShaderModule module;
+        if (vkCreateShaderModule(a_ctx.device, &module_info, nullptr, &module) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create shader module!");
+        }
+
+        bucket.push_back({
+            .code = std::vector<uint32_t>(code, code + word_count),
+            .shader = std::make_unique<ShaderModule>(ShaderModule {
+                .module = module,
+                .hash = hash,
+                .reflection = std::move(reflection)
+            })
+        });
+
+        return *bucket.back().shader;
+    }
+
+    const ShaderModule& ShaderLibrary::Load(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto found = paths.find(path);
+        if (found != paths.end()) {
+            return *found->second;
+        }
+
+        // shaders are small enough that read ahead hints don't matter
+        MappedFile file(path, false);
+        const ShaderModule* shader = &LoadLocked(static_cast<const uint32_t*>(file.get_data()), file.get_size());
+
+        paths[path] = shader;
+
+        return *shader;
+    }
+
+    const ShaderModule& ShaderLibrary::Load(const uint32_t* code, size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return LoadLocked(code, size);
+    }
+
+    VkDescriptorSetLayout ShaderLibrary::GetSetLayoutLocked(const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+        std::string key;
+        for (const auto& binding : bindings) {
+            uint32_t fields[] = {
+                binding.binding,
+                static_cast<uint32_t>(binding.descriptorType),
+                binding.descriptorCount,
+                binding.stageFlags
+            };
+            key.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+        }
+
+        auto found = set_layouts.find(key);
+        if (found != set_layouts.end()) {
+            return found->second->get_layout();
+        }
+
+        DescriptorSetLayoutCreateInfo layout_info = {
+            .flags = 0,
+            .bindings = bindings.data(),
+            .binding_count = static_cast<uint32_t>(bindings.size())
+        };
+
+        auto layout = std::make_unique<DescriptorSetLayout>(layout_info, a_ctx);
+        VkDescriptorSetLayout handle = layout->get_layout();
+        set_layouts[key] = std::move(layout);
+
+        return handle;
+    }
+
+    ShaderLayout ShaderLibrary::CreateLayout(const ShaderModule* const* shaders, uint32_t shader_count) {
+        // ~~~ merge bindings across stages ~~~
+
+        std::map<std::pair<uint32_t, uint32_t>, ShaderDescriptorBinding> merged;
+        std::vector<VkPushConstantRange> push_constant_ranges;
+
+        for (uint32_t i = 0; i < shader_count; i++) {
+            for (const auto& binding : shaders[i]->reflection.bindings) {
+                auto [it, inserted] = merged.try_emplace({binding.set, binding.binding}, binding);
+                if (inserted) {
+                    continue;
+                }
+
+                if (it->second.type != binding.type || it->second.count != binding.count) {
+                    throw std::runtime_error("Shader stages disagree on a descriptor binding!");
+                }
+                it->second.stages |= binding.stages;
+            }
+
+            // stages using the exact same range share one entry
+            for (const auto& range : shaders[i]->reflection.push_constant_ranges) {
+                auto same = std::find_if(push_constant_ranges.begin(), push_constant_ranges.end(), [&](const auto& other) {
+                    return other.offset == range.offset && other.size == range.size;
+                });
+
+                if (same != push_constant_ranges.end()) {
+                    same->stageFlags |= range.stageFlags;
+                } else {
+                    push_constant_ranges.push_back(range);
+                }
+            }
+        }
+
+        // ~~~ build set layouts, gaps get empty layouts ~~~
+
+        uint32_t set_count = merged.empty() ? 0 : merged.rbegin()->first.first + 1;
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> set_bindings(set_count);
+
+        for (const auto& [location, binding] : merged) {
+            set_bindings[binding.set].push_back({
+                .binding = binding.binding,
+                .descriptorType = binding.type,
+                .descriptorCount = binding.count,
+                .stageFlags = binding.stages,
+                .pImmutableSamplers = nullptr
+            });
+        }
+
+        ShaderLayout layout = {.push_constant_ranges = push_constant_ranges};
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& bindings : set_bindings) {
+            layout.set_layouts.push_back(GetSetLayoutLocked(bindings));
+        }
+
+        return layout;
+    }
+
+    size_t ShaderLibrary::get_module_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        size_t count = 0;
+        for (const auto& [hash, bucket] : modules) {
+            count += bucket.size();
+        }
+
+        return count;
+    }
+}
@@ -0,0 +1,212 @@
+#include "etc/staging_ring.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include "vk_utils.h"
+
+namespace rt {
+    // chunks are half the ring, this leaves them room for at least a
+    //   row of a small uncompressed image
+    constexpr VkDeviceSize MIN_STAGING_RING_SIZE = 2048;
+
+    StagingRing::StagingRing(const StagingRingCreateInfo& create_info, const ApiContext& a_ctx)
+      : upload_context(create_info.upload_context),
+        size(create_info.size),
+        // chunks are capped so a big upload never has to wait
+        //   on the entire ring draining to make progress
+        max_chunk_size(create_info.size / 2),
+        head(0) {
+        if (upload_context == nullptr) {
+            throw std::runtime_error("Cannot create staging ring without an upload context!");
+        }
+
+        // a zero sized chunk would never make progress
+        if (create_info.size < MIN_STAGING_RING_SIZE) {
+            throw std::runtime_error("Staging ring is too small to be useful!");
+        }
+
+        BufferCreateInfo buffer_info = {
+            .size = create_info.size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            .allocator = create_info.allocator
+        };
+        buffer = std::make_unique<Buffer>(buffer_info, a_ctx);
+
+        // stays mapped for the ring's whole lifetime
+        buffer->Map();
+    }
+
+    StagingRing::~StagingRing() {
+        if (!regions.empty()) {
+            upload_context->Wait(regions.back().token);
+        }
+    }
+
+    void StagingRing::Reclaim() {
+        while (!regions.empty() && upload_context->IsComplete(regions.front().token)) {
+            regions.pop_front();
+        }
+    }
+
+    bool StagingRing::TryReserve(VkDeviceSize reserve_size, VkDeviceSize alignment, VkDeviceSize* out_offset) {
+        if (regions.empty()) {
+            head = 0;
+        }
+
+        VkDeviceSize aligned_head = (head + alignment - 1) / alignment * alignment;
+
+        if (regions.empty()) {
+            *out_offset = 0;
+            return reserve_size <= size;
+        }
+
+        // head is always the end of the newest region and tail the
+        //   start of the oldest, so head <= tail means we've wrapped
+        VkDeviceSize tail = regions.front().begin;
+        if (head <= tail) {
+            if (aligned_head + reserve_size <= tail) {
+                *out_offset = aligned_head;
+                return true;
+            }
+            return false;
+        }
+
+        // not wrapped, try after the head first then the start of the ring
+        if (aligned_head + reserve_size <= size) {
+            *out_offset = aligned_head;
+            return true;
+        }
+
+        if (reserve_size <= tail) {
+            *out_offset = 0;
+            return true;
+        }
+
+        return false;
+    }
+
+    VkDeviceSize StagingRing::Reserve(VkDeviceSize reserve_size, VkDeviceSize alignment) {
+        if (reserve_size > size) {
+            throw std::runtime_error("Staging ring reservation is larger than the ring itself!");
+        }
+
+        Reclaim();
+
+        VkDeviceSize offset = 0;
+        while (!TryReserve(reserve_size, alignment, &offset)) {
+            // out of room, wait on the oldest upload (this submits the
+            //   current batch if that's the one holding the space)
+            upload_context->Wait(regions.front().token);
+            Reclaim();
+        }
+
+        // the caller records its copy straight after, so open the batch
+        //   now to tag the region with the token that copy completes with
+        upload_context->AcquireCommandBuffer();
+        UploadToken token = upload_context->get_recording_token();
+
+        // merge with the newest region when we can to keep this small
+        if (!regions.empty() && regions.back().token == token && regions.back().end <= offset) {
+            regions.back().end = offset + reserve_size;
+        } else {
+            regions.push_back({
+                .begin = offset,
+                .end = offset + reserve_size,
+                .token = token
+            });
+        }
+
+        head = offset + reserve_size;
+
+        return offset;
+    }
+
+    void StagingRing::CopyToBuffer(const void* data, VkDeviceSize data_size, Buffer& dst, VkDeviceSize dst_offset) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+        VkDeviceSize copied = 0;
+        while (copied < data_size) {
+            VkDeviceSize chunk_size = std::min(data_size - copied, max_chunk_size);
+            VkDeviceSize offset = Reserve(chunk_size, 4);
+
+            buffer->CopyFromHost(bytes + copied, static_cast<size_t>(chunk_size), offset);
+
+            VkBufferCopy region = {
+                .srcOffset = offset,
+                .dstOffset = dst_offset + copied,
+                .size = chunk_size
+            };
+            vkCmdCopyBuffer(upload_context->AcquireCommandBuffer(), buffer->get_buffer(), dst.get_buffer(), 1, &region);
+
+            copied += chunk_size;
+        }
+    }
+
+    void StagingRing::CopyToImage(const void* data, VkDeviceSize data_size, Image& dst) {
+        // checked before anything goes into the shared batch
+        if (dst.get_mip_levels() > 1 && !dst.get_can_generate_mips()) {
+            throw std::runtime_error("Image format doesn't support generating mipmaps!");
+        }
+
+        dst.CmdTransitionToLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, upload_context->AcquireCommandBuffer());
+        CopyToImageLevel(data, data_size, dst, 0);
+        dst.CmdFinishUpload(*upload_context);
+    }
+
+    void StagingRing::CopyToImageLevel(const void* data, VkDeviceSize data_size, Image& dst, uint32_t mip_level) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        VkExtent2D extent = dst.get_level_extent(mip_level);
+
+        // images are chunked by whole rows of texels, or of 4x4 blocks
+        //   for compressed formats
+        uint32_t row_height = Utils::get_format_block_size(dst.get_format()) > 0 ? 4 : 1;
+        uint32_t row_total = (extent.height + row_height - 1) / row_height;
+
+        VkDeviceSize row_size = data_size / row_total;
+        if (row_size > max_chunk_size) {
+            throw std::runtime_error("Staging ring is too small to upload a single row of this image!");
+        }
+        uint32_t rows_per_chunk = static_cast<uint32_t>(max_chunk_size / row_size);
+        VkDeviceSize alignment = Utils::get_copy_offset_alignment(dst.get_format());
+
+        uint32_t row = 0;
+        while (row < row_total) {
+            uint32_t row_count = std::min(rows_per_chunk, row_total - row);
+            VkDeviceSize chunk_size = row_size * row_count;
+
+            VkDeviceSize offset = Reserve(chunk_size, alignment);
+            buffer->CopyFromHost(bytes + row_size * row, static_cast<size_t>(chunk_size), offset);
+
+            uint32_t y = row * row_height;
+            VkBufferImageCopy region = {
+                .bufferOffset = offset,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = mip_level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                },
+                .imageOffset = {0, static_cast<int32_t>(y), 0},
+                // the last block row may hang off the edge of the level
+                .imageExtent = {extent.width, std::min(row_count * row_height, extent.height - y), 1}
+            };
+
+            vkCmdCopyBufferToImage(
+                upload_context->AcquireCommandBuffer(),
+                buffer->get_buffer(),
+                dst.get_image(),
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1,
+                &region
+            );
+
+            row += row_count;
+        }
+    }
+
+    UploadContext& StagingRing::get_upload_context() const { return *upload_context; }
+    VkDeviceSize StagingRing::get_size() const { return size; }
+}
@@ -19,6 +19,12 @@ namespace rt {
             Utils::choose_swap_extent(details.capabilities, a_ctx.window)
         );
 
+        // transfer src lets frames be read back, most surfaces allow it
+        VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if ((details.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0) {
+            usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
         uint32_t image_count = details.capabilities.minImageCount + (create_info.frame_flight_count - 1);
         if (details.capabilities.maxImageCount > 0 && image_count > details.capabilities.maxImageCount) {
             image_count = details.capabilities.maxImageCount;
@@ -33,7 +39,7 @@ namespace rt {
             .imageColorSpace = surface_format.colorSpace,
             .imageExtent = extent,
             .imageArrayLayers = 1,
-            .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            .imageUsage = usage,
             // misc info about behavior
             .preTransform = details.capabilities.currentTransform,
             .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
@@ -72,9 +78,40 @@ namespace rt {
         vkGetSwapchainImagesKHR(a_ctx.device, swap_chain, &image_count, images.data());
 
         this->image_format = surface_format.format;
+        this->image_usage = usage;
         this->extent = extent;
     }
 
+    void SwapChain::CreateOffscreenImages(const SwapChainCreateInfo& create_info, const ApiContext& a_ctx) {
+        if (!create_info.extent.has_value()) {
+            throw std::runtime_error("Headless swap chains need an explicit extent!");
+        }
+
+        image_format = create_info.surface_format.has_value()
+            ? create_info.surface_format->format
+            : OFFSCREEN_DEFAULT_FORMAT;
+        image_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        extent = create_info.extent.value();
+
+        // frames in flight never share a target, the frame
+        //   fence guarantees a target is free when reused
+        ImageCreateInfo image_create_info = {
+            .width = extent.width,
+            .height = extent.height,
+            .format = image_format,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .image_usage = image_usage,
+            .memory_properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            .view_aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT
+        };
+
+        for (uint32_t i = 0; i < frame_flight_count; i++) {
+            offscreen_images.push_back(std::make_unique<Image>(image_create_info, a_ctx));
+            images.push_back(offscreen_images.back()->get_image());
+            image_views.push_back(offscreen_images.back()->get_view());
+        }
+    }
+
     void SwapChain::CreateImageViews(const ApiContext& a_ctx) {
         image_views.resize(images.size());
 
@@ -148,6 +185,8 @@ namespace rt {
 
     SwapChain::SwapChain(const SwapChainCreateInfo& create_info, const GraphicsContext& g_ctx, const ApiContext& a_ctx)
       : device(a_ctx.device),
+        swap_chain(nullptr),
+        headless(a_ctx.surface == nullptr),
         frame_flight_count(create_info.frame_flight_count),
         image_index(0),
         frame_flight_index(0) {
@@ -155,8 +194,12 @@ namespace rt {
             throw std::runtime_error("Cannot create swap chain with a frame flight count of zero!");
         }
 
-        CreateSwapChain(create_info, a_ctx);
-        CreateImageViews(a_ctx);
+        if (headless) {
+            CreateOffscreenImages(create_info, a_ctx);
+        } else {
+            CreateSwapChain(create_info, a_ctx);
+            CreateImageViews(a_ctx);
+        }
         CreateDepthImage(create_info, g_ctx, a_ctx);
         CreateFrameBuffers(create_info, a_ctx);
     }
@@ -170,6 +213,12 @@ namespace rt {
             vkDestroyFramebuffer(device, framebuffer, nullptr);
         }
 
+        if (headless) {
+            // views are owned by the images
+            offscreen_images.clear();
+            return;
+        }
+
         for (auto image_view : image_views) {
             vkDestroyImageView(device, image_view, nullptr);
         }
@@ -178,6 +227,13 @@ namespace rt {
     }
 
     VkResult SwapChain::NextImage(VkSemaphore semaphore, VkFence fence) {
+        if (headless) {
+            // targets are tied to frames in flight, so the
+            //   target is already free once the frame is
+            image_index = frame_flight_index;
+            return VK_SUCCESS;
+        }
+
         return vkAcquireNextImageKHR(
             device,
             swap_chain,
@@ -196,9 +252,11 @@ namespace rt {
     uint32_t SwapChain::get_image_index() const { return image_index; }
     VkExtent2D SwapChain::get_extent() const { return extent; }
     VkFormat SwapChain::get_image_format() const { return image_format; }
+    VkImageUsageFlags SwapChain::get_image_usage() const { return image_usage; }
     VkFormat SwapChain::get_depth_format() const { return depth_image->get_format(); }
     uint32_t SwapChain::get_image_count() const { return static_cast<uint32_t>(images.size()); }
     uint32_t SwapChain::get_frame_flight_count() const { return frame_flight_count; }
+    bool SwapChain::is_headless() const { return headless; }
     VkSwapchainKHR SwapChain::get_swap_chain() const { return swap_chain; }
     VkFramebuffer SwapChain::get_current_framebuffer() const { return framebuffers[image_index]; }
     const std::vector<VkImage>& SwapChain::get_images() const { return images; }
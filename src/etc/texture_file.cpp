@@ -0,0 +1,173 @@
+#include "etc/texture_file.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <algorithm>
+#include "vk_utils.h"
+
+namespace rt {
+    TextureFile::TextureFile(const std::string& path)
+      : mapping(path),
+        header(nullptr) {
+        size_t size = mapping.get_size();
+        if (size < sizeof(TextureFileHeader)) {
+            throw std::runtime_error("Texture file is truncated or corrupt: " + path);
+        }
+
+        // ~~~ validate, only bounds and sizes are checked ~~~
+
+        header = static_cast<const TextureFileHeader*>(mapping.get_data());
+
+        const char* error = nullptr;
+        if (header->magic != TEXTURE_FILE_MAGIC) {
+            error = "Not a texture file: ";
+        } else if (header->version != TEXTURE_FILE_VERSION) {
+            error = "Unsupported texture file version: ";
+        } else if (
+            header->width == 0 ||
+            header->height == 0 ||
+            header->level_count == 0 ||
+            header->level_count > Utils::get_full_mip_count(header->width, header->height) ||
+            sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * static_cast<uint64_t>(header->level_count) > size
+        ) {
+            error = "Texture file is truncated or corrupt: ";
+        } else {
+            VkFormat format = static_cast<VkFormat>(header->format);
+            if (Utils::get_format_block_size(format) == 0) {
+                // throws for formats we don't know the size of
+                try {
+                    Utils::get_format_texel_size(format);
+                } catch (const std::runtime_error&) {
+                    error = "Texture file has an unsupported format: ";
+                }
+            }
+
+            for (uint32_t i = 0; error == nullptr && i < header->level_count; i++) {
+                const TextureFileLevel& level = get_levels()[i];
+                if (
+                    level.width != std::max(header->width >> i, 1u) ||
+                    level.height != std::max(header->height >> i, 1u) ||
+                    level.offset % TEXTURE_FILE_ALIGNMENT != 0 ||
+                    level.offset > size ||
+                    level.size > size - level.offset ||
+                    level.size != Utils::get_image_level_size(format, level.width, level.height)
+                ) {
+                    error = "Texture file has a truncated or corrupt level: ";
+                    break;
+                }
+            }
+        }
+
+        if (error != nullptr) {
+            throw std::runtime_error(error + path);
+        }
+    }
+
+    TextureFile::~TextureFile() { }
+
+    void TextureFile::Write(const std::string& path, const TextureFileWriteInfo& write_info) {
+        if (write_info.level_count == 0 || write_info.level_count > Utils::get_full_mip_count(write_info.width, write_info.height)) {
+            throw std::runtime_error("Texture file has an invalid number of levels!");
+        }
+
+        TextureFileHeader header = {
+            .magic = TEXTURE_FILE_MAGIC,
+            .version = TEXTURE_FILE_VERSION,
+            .format = static_cast<uint32_t>(write_info.format),
+            .width = write_info.width,
+            .height = write_info.height,
+            .level_count = write_info.level_count,
+            .reserved = 0
+        };
+
+        uint64_t tables_end = sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * static_cast<uint64_t>(write_info.level_count);
+
+        std::vector<TextureFileLevel> levels(write_info.level_count);
+        uint64_t offset = Utils::align_up(tables_end, TEXTURE_FILE_ALIGNMENT);
+        for (uint32_t i = 0; i < write_info.level_count; i++) {
+            levels[i] = {
+                .offset = offset,
+                .size = write_info.levels[i].size,
+                .width = std::max(write_info.width >> i, 1u),
+                .height = std::max(write_info.height >> i, 1u)
+            };
+
+            if (levels[i].size != Utils::get_image_level_size(write_info.format, levels[i].width, levels[i].height)) {
+                throw std::runtime_error("Texture file level data is the wrong size!");
+            }
+
+            offset = Utils::align_up(offset + levels[i].size, TEXTURE_FILE_ALIGNMENT);
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file for writing: " + path);
+        }
+
+        const char padding[TEXTURE_FILE_ALIGNMENT] = {};
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(levels.data()), sizeof(TextureFileLevel) * levels.size());
+
+        uint64_t written = tables_end;
+        for (uint32_t i = 0; i < write_info.level_count; i++) {
+            file.write(padding, static_cast<std::streamsize>(levels[i].offset - written));
+            file.write(static_cast<const char*>(write_info.levels[i].data), static_cast<std::streamsize>(levels[i].size));
+            written = levels[i].offset + levels[i].size;
+        }
+
+        if (!file.good()) {
+            throw std::runtime_error("Failed to write file: " + path);
+        }
+    }
+
+    ImageCreateInfo TextureFile::get_image_create_info(VkPhysicalDevice physical_device) const {
+        VkFormat format;
+        try {
+            format = Utils::find_supported_format(
+                {get_format()},
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT,
+                physical_device
+            );
+        } catch (const std::runtime_error&) {
+            throw std::runtime_error("Texture file format isn't supported by this device!");
+        }
+
+        ImageCreateInfo create_info = {
+            .width = header->width,
+            .height = header->height,
+            .format = format,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .image_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            .memory_properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            .view_aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mip_levels = header->level_count
+        };
+
+        return create_info;
+    }
+
+    std::vector<ImageLevelData> TextureFile::get_level_data() const {
+        std::vector<ImageLevelData> level_data(header->level_count);
+        for (uint32_t i = 0; i < header->level_count; i++) {
+            level_data[i] = {
+                .data = static_cast<const uint8_t*>(mapping.get_data()) + get_levels()[i].offset,
+                .size = get_levels()[i].size
+            };
+        }
+
+        return level_data;
+    }
+
+    const TextureFileHeader& TextureFile::get_header() const { return *header; }
+
+    const TextureFileLevel* TextureFile::get_levels() const {
+        return reinterpret_cast<const TextureFileLevel*>(static_cast<const uint8_t*>(mapping.get_data()) + sizeof(TextureFileHeader));
+    }
+
+    VkFormat TextureFile::get_format() const { return static_cast<VkFormat>(header->format); }
+    uint32_t TextureFile::get_width() const { return header->width; }
+    uint32_t TextureFile::get_height() const { return header->height; }
+    uint32_t TextureFile::get_level_count() const { return header->level_count; }
+}
@@ -0,0 +1,414 @@
+#include "etc/texture_streamer.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace rt {
+    constexpr uint32_t DEFAULT_TAIL_SIZE = 64;
+
+    TextureStreamer::TextureStreamer(const TextureStreamerCreateInfo& create_info, const ApiContext& a_ctx)
+      : a_ctx(a_ctx),
+        budget(create_info.budget),
+        max_upload_bytes_per_frame(create_info.max_upload_bytes_per_frame),
+        tail_size(create_info.tail_size > 0 ? create_info.tail_size : DEFAULT_TAIL_SIZE),
+        staging_ring(create_info.staging_ring),
+        retire_queue(create_info.retire_queue),
+        allocator(create_info.allocator),
+        frame_number(0),
+        retiring_bytes(std::make_shared<std::atomic<VkDeviceSize>>(0)) {
+        if (staging_ring == nullptr || retire_queue == nullptr) {
+            throw std::runtime_error("Texture streamer needs a staging ring and a retire queue!");
+        }
+    }
+
+    TextureStreamer::~TextureStreamer() {
+        for (auto& texture : textures) {
+            RetirePending(texture);
+        }
+
+        // nothing is left to settle the budget of, so unfinished uploads
+        //   just hold their image until the upload is done with it.
+        //   destroying it then retires its handles on the frame queue
+        for (auto& abandoned : abandoned_uploads) {
+            staging_ring->get_upload_context().get_retire_queue().QueueRetire(
+                [image = std::shared_ptr<Image>(std::move(abandoned.image))] { }
+            );
+        }
+    }
+
+    void TextureStreamer::RetireImage(std::unique_ptr<Image> image, VkDeviceSize bytes) {
+        *retiring_bytes += bytes;
+        QueueImageRetire(std::move(image), bytes);
+    }
+
+    void TextureStreamer::QueueImageRetire(std::unique_ptr<Image> image, VkDeviceSize bytes) {
+        // destroying the image queues its handles on the frame retire
+        //   queue, the bytes are credited right after those are freed.
+        //   both run on that same queue so the pointer is always valid
+        retire_queue->QueueRetire([
+            image = std::shared_ptr<Image>(std::move(image)),
+            retiring_bytes = retiring_bytes,
+            retire_queue = retire_queue,
+            bytes
+        ]() mutable {
+            image.reset();
+            retire_queue->QueueRetire([retiring_bytes, bytes] { *retiring_bytes -= bytes; });
+        });
+    }
+
+    void TextureStreamer::RetirePending(Texture& texture) {
+        if (texture.pending == nullptr) {
+            return;
+        }
+
+        // the upload may still be writing the image and can finish after
+        //   the frames in flight do, so it's held here until Update sees
+        //   its token complete. it then retires on the frame queue as
+        //   usual in case a frame recorded its acquire barrier
+        VkDeviceSize bytes = texture.pending->get_memory_size();
+        *retiring_bytes += bytes;
+        abandoned_uploads.push_back({
+            .image = std::move(texture.pending),
+            .token = texture.pending_token,
+            .bytes = bytes
+        });
+    }
+
+    VkDeviceSize TextureStreamer::GetChainSize(const TextureFile& file, uint32_t first_level) {
+        VkDeviceSize chain_size = 0;
+        for (uint32_t level = first_level; level < file.get_level_count(); level++) {
+            chain_size += file.get_levels()[level].size;
+        }
+
+        return chain_size;
+    }
+
+    ImageCreateInfo TextureStreamer::GetImageCreateInfo(const TextureFile& file, uint32_t first_level) const {
+        ImageCreateInfo image_info = file.get_image_create_info(a_ctx.physical_device);
+        image_info.width = file.get_levels()[first_level].width;
+        image_info.height = file.get_levels()[first_level].height;
+        image_info.mip_levels = file.get_level_count() - first_level;
+        image_info.allocator = allocator;
+        image_info.retire_queue = retire_queue;
+
+        return image_info;
+    }
+
+    VkDeviceSize TextureStreamer::GetImageSize(Texture& texture, uint32_t first_level) {
+        VkDeviceSize& memory_size = texture.memory_sizes[first_level];
+        if (memory_size == 0) {
+            memory_size = Image::QueryMemorySize(GetImageCreateInfo(*texture.file, first_level), a_ctx);
+        }
+
+        return memory_size;
+    }
+
+    VkDeviceSize TextureStreamer::GetHeldSize(const Texture& texture) const {
+        VkDeviceSize held = texture.image != nullptr ? texture.image->get_memory_size() : 0;
+        if (texture.pending != nullptr) {
+            held += texture.pending->get_memory_size();
+        }
+
+        return held;
+    }
+
+    VkDeviceSize TextureStreamer::GetSettledSize(const Texture& texture) const {
+        if (texture.pending != nullptr) {
+            return texture.pending->get_memory_size();
+        }
+
+        return texture.image != nullptr ? texture.image->get_memory_size() : 0;
+    }
+
+    VkDeviceSize TextureStreamer::StartUpload(TextureHandle handle, uint32_t first_level) {
+        Texture& texture = textures[handle];
+        const TextureFile& file = *texture.file;
+        ImageCreateInfo image_info = GetImageCreateInfo(file, first_level);
+
+        // level data points into the mapping, so nothing is copied until
+        //   it goes into the ring
+        std::vector<ImageLevelData> levels = file.get_level_data();
+
+        texture.pending = std::make_unique<Image>(image_info, a_ctx);
+        texture.pending->CopyLevels(levels.data() + first_level, image_info.mip_levels, *staging_ring);
+        texture.pending_level = first_level;
+        texture.pending_token = staging_ring->get_upload_context().get_recording_token();
+        texture.memory_sizes[first_level] = texture.pending->get_memory_size();
+
+        return GetChainSize(file, first_level);
+    }
+
+    bool TextureStreamer::EvictOne(TextureHandle keep, VkDeviceSize* upload_bytes, VkDeviceSize* held, VkDeviceSize* settled) {
+        // only levels finer than the tail can go, starting with whatever
+        //   has gone unused the longest
+        int64_t victim = -1;
+        for (TextureHandle handle = 0; handle < textures.size(); handle++) {
+            const Texture& texture = textures[handle];
+            if (
+                handle == keep ||
+                !texture.alive ||
+                texture.pending != nullptr ||
+                texture.image == nullptr ||
+                texture.resident_level >= texture.tail_level
+            ) {
+                continue;
+            }
+
+            // used last frame and needs every level it has
+            if (texture.last_used_frame + 1 >= frame_number && texture.wanted_level <= texture.resident_level) {
+                continue;
+            }
+
+            if (victim < 0 || texture.last_used_frame < textures[victim].last_used_frame) {
+                victim = handle;
+            }
+        }
+
+        if (victim < 0) {
+            return false;
+        }
+
+        // dropping a level needs a smaller image, which is uploaded again
+        //   from the file like any other change. it's allocated now, but
+        //   the old image is only freed once it's swapped out and retired
+        Texture& texture = textures[victim];
+        VkDeviceSize live_bytes = texture.image->get_memory_size();
+        *upload_bytes += StartUpload(static_cast<TextureHandle>(victim), texture.resident_level + 1);
+
+        VkDeviceSize shrunk_bytes = texture.pending->get_memory_size();
+        *held += shrunk_bytes;
+        *settled = *settled - live_bytes + shrunk_bytes;
+        return true;
+    }
+
+    TextureHandle TextureStreamer::Add(std::shared_ptr<const TextureFile> file) {
+        // checks format support up front instead of on the first upload
+        file->get_image_create_info(a_ctx.physical_device);
+
+        uint32_t tail_level = file->get_level_count() - 1;
+        for (uint32_t level = 0; level < file->get_level_count(); level++) {
+            if (std::max(file->get_levels()[level].width, file->get_levels()[level].height) <= tail_size) {
+                tail_level = level;
+                break;
+            }
+        }
+
+        TextureHandle handle;
+        if (!free_handles.empty()) {
+            handle = free_handles.back();
+            free_handles.pop_back();
+        } else {
+            handle = static_cast<TextureHandle>(textures.size());
+            textures.emplace_back();
+        }
+
+        Texture& texture = textures[handle];
+        texture.file = std::move(file);
+        texture.image = nullptr;
+        texture.resident_level = texture.file->get_level_count();
+        texture.tail_level = tail_level;
+        texture.memory_sizes.assign(texture.file->get_level_count(), 0);
+        texture.pending = nullptr;
+        texture.pending_level = 0;
+        texture.pending_token = 0;
+        texture.wanted_level = tail_level;
+        texture.last_used_frame = frame_number;
+        texture.alive = true;
+
+        return handle;
+    }
+
+    void TextureStreamer::Remove(TextureHandle handle) {
+        Texture& texture = textures.at(handle);
+        if (!texture.alive) {
+            throw std::runtime_error("Texture handle was already removed!");
+        }
+
+        // the live image retires once frames in flight are done with it
+        if (texture.image != nullptr) {
+            VkDeviceSize bytes = texture.image->get_memory_size();
+            RetireImage(std::move(texture.image), bytes);
+        }
+        RetirePending(texture);
+        texture.file = nullptr;
+        texture.alive = false;
+
+        free_handles.push_back(handle);
+    }
+
+    void TextureStreamer::RequestLevel(TextureHandle handle, uint32_t level) {
+        Texture& texture = textures.at(handle);
+        if (!texture.alive) {
+            throw std::runtime_error("Texture handle was removed!");
+        }
+
+        texture.wanted_level = std::min(texture.wanted_level, level);
+        texture.last_used_frame = frame_number;
+    }
+
+    void TextureStreamer::Update(uint64_t new_frame_number) {
+        frame_number = new_frame_number;
+        changed.clear();
+
+        UploadContext& upload = staging_ring->get_upload_context();
+
+        // ~~~ retire uploads finished after their texture was removed ~~~
+
+        auto finished = std::remove_if(abandoned_uploads.begin(), abandoned_uploads.end(), [&](AbandonedUpload& abandoned) {
+            if (!upload.IsComplete(abandoned.token)) {
+                return false;
+            }
+
+            QueueImageRetire(std::move(abandoned.image), abandoned.bytes);
+            return true;
+        });
+        abandoned_uploads.erase(finished, abandoned_uploads.end());
+
+        // ~~~ swap in finished uploads ~~~
+
+        for (TextureHandle handle = 0; handle < textures.size(); handle++) {
+            Texture& texture = textures[handle];
+            if (!texture.alive || texture.pending == nullptr || !upload.IsComplete(texture.pending_token)) {
+                continue;
+            }
+
+            // the old image retires once frames using it are done
+            if (texture.image != nullptr) {
+                VkDeviceSize bytes = texture.image->get_memory_size();
+                RetireImage(std::move(texture.image), bytes);
+            }
+            texture.image = std::move(texture.pending);
+            texture.resident_level = texture.pending_level;
+            changed.push_back(handle);
+        }
+
+        // ~~~ pick what to load ~~~
+
+        // held is what's allocated right now, settled is what will be once
+        //   pending uploads land and the images they replace retire
+        std::vector<TextureHandle> candidates;
+        VkDeviceSize held = *retiring_bytes;
+        VkDeviceSize settled = 0;
+        for (TextureHandle handle = 0; handle < textures.size(); handle++) {
+            const Texture& texture = textures[handle];
+            if (!texture.alive) {
+                continue;
+            }
+
+            held += GetHeldSize(texture);
+            settled += GetSettledSize(texture);
+            if (texture.pending == nullptr && std::min(texture.wanted_level, texture.tail_level) < texture.resident_level) {
+                candidates.push_back(handle);
+            }
+        }
+
+        // textures without their tail come first so everything has
+        //   something to show, then the ones furthest from what they
+        //   asked for, then the most recently used
+        std::sort(candidates.begin(), candidates.end(), [this](TextureHandle a, TextureHandle b) {
+            const Texture& ta = textures[a];
+            const Texture& tb = textures[b];
+
+            bool a_empty = ta.image == nullptr;
+            bool b_empty = tb.image == nullptr;
+            if (a_empty != b_empty) {
+                return a_empty;
+            }
+
+            uint32_t a_gap = ta.resident_level - std::min(ta.wanted_level, ta.tail_level);
+            uint32_t b_gap = tb.resident_level - std::min(tb.wanted_level, tb.tail_level);
+            if (a_gap != b_gap) {
+                return a_gap > b_gap;
+            }
+
+            return ta.last_used_frame > tb.last_used_frame;
+        });
+
+        VkDeviceSize upload_bytes = 0;
+        for (TextureHandle handle : candidates) {
+            if (upload_bytes > 0 && upload_bytes >= max_upload_bytes_per_frame) {
+                break;
+            }
+
+            // evictions above may have given it a smaller upload already
+            Texture& texture = textures[handle];
+            if (texture.pending != nullptr) {
+                continue;
+            }
+
+            // one level at a time, so coarse levels show up quickly
+            uint32_t target_level = texture.image == nullptr ? texture.tail_level : texture.resident_level - 1;
+            VkDeviceSize live_bytes = GetSettledSize(texture);
+            VkDeviceSize target_bytes = GetImageSize(texture, target_level);
+
+            // tails always load, anything finer has to fit the budget with
+            //   the new image and the one it replaces both allocated
+            if (target_level < texture.tail_level) {
+                while (settled + target_bytes > budget && EvictOne(handle, &upload_bytes, &held, &settled)) { }
+
+                // evictions only free memory once their old images retire,
+                //   until then this waits for a later Update
+                if (held + target_bytes > budget) {
+                    continue;
+                }
+            }
+
+            upload_bytes += StartUpload(handle, target_level);
+            held += target_bytes;
+            settled = settled - live_bytes + target_bytes;
+        }
+
+        // nothing else submits the upload context when it shares the
+        //   graphics queue, and pending images are only swapped in once
+        //   their batch finishes
+        if (upload_bytes > 0) {
+            upload.Submit();
+        }
+
+        // feedback has to be given again every frame
+        for (auto& texture : textures) {
+            texture.wanted_level = texture.tail_level;
+        }
+    }
+
+    uint32_t TextureStreamer::get_wanted_level(uint32_t texture_size, float projected_size) {
+        if (projected_size <= 0.0f) {
+            return UINT32_MAX;
+        }
+
+        float level = std::floor(std::log2(static_cast<float>(texture_size) / projected_size));
+        return level > 0.0f ? static_cast<uint32_t>(level) : 0;
+    }
+
+    const Image* TextureStreamer::get_image(TextureHandle handle) const {
+        const Texture& texture = textures.at(handle);
+        if (!texture.alive) {
+            throw std::runtime_error("Texture handle was removed!");
+        }
+
+        return texture.image.get();
+    }
+
+    uint32_t TextureStreamer::get_resident_level(TextureHandle handle) const {
+        const Texture& texture = textures.at(handle);
+        if (!texture.alive) {
+            throw std::runtime_error("Texture handle was removed!");
+        }
+
+        return texture.resident_level;
+    }
+
+    const std::vector<TextureHandle>& TextureStreamer::get_changed() const { return changed; }
+
+    VkDeviceSize TextureStreamer::get_committed_bytes() const {
+        VkDeviceSize committed = *retiring_bytes;
+        for (const auto& texture : textures) {
+            committed += texture.alive ? GetHeldSize(texture) : 0;
+        }
+
+        return committed;
+    }
+
+    VkDeviceSize TextureStreamer::get_budget() const { return budget; }
+}
@@ -0,0 +1,381 @@
+#include "etc/upload_context.h"
+
+#include <stdexcept>
+#include <iterator>
+
+namespace rt {
+    UploadContext::UploadContext(const UploadContextCreateInfo& create_info, const ApiContext& a_ctx)
+      : device(a_ctx.device),
+        queue(create_info.queue),
+        queue_family_index(create_info.queue_family_index),
+        dst_queue_family_index(create_info.dst_queue_family_index.value_or(create_info.queue_family_index)),
+        transfers_ownership(dst_queue_family_index != queue_family_index),
+        is_recording(false),
+        next_token(1),
+        completed_token(0) {
+        VkCommandPoolCreateInfo pool_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = create_info.queue_family_index
+        };
+
+        if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create upload command pool!");
+        }
+
+        recording_acquires.dst_stages = 0;
+        handoff.dst_stages = 0;
+    }
+
+    UploadContext::~UploadContext() {
+        Flush();
+
+        for (auto& batch : free_batches) {
+            vkDestroyFence(device, batch.fence, nullptr);
+        }
+
+        // anything never taken was signaled by now, which is fine to destroy
+        for (VkSemaphore semaphore : handoff.semaphores) {
+            vkDestroySemaphore(device, semaphore, nullptr);
+        }
+
+        for (VkSemaphore semaphore : free_semaphores) {
+            vkDestroySemaphore(device, semaphore, nullptr);
+        }
+
+        // command buffers are freed along with the pool
+        vkDestroyCommandPool(device, command_pool, nullptr);
+    }
+
+    void UploadContext::BeginBatch() {
+        // recycle an old batch if we have one so we aren't
+        //   creating fences and command buffers all the time
+        if (!free_batches.empty()) {
+            recording = std::move(free_batches.back());
+            free_batches.pop_back();
+
+            vkResetFences(device, 1, &recording.fence);
+            vkResetCommandBuffer(recording.command_buffer, 0);
+        } else {
+            VkCommandBufferAllocateInfo alloc_info = {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                .commandPool = command_pool,
+                .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                .commandBufferCount = 1
+            };
+
+            if (vkAllocateCommandBuffers(device, &alloc_info, &recording.command_buffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate upload command buffer!");
+            }
+
+            VkFenceCreateInfo fence_info = {
+                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+            };
+
+            if (vkCreateFence(device, &fence_info, nullptr, &recording.fence) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create upload fence!");
+            }
+        }
+
+        recording.token = next_token++;
+        recording.on_complete.clear();
+        retire_queue.set_current_value(recording.token);
+
+        VkCommandBufferBeginInfo begin_info = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+        };
+
+        if (vkBeginCommandBuffer(recording.command_buffer, &begin_info) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin upload command buffer!");
+        }
+
+        is_recording = true;
+    }
+
+    void UploadContext::RetireFront() {
+        Batch batch = std::move(in_flight.front());
+        in_flight.pop_front();
+
+        for (auto& func : batch.on_complete) {
+            func();
+        }
+        batch.on_complete.clear();
+
+        completed_token = batch.token;
+        retire_queue.Retire(completed_token);
+        free_batches.push_back(std::move(batch));
+    }
+
+    VkCommandBuffer UploadContext::AcquireCommandBuffer() {
+        if (!is_recording) {
+            BeginBatch();
+        }
+
+        return recording.command_buffer;
+    }
+
+    UploadToken UploadContext::get_recording_token() const {
+        return is_recording ? recording.token : next_token - 1;
+    }
+
+    void UploadContext::QueueOnComplete(std::function<void()> func) {
+        if (!is_recording) {
+            BeginBatch();
+        }
+
+        recording.on_complete.push_back(func);
+    }
+
+    DestructionQueue& UploadContext::get_retire_queue() { return retire_queue; }
+
+    void UploadContext::ReleaseBuffer(
+        VkBuffer buffer,
+        VkAccessFlags dst_access,
+        VkPipelineStageFlags dst_stage,
+        VkDeviceSize offset,
+        VkDeviceSize size
+    ) {
+        if (!transfers_ownership) {
+            return;
+        }
+
+        if (!is_recording) {
+            BeginBatch();
+        }
+
+        // the release half only needs the source access, the
+        //   destination access belongs to the acquire half
+        VkBufferMemoryBarrier release = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = 0,
+            .srcQueueFamilyIndex = queue_family_index,
+            .dstQueueFamilyIndex = dst_queue_family_index,
+            .buffer = buffer,
+            .offset = offset,
+            .size = size
+        };
+
+        vkCmdPipelineBarrier(
+            recording.command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            1, &release,
+            0, nullptr
+        );
+
+        // the acquire has to name the same range as the release
+        VkBufferMemoryBarrier acquire = release;
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = dst_access;
+
+        recording_acquires.buffer_barriers.push_back(acquire);
+        recording_acquires.dst_stages |= dst_stage;
+    }
+
+    void UploadContext::ReleaseImage(
+        VkImage image,
+        VkImageAspectFlags aspect,
+        VkImageLayout old_layout,
+        VkImageLayout new_layout,
+        VkAccessFlags dst_access,
+        VkPipelineStageFlags dst_stage
+    ) {
+        if (!is_recording) {
+            BeginBatch();
+        }
+
+        VkImageMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = transfers_ownership ? 0 : dst_access,
+            .oldLayout = old_layout,
+            .newLayout = new_layout,
+            .srcQueueFamilyIndex = transfers_ownership ? queue_family_index : VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = transfers_ownership ? dst_queue_family_index : VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = {
+                .aspectMask = aspect,
+                .baseMipLevel = 0,
+                .levelCount = VK_REMAINING_MIP_LEVELS,
+                .baseArrayLayer = 0,
+                .layerCount = VK_REMAINING_ARRAY_LAYERS
+            }
+        };
+
+        // the dst stage may not be supported by a transfer only
+        //   queue, so the release half ends at bottom of pipe
+        vkCmdPipelineBarrier(
+            recording.command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            transfers_ownership ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : dst_stage,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier
+        );
+
+        if (transfers_ownership) {
+            // the layout transition happens once, so both halves
+            //   must describe it identically
+            VkImageMemoryBarrier acquire = barrier;
+            acquire.srcAccessMask = 0;
+            acquire.dstAccessMask = dst_access;
+
+            recording_acquires.image_barriers.push_back(acquire);
+            recording_acquires.dst_stages |= dst_stage;
+        }
+    }
+
+    void UploadContext::RecordOnReceiver(std::function<void(VkCommandBuffer)> record) {
+        if (!is_recording) {
+            BeginBatch();
+        }
+
+        if (transfers_ownership) {
+            recording_acquires.commands.push_back(std::move(record));
+        } else {
+            record(recording.command_buffer);
+        }
+    }
+
+    bool UploadContext::TakeHandoff(UploadHandoff* out_handoff) {
+        if (handoff.semaphores.empty()) {
+            return false;
+        }
+
+        *out_handoff = std::move(handoff);
+        handoff = {};
+        handoff.dst_stages = 0;
+
+        return true;
+    }
+
+    void UploadContext::RecycleSemaphores(const std::vector<VkSemaphore>& semaphores) {
+        free_semaphores.insert(free_semaphores.end(), semaphores.begin(), semaphores.end());
+    }
+
+    UploadToken UploadContext::Submit() {
+        if (!is_recording) {
+            // nothing new was recorded, so the newest token is what
+            //   callers would be waiting on anyways
+            return next_token - 1;
+        }
+
+        // make every transfer write visible to whatever comes after us
+        //   in submission order, so frames don't need their own barrier
+        VkMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+        };
+
+        vkCmdPipelineBarrier(
+            recording.command_buffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+
+        if (vkEndCommandBuffer(recording.command_buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to end upload command buffer!");
+        }
+
+        // the receiving queue can't see our fence, so every cross queue
+        //   batch signals a semaphore for it to wait on before acquiring
+        VkSemaphore signal_semaphore = VK_NULL_HANDLE;
+        if (transfers_ownership) {
+            if (!free_semaphores.empty()) {
+                signal_semaphore = free_semaphores.back();
+                free_semaphores.pop_back();
+            } else {
+                VkSemaphoreCreateInfo semaphore_info = {
+                    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+                };
+
+                if (vkCreateSemaphore(device, &semaphore_info, nullptr, &signal_semaphore) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create upload handoff semaphore!");
+                }
+            }
+        }
+
+        VkSubmitInfo submit_info = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &recording.command_buffer,
+            .signalSemaphoreCount = transfers_ownership ? 1u : 0u,
+            .pSignalSemaphores = &signal_semaphore
+        };
+
+        if (vkQueueSubmit(queue, 1, &submit_info, recording.fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit upload command buffer!");
+        }
+
+        if (transfers_ownership) {
+            handoff.semaphores.push_back(signal_semaphore);
+            handoff.buffer_barriers.insert(
+                handoff.buffer_barriers.end(),
+                recording_acquires.buffer_barriers.begin(),
+                recording_acquires.buffer_barriers.end()
+            );
+            handoff.image_barriers.insert(
+                handoff.image_barriers.end(),
+                recording_acquires.image_barriers.begin(),
+                recording_acquires.image_barriers.end()
+            );
+            handoff.commands.insert(
+                handoff.commands.end(),
+                std::make_move_iterator(recording_acquires.commands.begin()),
+                std::make_move_iterator(recording_acquires.commands.end())
+            );
+            // waits need a stage even when nothing was released
+            handoff.dst_stages |= recording_acquires.dst_stages != 0 ? recording_acquires.dst_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+            recording_acquires.buffer_barriers.clear();
+            recording_acquires.image_barriers.clear();
+            recording_acquires.commands.clear();
+            recording_acquires.dst_stages = 0;
+        }
+
+        UploadToken token = recording.token;
+        in_flight.push_back(std::move(recording));
+        is_recording = false;
+
+        return token;
+    }
+
+    void UploadContext::Wait(UploadToken token) {
+        if (is_recording && token >= recording.token) {
+            Submit();
+        }
+
+        while (!in_flight.empty() && in_flight.front().token <= token) {
+            vkWaitForFences(device, 1, &in_flight.front().fence, VK_TRUE, UINT64_MAX);
+            RetireFront();
+        }
+    }
+
+    bool UploadContext::IsComplete(UploadToken token) {
+        // retire everything that has finished so far, in order
+        while (!in_flight.empty() && vkGetFenceStatus(device, in_flight.front().fence) == VK_SUCCESS) {
+            RetireFront();
+        }
+
+        return token <= completed_token;
+    }
+
+    void UploadContext::Flush() {
+        Wait(next_token);
+    }
+
+    uint32_t UploadContext::get_queue_family_index() const { return queue_family_index; }
+    uint32_t UploadContext::get_dst_queue_family_index() const { return dst_queue_family_index; }
+    bool UploadContext::get_transfers_ownership() const { return transfers_ownership; }
+    VkQueue UploadContext::get_queue() const { return queue; }
+}
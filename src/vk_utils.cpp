@@ -4,6 +4,7 @@
 #include <set>
 #include <limits>
 #include <algorithm>
+#include <numeric>
 
 namespace rt::Utils {
     VkFormat find_supported_format(
@@ -39,6 +40,10 @@ namespace rt::Utils {
         VkPhysicalDeviceMemoryProperties mem_properties;
         vkGetPhysicalDeviceMemoryProperties(physical_device, &mem_properties);
 
+        return find_memory_type(type_filter, properties, mem_properties);
+    }
+
+    uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties, const VkPhysicalDeviceMemoryProperties& mem_properties) {
         for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
             if (type_filter & (1 << i) && (mem_properties.memoryTypes[i].propertyFlags & properties) == properties) {
                 return i;
@@ -98,10 +103,24 @@ namespace rt::Utils {
         VkImageLayout prev_layout,
         VkImageLayout new_layout,
         const GraphicsContext& g_ctx,
-        const ApiContext& a_ctx
+        const ApiContext& a_ctx,
+        uint32_t base_mip_level,
+        uint32_t level_count
     ) {
         VkCommandBuffer command_buffer = begin_single_use_commands(g_ctx, a_ctx);
+        cmd_transition_image_layout(command_buffer, image, format, prev_layout, new_layout, base_mip_level, level_count);
+        end_single_use_commands(command_buffer, g_ctx, a_ctx);
+    }
 
+    void cmd_transition_image_layout(
+        VkCommandBuffer command_buffer,
+        VkImage image,
+        VkFormat format,
+        VkImageLayout prev_layout,
+        VkImageLayout new_layout,
+        uint32_t base_mip_level,
+        uint32_t level_count
+    ) {
         // use a barrier to transition layouts :D
         //   (these are typically used for synchronization stuff
         //   but they can also be used to change image layouts <3)
@@ -123,8 +142,8 @@ namespace rt::Utils {
             .subresourceRange = {
                 // we'll specify aspect mask in a second...
                 .aspectMask = 0,
-                .baseMipLevel = 0,
-                .levelCount = 1,
+                .baseMipLevel = base_mip_level,
+                .levelCount = level_count,
                 .baseArrayLayer = 0,
                 .layerCount = 1
             },
@@ -147,6 +166,24 @@ namespace rt::Utils {
                 src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
                 break;
 
+            // blit sources, reads only need the stage to be waited on
+            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                barrier.srcAccessMask = 0;
+                src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                break;
+
+            // storage images written by compute shaders
+            case VK_IMAGE_LAYOUT_GENERAL:
+                barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                src_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                break;
+
+            // only reads happened, so there is nothing to make visible
+            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+                barrier.srcAccessMask = 0;
+                src_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                break;
+
             default:
                 success = false;
                 break;
@@ -159,12 +196,24 @@ namespace rt::Utils {
                 barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
                 break;
 
+            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                break;
+
             case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
                 barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
                 dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
                 barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
                 break;
 
+            case VK_IMAGE_LAYOUT_GENERAL:
+                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+                dst_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                break;
+
             case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
                 barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
                 dst_stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
@@ -197,13 +246,86 @@ namespace rt::Utils {
             0, nullptr, // buffer memory barriers
             1, &barrier // IMAGE memory barriers :]
         );
+    }
 
-        end_single_use_commands(command_buffer, g_ctx, a_ctx);
+    void cmd_generate_mipmaps(VkCommandBuffer command_buffer, VkImage image, uint32_t width, uint32_t height, uint32_t mip_levels) {
+        int32_t level_width = static_cast<int32_t>(width);
+        int32_t level_height = static_cast<int32_t>(height);
+
+        for (uint32_t level = 1; level < mip_levels; level++) {
+            // the level above was just written (copied or blitted into)
+            cmd_transition_image_layout(
+                command_buffer,
+                image,
+                VK_FORMAT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                level - 1,
+                1
+            );
+
+            int32_t next_width = std::max(level_width / 2, 1);
+            int32_t next_height = std::max(level_height / 2, 1);
+
+            VkImageBlit blit = {
+                .srcSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level - 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                },
+                .srcOffsets = {{0, 0, 0}, {level_width, level_height, 1}},
+                .dstSubresource = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1
+                },
+                .dstOffsets = {{0, 0, 0}, {next_width, next_height, 1}}
+            };
+
+            vkCmdBlitImage(
+                command_buffer,
+                image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &blit,
+                VK_FILTER_LINEAR
+            );
+
+            // done being read from, so it can go straight to shaders
+            cmd_transition_image_layout(
+                command_buffer,
+                image,
+                VK_FORMAT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                level - 1,
+                1
+            );
+
+            level_width = next_width;
+            level_height = next_height;
+        }
+
+        // the last level is never blitted from
+        cmd_transition_image_layout(
+            command_buffer,
+            image,
+            VK_FORMAT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            mip_levels - 1,
+            1
+        );
     }
 
     void copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, const GraphicsContext& g_ctx, const ApiContext& a_ctx) {
         VkCommandBuffer command_buffer = begin_single_use_commands(g_ctx, a_ctx);
+        cmd_copy_buffer_to_image(command_buffer, buffer, image, width, height);
+        end_single_use_commands(command_buffer, g_ctx, a_ctx);
+    }
 
+    void cmd_copy_buffer_to_image(VkCommandBuffer command_buffer, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
         VkBufferImageCopy region = {
             .bufferOffset = 0,
             .bufferRowLength = 0,
@@ -226,8 +348,321 @@ namespace rt::Utils {
             1,
             &region
         );
+    }
 
-        end_single_use_commands(command_buffer, g_ctx, a_ctx);
+    void cmd_copy_image_to_buffer(VkCommandBuffer command_buffer, VkImage image, VkImageLayout layout, VkBuffer buffer, uint32_t width, uint32_t height) {
+        VkBufferImageCopy region = {
+            .bufferOffset = 0,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1
+            },
+            .imageOffset = {0, 0},
+            .imageExtent = {width, height, 1}
+        };
+
+        vkCmdCopyImageToBuffer(
+            command_buffer,
+            image,
+            layout,
+            buffer,
+            1,
+            &region
+        );
+    }
+
+    void cmd_memory_barrier(VkCommandBuffer command_buffer, VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access) {
+        VkMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = src_access,
+            .dstAccessMask = dst_access
+        };
+
+        vkCmdPipelineBarrier(
+            command_buffer,
+            src_stage,
+            dst_stage,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr
+        );
+    }
+
+    void cmd_buffer_barrier(VkCommandBuffer command_buffer, VkBuffer buffer, VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access) {
+        VkBufferMemoryBarrier barrier = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = src_access,
+            .dstAccessMask = dst_access,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        };
+
+        vkCmdPipelineBarrier(
+            command_buffer,
+            src_stage,
+            dst_stage,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr
+        );
+    }
+
+    void write_storage_buffer_descriptor(VkDevice device, VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+        VkDescriptorBufferInfo buffer_info = {
+            .buffer = buffer,
+            .offset = offset,
+            .range = range
+        };
+
+        VkWriteDescriptorSet write = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = set,
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &buffer_info
+        };
+
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+
+    void write_storage_image_descriptor(VkDevice device, VkDescriptorSet set, uint32_t binding, VkImageView view, VkImageLayout layout) {
+        VkDescriptorImageInfo image_info = {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = view,
+            .imageLayout = layout
+        };
+
+        VkWriteDescriptorSet write = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = set,
+            .dstBinding = binding,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .pImageInfo = &image_info
+        };
+
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+
+    uint32_t get_format_texel_size(VkFormat format) {
+        // depth/stencil sizes are what the formats pack down to, not the
+        //   per-aspect layout a buffer copy of one aspect uses
+        switch (format) {
+            case VK_FORMAT_R4G4_UNORM_PACK8:
+            case VK_FORMAT_R8_UNORM:
+            case VK_FORMAT_R8_SNORM:
+            case VK_FORMAT_R8_USCALED:
+            case VK_FORMAT_R8_SSCALED:
+            case VK_FORMAT_R8_UINT:
+            case VK_FORMAT_R8_SINT:
+            case VK_FORMAT_R8_SRGB:
+            case VK_FORMAT_S8_UINT:
+                return 1;
+            case VK_FORMAT_R4G4B4A4_UNORM_PACK16:
+            case VK_FORMAT_B4G4R4A4_UNORM_PACK16:
+            case VK_FORMAT_R5G6B5_UNORM_PACK16:
+            case VK_FORMAT_B5G6R5_UNORM_PACK16:
+            case VK_FORMAT_R5G5B5A1_UNORM_PACK16:
+            case VK_FORMAT_B5G5R5A1_UNORM_PACK16:
+            case VK_FORMAT_A1R5G5B5_UNORM_PACK16:
+            case VK_FORMAT_R8G8_UNORM:
+            case VK_FORMAT_R8G8_SNORM:
+            case VK_FORMAT_R8G8_USCALED:
+            case VK_FORMAT_R8G8_SSCALED:
+            case VK_FORMAT_R8G8_UINT:
+            case VK_FORMAT_R8G8_SINT:
+            case VK_FORMAT_R8G8_SRGB:
+            case VK_FORMAT_R16_UNORM:
+            case VK_FORMAT_R16_SNORM:
+            case VK_FORMAT_R16_USCALED:
+            case VK_FORMAT_R16_SSCALED:
+            case VK_FORMAT_R16_UINT:
+            case VK_FORMAT_R16_SINT:
+            case VK_FORMAT_R16_SFLOAT:
+            case VK_FORMAT_D16_UNORM:
+                return 2;
+            case VK_FORMAT_R8G8B8_UNORM:
+            case VK_FORMAT_R8G8B8_SNORM:
+            case VK_FORMAT_R8G8B8_USCALED:
+            case VK_FORMAT_R8G8B8_SSCALED:
+            case VK_FORMAT_R8G8B8_UINT:
+            case VK_FORMAT_R8G8B8_SINT:
+            case VK_FORMAT_R8G8B8_SRGB:
+            case VK_FORMAT_B8G8R8_UNORM:
+            case VK_FORMAT_B8G8R8_SNORM:
+            case VK_FORMAT_B8G8R8_USCALED:
+            case VK_FORMAT_B8G8R8_SSCALED:
+            case VK_FORMAT_B8G8R8_UINT:
+            case VK_FORMAT_B8G8R8_SINT:
+            case VK_FORMAT_B8G8R8_SRGB:
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+                return 3;
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SNORM:
+            case VK_FORMAT_R8G8B8A8_USCALED:
+            case VK_FORMAT_R8G8B8A8_SSCALED:
+            case VK_FORMAT_R8G8B8A8_UINT:
+            case VK_FORMAT_R8G8B8A8_SINT:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SNORM:
+            case VK_FORMAT_B8G8R8A8_USCALED:
+            case VK_FORMAT_B8G8R8A8_SSCALED:
+            case VK_FORMAT_B8G8R8A8_UINT:
+            case VK_FORMAT_B8G8R8A8_SINT:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+            case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+            case VK_FORMAT_A8B8G8R8_SNORM_PACK32:
+            case VK_FORMAT_A8B8G8R8_USCALED_PACK32:
+            case VK_FORMAT_A8B8G8R8_SSCALED_PACK32:
+            case VK_FORMAT_A8B8G8R8_UINT_PACK32:
+            case VK_FORMAT_A8B8G8R8_SINT_PACK32:
+            case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+            case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+            case VK_FORMAT_A2R10G10B10_SNORM_PACK32:
+            case VK_FORMAT_A2R10G10B10_USCALED_PACK32:
+            case VK_FORMAT_A2R10G10B10_SSCALED_PACK32:
+            case VK_FORMAT_A2R10G10B10_UINT_PACK32:
+            case VK_FORMAT_A2R10G10B10_SINT_PACK32:
+            case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+            case VK_FORMAT_A2B10G10R10_SNORM_PACK32:
+            case VK_FORMAT_A2B10G10R10_USCALED_PACK32:
+            case VK_FORMAT_A2B10G10R10_SSCALED_PACK32:
+            case VK_FORMAT_A2B10G10R10_UINT_PACK32:
+            case VK_FORMAT_A2B10G10R10_SINT_PACK32:
+            case VK_FORMAT_R16G16_UNORM:
+            case VK_FORMAT_R16G16_SNORM:
+            case VK_FORMAT_R16G16_USCALED:
+            case VK_FORMAT_R16G16_SSCALED:
+            case VK_FORMAT_R16G16_UINT:
+            case VK_FORMAT_R16G16_SINT:
+            case VK_FORMAT_R16G16_SFLOAT:
+            case VK_FORMAT_R32_UINT:
+            case VK_FORMAT_R32_SINT:
+            case VK_FORMAT_R32_SFLOAT:
+            case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+            case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+                return 4;
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return 5;
+            case VK_FORMAT_R16G16B16_UNORM:
+            case VK_FORMAT_R16G16B16_SNORM:
+            case VK_FORMAT_R16G16B16_USCALED:
+            case VK_FORMAT_R16G16B16_SSCALED:
+            case VK_FORMAT_R16G16B16_UINT:
+            case VK_FORMAT_R16G16B16_SINT:
+            case VK_FORMAT_R16G16B16_SFLOAT:
+                return 6;
+            case VK_FORMAT_R16G16B16A16_UNORM:
+            case VK_FORMAT_R16G16B16A16_SNORM:
+            case VK_FORMAT_R16G16B16A16_USCALED:
+            case VK_FORMAT_R16G16B16A16_SSCALED:
+            case VK_FORMAT_R16G16B16A16_UINT:
+            case VK_FORMAT_R16G16B16A16_SINT:
+            case VK_FORMAT_R16G16B16A16_SFLOAT:
+            case VK_FORMAT_R32G32_UINT:
+            case VK_FORMAT_R32G32_SINT:
+            case VK_FORMAT_R32G32_SFLOAT:
+            case VK_FORMAT_R64_UINT:
+            case VK_FORMAT_R64_SINT:
+            case VK_FORMAT_R64_SFLOAT:
+                return 8;
+            case VK_FORMAT_R32G32B32_UINT:
+            case VK_FORMAT_R32G32B32_SINT:
+            case VK_FORMAT_R32G32B32_SFLOAT:
+                return 12;
+            case VK_FORMAT_R32G32B32A32_UINT:
+            case VK_FORMAT_R32G32B32A32_SINT:
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+            case VK_FORMAT_R64G64_UINT:
+            case VK_FORMAT_R64G64_SINT:
+            case VK_FORMAT_R64G64_SFLOAT:
+                return 16;
+            default:
+                throw std::runtime_error("Unknown texel size for image format!");
+        }
+    }
+
+    uint32_t get_full_mip_count(uint32_t width, uint32_t height) {
+        uint32_t levels = 1;
+        uint32_t largest = std::max(width, height);
+        while (largest > 1) {
+            largest /= 2;
+            levels++;
+        }
+
+        return levels;
+    }
+
+    uint32_t get_format_block_size(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+            case VK_FORMAT_BC4_SNORM_BLOCK:
+                return 8;
+            case VK_FORMAT_BC2_UNORM_BLOCK:
+            case VK_FORMAT_BC2_SRGB_BLOCK:
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC5_SNORM_BLOCK:
+            case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+            case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return 16;
+            default:
+                return 0;
+        }
+    }
+
+    VkDeviceSize get_image_level_size(VkFormat format, uint32_t width, uint32_t height) {
+        uint32_t block_size = get_format_block_size(format);
+        if (block_size > 0) {
+            // partial blocks at the edges still take up a whole block
+            return static_cast<VkDeviceSize>((width + 3) / 4) * ((height + 3) / 4) * block_size;
+        }
+
+        return static_cast<VkDeviceSize>(width) * height * get_format_texel_size(format);
+    }
+
+    VkDeviceSize get_copy_offset_alignment(VkFormat format) {
+        uint32_t element_size = get_format_block_size(format);
+        if (element_size == 0) {
+            element_size = get_format_texel_size(format);
+        }
+
+        // buffer to image offsets have to be a multiple of both
+        return std::lcm(static_cast<VkDeviceSize>(element_size), VkDeviceSize{4});
+    }
+
+    uint64_t hash_bytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = 0xcbf29ce484222325;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3;
+        }
+
+        return hash;
     }
 
     SwapChainSupportDetails query_swap_chain_support(VkPhysicalDevice device, VkSurfaceKHR surface) {
@@ -274,7 +709,9 @@ namespace rt::Utils {
 
             // check for present support at this queue index, save index if so
             VkBool32 present_support = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+            if (surface != VK_NULL_HANDLE) {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+            }
             if (present_support) {
                 indices.present = i;
             }
@@ -284,6 +721,35 @@ namespace rt::Utils {
             }
         }
 
+        // dedicated queues are ones without graphics, transfer prefers
+        //   a pure copy engine (no compute either) when there is one
+        bool pure_transfer = false;
+        for (uint32_t i = 0; i < queue_family_count; i++) {
+            VkQueueFlags flags = queue_families[i].queueFlags;
+            if ((flags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+                continue;
+            }
+
+            bool has_compute = (flags & VK_QUEUE_COMPUTE_BIT) != 0;
+            // compute queues implicitly support transfers too
+            bool has_transfer = (flags & VK_QUEUE_TRANSFER_BIT) != 0 || has_compute;
+
+            if (has_compute && !indices.compute.has_value()) {
+                indices.compute = i;
+            }
+
+            if (has_transfer && (!indices.transfer.has_value() || (!has_compute && !pure_transfer))) {
+                indices.transfer = i;
+                pure_transfer = !has_compute;
+            }
+        }
+
+        // without a surface nothing is presented, so present just
+        //   mirrors graphics to keep callers from special casing it
+        if (surface == VK_NULL_HANDLE) {
+            indices.present = indices.graphics;
+        }
+
         return indices;
     }
 
@@ -311,8 +777,9 @@ namespace rt::Utils {
 
         bool extensions_supported = check_device_extension_support(device, extensions, extension_count);
 
-        bool swap_chain_adequate = false;
-        if (extensions_supported) {
+        // headless devices never make a swap chain
+        bool swap_chain_adequate = surface == VK_NULL_HANDLE;
+        if (extensions_supported && surface != VK_NULL_HANDLE) {
             rt::SwapChainSupportDetails details = rt::Utils::query_swap_chain_support(device, surface);
             swap_chain_adequate = !details.formats.empty() && !details.present_modes.empty();
         }
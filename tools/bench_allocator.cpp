@@ -0,0 +1,111 @@
+// times creating and destroying lots of small buffers with and without
+//   a MemoryAllocator, then prints the allocator's per heap stats
+//   usage: bench_allocator [buffer_count=100000] [buffer_size=256]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "base/base.h"
+#include "etc/destruction_queue.h"
+#include "bench_common.h"
+
+struct Timings {
+    uint32_t count;
+    double create_ms;
+    double destroy_ms;
+};
+
+// out_stats is optional, filled while every buffer is still alive
+static Timings run(
+    uint32_t count,
+    VkDeviceSize size,
+    rt::MemoryAllocator* allocator,
+    const rt::ApiContext& a_ctx,
+    std::vector<rt::MemoryHeapStats>* out_stats = nullptr
+) {
+    // retiring skips the vkDeviceWaitIdle every buffer would otherwise
+    //   do on destruction, nothing is ever submitted so flushing is safe
+    rt::DestructionQueue retire_queue;
+
+    rt::BufferCreateInfo buffer_info = {
+        .size = size,
+        .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        .allocator = allocator,
+        .retire_queue = &retire_queue
+    };
+
+    std::vector<std::unique_ptr<rt::Buffer>> buffers;
+    buffers.reserve(count);
+
+    auto start = bench::Clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        buffers.push_back(std::make_unique<rt::Buffer>(buffer_info, a_ctx));
+    }
+    double create_ms = bench::ms_since(start);
+
+    if (allocator != nullptr && out_stats != nullptr) {
+        *out_stats = allocator->get_heap_stats();
+    }
+
+    start = bench::Clock::now();
+    buffers.clear();
+    retire_queue.Flush();
+    double destroy_ms = bench::ms_since(start);
+
+    return {.count = count, .create_ms = create_ms, .destroy_ms = destroy_ms};
+}
+
+static void print(const char* name, const Timings& timings) {
+    std::cout << name << ": " << timings.count << " buffers, create " << timings.create_ms << " ms ("
+              << timings.create_ms * 1000.0 / timings.count << " us each), destroy " << timings.destroy_ms << " ms\n";
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 100000;
+    VkDeviceSize size = argc > 2 ? std::stoull(argv[2]) : 256;
+
+    try {
+        auto cluster = bench::create_headless_cluster();
+        bench::print_device(*cluster);
+        rt::ApiContext a_ctx = cluster->get_api_context();
+
+        // ~~~ sub-allocated ~~~
+
+        rt::MemoryAllocatorCreateInfo allocator_info = {.block_size = 0, .min_allocation_size = 0};
+        rt::MemoryAllocator allocator(allocator_info, a_ctx);
+
+        std::vector<rt::MemoryHeapStats> stats;
+        Timings pooled = run(count, size, &allocator, a_ctx, &stats);
+
+        // ~~~ one vkAllocateMemory each ~~~
+
+        // drivers cap live allocations (often at 4096), so the dedicated
+        //   run is clamped under that and compared per buffer
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(a_ctx.physical_device, &properties);
+        uint32_t dedicated_count = std::min(count, properties.limits.maxMemoryAllocationCount - 64);
+        Timings dedicated = run(dedicated_count, size, nullptr, a_ctx);
+
+        print("allocator", pooled);
+        print("dedicated", dedicated);
+
+        for (size_t heap = 0; heap < stats.size(); heap++) {
+            if (stats[heap].allocation_count == 0) {
+                continue;
+            }
+
+            std::cout << "heap " << heap << ": " << stats[heap].block_count << " blocks, "
+                      << stats[heap].allocation_count << " allocations, "
+                      << stats[heap].allocated_bytes << " bytes allocated, "
+                      << stats[heap].used_bytes << " bytes used\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
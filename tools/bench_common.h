@@ -0,0 +1,197 @@
+// shared bits of the bench_* tools, a headless device, a timer and
+//   the loop the load benches time with.
+//   benches run on whatever device comes first (lavapipe works fine
+//   with VK_ICD_FILENAMES pointing at it)
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "base/base.h"
+#include "etc/api_cluster.h"
+#include "etc/destruction_queue.h"
+#include "etc/upload_context.h"
+
+namespace bench {
+    using Clock = std::chrono::steady_clock;
+
+    inline double ms_since(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // pipeline_cache_path is optional, see ApiClusterCreateInfo
+    inline std::shared_ptr<rt::ApiCluster> create_headless_cluster(const char* pipeline_cache_path = nullptr) {
+        static const rt::InstanceCreateInfo instance_info = {
+            .app_name = "render_thing bench",
+            .app_version = VK_MAKE_VERSION(1, 0, 0),
+            .api_version = VK_API_VERSION_1_2,
+            .validation_layers = nullptr,
+            .validation_layer_count = 0,
+            .headless = true
+        };
+
+        rt::ApiClusterCreateInfo cluster_info = {
+            .instance = instance_info,
+            .window = nullptr,
+            .pipeline_cache_path = pipeline_cache_path
+        };
+
+        return std::make_shared<rt::ApiCluster>(cluster_info);
+    }
+
+    inline void print_device(const rt::ApiCluster& cluster) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(cluster.get_physical_device(), &properties);
+        std::cout << "device: " << properties.deviceName << "\n";
+    }
+
+    // one file load, timed up to its upload finishing
+    struct LoadTimings {
+        double read_ms;
+        double upload_ms;
+    };
+
+    // what a load uploads with, it has to flush before returning
+    struct LoadContext {
+        rt::UploadContext& upload_context;
+        rt::DestructionQueue& retire_queue;
+        const rt::ApiContext& a_ctx;
+    };
+
+    struct Load {
+        const char* name;
+        const char* path;
+        std::function<LoadTimings(const char* path, const LoadContext& ctx)> function;
+        // summed over the timed iterations by run_loads
+        LoadTimings total;
+    };
+
+    // uploads go through one context on the cluster's graphics queue,
+    //   each iteration runs every load once in turn
+    inline void run_loads(const rt::ApiCluster& cluster, std::vector<Load>& loads, uint32_t iterations) {
+        rt::ApiContext a_ctx = cluster.get_api_context();
+
+        VkQueue graphics_queue;
+        VkQueue present_queue;
+        cluster.get_queues(&graphics_queue, &present_queue);
+
+        rt::UploadContextCreateInfo upload_info = {
+            .queue = graphics_queue,
+            .queue_family_index = cluster.get_queue_families().graphics.value()
+        };
+        rt::UploadContext upload_context(upload_info, a_ctx);
+
+        // everything is idle after each upload's flush, so retiring
+        //   is just a way around the wait idle on every destroy
+        rt::DestructionQueue retire_queue;
+        LoadContext ctx = {upload_context, retire_queue, a_ctx};
+
+        // warm the page cache and the driver
+        for (auto& load : loads) {
+            load.function(load.path, ctx);
+        }
+        retire_queue.Flush();
+
+        for (auto& load : loads) {
+            load.total = {0.0, 0.0};
+        }
+        for (uint32_t i = 0; i < iterations; i++) {
+            for (auto& load : loads) {
+                LoadTimings timings = load.function(load.path, ctx);
+                load.total.read_ms += timings.read_ms;
+                load.total.upload_ms += timings.upload_ms;
+            }
+            retire_queue.Flush();
+        }
+    }
+
+    inline double get_total_ms(const Load& load) {
+        return load.total.read_ms + load.total.upload_ms;
+    }
+
+    // averages over the iterations run_loads was given
+    inline void print_load(const Load& load, uint32_t iterations) {
+        double read_ms = load.total.read_ms / iterations;
+        double upload_ms = load.total.upload_ms / iterations;
+        std::cout << load.name << ": " << std::filesystem::file_size(load.path) << " bytes on disk, read "
+                  << read_ms << " ms, upload " << upload_ms << " ms, total " << read_ms + upload_ms << " ms\n";
+    }
+
+    // fixed function state for shaders that take no vertex input (they
+    //   make their positions from gl_VertexIndex), viewport and scissor
+    //   are dynamic. fields can be changed before get_create_info
+    struct PipelineStates {
+        VkPipelineVertexInputStateCreateInfo vertex_input = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO
+        };
+        VkPipelineInputAssemblyStateCreateInfo input_assembly = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST
+        };
+        VkPipelineViewportStateCreateInfo viewport = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+            .viewportCount = 1,
+            .scissorCount = 1
+        };
+        VkPipelineRasterizationStateCreateInfo rasterizer = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .polygonMode = VK_POLYGON_MODE_FILL,
+            .cullMode = VK_CULL_MODE_BACK_BIT,
+            .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+            .lineWidth = 1.0f
+        };
+        VkPipelineMultisampleStateCreateInfo multisample = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
+        };
+        VkPipelineDepthStencilStateCreateInfo depth_stencil = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+            .depthTestEnable = VK_TRUE,
+            .depthWriteEnable = VK_TRUE,
+            .depthCompareOp = VK_COMPARE_OP_LESS
+        };
+        VkPipelineColorBlendAttachmentState blend_attachment = {
+            .blendEnable = VK_FALSE,
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                              VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+        };
+        VkPipelineColorBlendStateCreateInfo color_blend = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .attachmentCount = 1
+        };
+        std::array<VkDynamicState, 2> dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        VkPipelineDynamicStateCreateInfo dynamic_state = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+            .dynamicStateCount = 2
+        };
+
+        // points into this, so it must outlive the result
+        rt::GraphicsPipelineCreateInfo get_create_info(
+            VkPipelineShaderStageCreateInfo* stages,
+            uint32_t stage_count,
+            const VkPipelineLayoutCreateInfo* layout_create_info
+        ) {
+            color_blend.pAttachments = &blend_attachment;
+            dynamic_state.pDynamicStates = dynamic_states.data();
+
+            return {
+                .shader_stages = stages,
+                .shader_stage_count = stage_count,
+                .vertex_input = &vertex_input,
+                .input_assembly = &input_assembly,
+                .viewport = &viewport,
+                .rasterizer = &rasterizer,
+                .multisample = &multisample,
+                .depth_stencil = &depth_stencil,
+                .color_blend = &color_blend,
+                .dynamic_state = &dynamic_state,
+                .layout_create_info = layout_create_info
+            };
+        }
+    };
+}
@@ -0,0 +1,85 @@
+// times loading the same mesh from an OBJ file (parsed and deduplicated
+//   like mesh_convert does) against its converted mesh file, each up to
+//   the upload into device buffers finishing
+//   usage: bench_mesh_load <input.obj> <input.rtm> [iterations=10]
+//   both files are read once before timing so they're in the page cache,
+//   drop caches between runs to compare cold reads
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "etc/etc.h"
+#include "obj_reader.h"
+#include "bench_common.h"
+
+// uploads through an upload context and waits for it, the mesh is
+//   destroyed after timing
+static double upload(const rt::MeshCreateInfo& source, const bench::LoadContext& ctx) {
+    rt::MeshCreateInfo create_info = source;
+    create_info.upload_context = &ctx.upload_context;
+    create_info.retire_queue = &ctx.retire_queue;
+
+    auto start = bench::Clock::now();
+    rt::Mesh mesh(create_info, {}, ctx.a_ctx);
+    ctx.upload_context.Flush();
+
+    return bench::ms_since(start);
+}
+
+static bench::LoadTimings load_obj(const char* path, const bench::LoadContext& ctx) {
+    auto start = bench::Clock::now();
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    read_obj(path, vertices, indices);
+    double read_ms = bench::ms_since(start);
+
+    rt::MeshCreateInfo create_info = {
+        .vertices = vertices.data(),
+        .vertex_size = sizeof(Vertex),
+        .num_vertices = static_cast<uint32_t>(vertices.size()),
+        .indices = indices.data(),
+        .index_size = 4,
+        .num_indices = static_cast<uint32_t>(indices.size())
+    };
+
+    return {.read_ms = read_ms, .upload_ms = upload(create_info, ctx)};
+}
+
+static bench::LoadTimings load_mesh_file(const char* path, const bench::LoadContext& ctx) {
+    auto start = bench::Clock::now();
+    rt::MeshFile file(path);
+    double read_ms = bench::ms_since(start);
+
+    // the mapping is first touched while copying into staging memory,
+    //   so page faults land in the upload time
+    return {.read_ms = read_ms, .upload_ms = upload(file.get_mesh_create_info(), ctx)};
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <input.obj> <input.rtm> [iterations=10]\n";
+        return 1;
+    }
+
+    uint32_t iterations = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 10;
+
+    try {
+        auto cluster = bench::create_headless_cluster();
+        bench::print_device(*cluster);
+
+        std::vector<bench::Load> loads = {
+            {.name = "obj", .path = argv[1], .function = load_obj},
+            {.name = "mesh file", .path = argv[2], .function = load_mesh_file}
+        };
+        bench::run_loads(*cluster, loads, iterations);
+
+        bench::print_load(loads[0], iterations);
+        bench::print_load(loads[1], iterations);
+        std::cout << bench::get_total_ms(loads[0]) / bench::get_total_ms(loads[1]) << "x faster\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
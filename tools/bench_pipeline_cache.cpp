@@ -0,0 +1,126 @@
+// times creating a few hundred pipeline variants with a cold pipeline
+//   cache, then again in a fresh device that loads the cache saved by
+//   the first run. the shaders must take no vertex input
+//   usage: bench_pipeline_cache <vert.spv> <frag.spv> <cache_path> [pipeline_count=300]
+//   drivers may keep their own shader cache too, on mesa run with
+//   MESA_SHADER_CACHE_DISABLE=true so the cold run is really cold
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+#include "etc/etc.h"
+#include "bench_common.h"
+
+static std::unique_ptr<rt::RenderPass> create_render_pass(const rt::ApiContext& a_ctx) {
+    VkAttachmentDescription color_attachment = {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+    };
+
+    VkAttachmentReference color_attachment_ref = {
+        .attachment = 0,
+        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    };
+
+    VkSubpassDescription subpass = {
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &color_attachment_ref
+    };
+
+    rt::RenderPassCreateInfo render_pass_info = {
+        .attachments = &color_attachment,
+        .attachment_count = 1,
+        .subpasses = &subpass,
+        .subpass_count = 1,
+        .dependencies = nullptr,
+        .dependency_count = 0
+    };
+
+    return std::make_unique<rt::RenderPass>(render_pass_info, a_ctx);
+}
+
+// builds pipeline_count variants of the same shaders, every index gets
+//   a different mix of cull mode, winding, topology, blending and write mask
+static double create_pipelines(const char* vert_path, const char* frag_path, const char* cache_path, uint32_t pipeline_count) {
+    auto cluster = bench::create_headless_cluster(cache_path);
+    rt::ApiContext a_ctx = cluster->get_api_context();
+
+    rt::ShaderLibrary library({.runtime_array_size = 0}, a_ctx);
+    const rt::ShaderModule* shaders[] = {&library.Load(vert_path), &library.Load(frag_path)};
+    VkPipelineShaderStageCreateInfo stages[] = {shaders[0]->get_stage_create_info(), shaders[1]->get_stage_create_info()};
+    rt::ShaderLayout layout = library.CreateLayout(shaders, 2);
+    VkPipelineLayoutCreateInfo layout_create_info = layout.get_layout_create_info();
+
+    std::unique_ptr<rt::RenderPass> render_pass = create_render_pass(a_ctx);
+    std::vector<std::unique_ptr<rt::GraphicsPipeline>> pipelines;
+
+    auto start = bench::Clock::now();
+    for (uint32_t i = 0; i < pipeline_count; i++) {
+        bench::PipelineStates states;
+        states.depth_stencil.depthTestEnable = VK_FALSE;
+        states.depth_stencil.depthWriteEnable = VK_FALSE;
+
+        uint32_t variant = i;
+        states.rasterizer.cullMode = static_cast<VkCullModeFlags>(variant % 4);
+        variant /= 4;
+        states.rasterizer.frontFace = static_cast<VkFrontFace>(variant % 2);
+        variant /= 2;
+        states.input_assembly.topology = variant % 2 == 0 ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        variant /= 2;
+        states.blend_attachment.blendEnable = variant % 2 == 0 ? VK_FALSE : VK_TRUE;
+        states.blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        states.blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        states.blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        states.blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        variant /= 2;
+        states.blend_attachment.colorWriteMask = static_cast<VkColorComponentFlags>(variant % 15 + 1);
+
+        rt::GraphicsPipelineCreateInfo pipeline_info = states.get_create_info(stages, 2, &layout_create_info);
+        pipeline_info.render_pass = render_pass->get_render_pass();
+        pipeline_info.pipeline_cache = cluster->get_pipeline_cache();
+
+        pipelines.push_back(std::make_unique<rt::GraphicsPipeline>(pipeline_info, a_ctx));
+    }
+
+    // the cluster saves its cache on destruction
+    return bench::ms_since(start);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " <vert.spv> <frag.spv> <cache_path> [pipeline_count=300]\n";
+        return 1;
+    }
+
+    uint32_t pipeline_count = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 300;
+    if (pipeline_count > 480) {
+        std::cerr << "only 480 distinct variants are generated\n";
+        return 1;
+    }
+
+    try {
+        std::filesystem::remove(argv[3]);
+
+        double cold_ms = create_pipelines(argv[1], argv[2], argv[3], pipeline_count);
+        double warm_ms = create_pipelines(argv[1], argv[2], argv[3], pipeline_count);
+
+        std::cout << pipeline_count << " pipelines, cache file " << std::filesystem::file_size(argv[3]) << " bytes\n";
+        std::cout << "cold: " << cold_ms << " ms (" << cold_ms / pipeline_count << " ms each)\n";
+        std::cout << "warm: " << warm_ms << " ms (" << warm_ms / pipeline_count << " ms each), "
+                  << cold_ms / warm_ms << "x faster\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+// times recording a frame's draws into worker command buffers with one
+//   thread up to every hardware thread, headless so no window is needed.
+//   the shaders must take no vertex input
+//   usage: bench_recording <vert.spv> <frag.spv> [draw_count=100000] [frame_count=20]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <latch>
+#include <algorithm>
+#include "etc/etc.h"
+#include "bench_common.h"
+
+constexpr uint32_t FRAME_FLIGHT_COUNT = 2;
+
+// one thread per worker, each records its share of the draws into its
+//   own secondary command buffer. returns how long recording took, from
+//   releasing the already running workers until the last one finishes,
+//   so spawning and joining them isn't counted
+static double record_frame(rt::GraphicsManager& manager, uint32_t worker_count, uint32_t draw_count) {
+    manager.ResetFrameAndBeginCB();
+    manager.CmdStartRenderPass(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    VkExtent2D extent = manager.get_swapchain_extent();
+
+    std::latch ready(worker_count);
+    std::latch release(1);
+    std::vector<bench::Clock::time_point> finished(worker_count);
+
+    std::vector<std::thread> threads;
+    for (uint32_t worker = 0; worker < worker_count; worker++) {
+        threads.emplace_back([&manager, &ready, &release, &finished, worker, worker_count, draw_count, extent] {
+            ready.count_down();
+            release.wait();
+
+            uint32_t first = static_cast<uint32_t>(uint64_t{draw_count} * worker / worker_count);
+            uint32_t last = static_cast<uint32_t>(uint64_t{draw_count} * (worker + 1) / worker_count);
+
+            VkCommandBuffer command_buffer = manager.BeginWorkerCB(worker);
+            for (uint32_t draw = first; draw < last; draw++) {
+                // a scissor per draw stands in for per object state
+                VkRect2D scissor = {
+                    .offset = {static_cast<int32_t>(draw % extent.width), 0},
+                    .extent = {1, extent.height}
+                };
+                vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+                vkCmdDraw(command_buffer, 3, 1, 0, draw);
+            }
+            manager.EndWorkerCB(worker, command_buffer);
+            finished[worker] = bench::Clock::now();
+        });
+    }
+
+    ready.wait();
+    auto start = bench::Clock::now();
+    release.count_down();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto end = *std::max_element(finished.begin(), finished.end());
+    double record_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    manager.CmdExecuteWorkerCBs();
+    manager.CmdEndRenderPass();
+    manager.EndCBAndPresentFrame();
+
+    return record_ms;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <vert.spv> <frag.spv> [draw_count=100000] [frame_count=20]\n";
+        return 1;
+    }
+
+    uint32_t draw_count = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 100000;
+    uint32_t frame_count = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 20;
+    uint32_t max_workers = std::max(std::thread::hardware_concurrency(), 1u);
+
+    try {
+        auto cluster = bench::create_headless_cluster();
+        bench::print_device(*cluster);
+
+        rt::ShaderLibrary library({.runtime_array_size = 0}, cluster->get_api_context());
+        const rt::ShaderModule* shaders[] = {&library.Load(argv[1]), &library.Load(argv[2])};
+        VkPipelineShaderStageCreateInfo stages[] = {shaders[0]->get_stage_create_info(), shaders[1]->get_stage_create_info()};
+        rt::ShaderLayout layout = library.CreateLayout(shaders, 2);
+        VkPipelineLayoutCreateInfo layout_create_info = layout.get_layout_create_info();
+
+        bench::PipelineStates states;
+        rt::GraphicsPipelineCreateInfo pipeline_info = states.get_create_info(stages, 2, &layout_create_info);
+
+        rt::SwapChainCreateInfo swap_chain_info = {
+            .frame_flight_count = FRAME_FLIGHT_COUNT,
+            .extent = VkExtent2D{1280, 720}
+        };
+
+        rt::GraphicsManagerCreateInfo manager_info = {
+            .clear_value = {.color = {{0.0f, 0.0f, 0.0f, 1.0f}}},
+            .window = nullptr,
+            .api_cluster = cluster,
+            .swap_chain = swap_chain_info,
+            .graphics_pipeline = pipeline_info,
+            .worker_count = max_workers
+        };
+        rt::GraphicsManager manager(manager_info);
+
+        // ~~~ record with 1, 2, 4... workers ~~~
+
+        std::vector<uint32_t> worker_counts;
+        for (uint32_t workers = 1; workers < max_workers; workers *= 2) {
+            worker_counts.push_back(workers);
+        }
+        worker_counts.push_back(max_workers);
+
+        double single_ms = 0.0;
+        for (uint32_t workers : worker_counts) {
+            // a frame per frame in flight allocates command buffers, so
+            //   those aren't counted
+            for (uint32_t frame = 0; frame < FRAME_FLIGHT_COUNT; frame++) {
+                record_frame(manager, workers, draw_count);
+            }
+
+            double total_ms = 0.0;
+            for (uint32_t frame = 0; frame < frame_count; frame++) {
+                total_ms += record_frame(manager, workers, draw_count);
+            }
+
+            double frame_ms = total_ms / frame_count;
+            if (workers == 1) {
+                single_ms = frame_ms;
+            }
+
+            std::cout << workers << " workers: " << frame_ms << " ms per frame, "
+                      << draw_count / frame_ms / 1000.0 << "M draws/s, "
+                      << single_ms / frame_ms << "x\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+// times loading the same texture as an uncompressed and a BC texture
+//   file (both made by texture_convert), each up to the upload into a
+//   sampled image finishing, and compares file and device memory sizes
+//   usage: bench_texture_load <rgba.rttx> <bc.rttx> [iterations=10]
+//   both files are read once before timing so they're in the page cache,
+//   drop caches between runs to compare cold reads
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "etc/etc.h"
+#include "bench_common.h"
+
+// device_size is the image's memory requirement
+static bench::LoadTimings load(const char* path, const bench::LoadContext& ctx, VkDeviceSize* device_size) {
+    auto start = bench::Clock::now();
+    rt::TextureFile file(path);
+    double read_ms = bench::ms_since(start);
+
+    // the mapping is first touched while copying into staging memory,
+    //   so page faults land in the upload time
+    start = bench::Clock::now();
+
+    rt::ImageCreateInfo image_info = file.get_image_create_info(ctx.a_ctx.physical_device);
+    image_info.retire_queue = &ctx.retire_queue;
+    rt::Image image(image_info, ctx.a_ctx);
+
+    std::vector<rt::ImageLevelData> levels = file.get_level_data();
+    image.CopyLevels(levels.data(), static_cast<uint32_t>(levels.size()), ctx.upload_context, ctx.a_ctx);
+    ctx.upload_context.Flush();
+
+    double upload_ms = bench::ms_since(start);
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(ctx.a_ctx.device, image.get_image(), &requirements);
+    *device_size = requirements.size;
+
+    return {.read_ms = read_ms, .upload_ms = upload_ms};
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <rgba.rttx> <bc.rttx> [iterations=10]\n";
+        return 1;
+    }
+
+    uint32_t iterations = argc > 3 ? static_cast<uint32_t>(std::stoul(argv[3])) : 10;
+
+    try {
+        auto cluster = bench::create_headless_cluster();
+        bench::print_device(*cluster);
+
+        {
+            rt::TextureFile rgba(argv[1]);
+            rt::TextureFile bc(argv[2]);
+            if (rgba.get_width() != bc.get_width() || rgba.get_height() != bc.get_height()) {
+                std::cerr << "the two files should be the same texture, sizes differ\n";
+                return 1;
+            }
+            if (rt::Utils::get_format_block_size(bc.get_format()) == 0) {
+                std::cerr << argv[2] << " isn't block compressed\n";
+                return 1;
+            }
+        }
+
+        VkDeviceSize rgba_size = 0;
+        VkDeviceSize bc_size = 0;
+        std::vector<bench::Load> loads = {
+            {.name = "rgba", .path = argv[1], .function = [&](const char* path, const bench::LoadContext& ctx) {
+                return load(path, ctx, &rgba_size);
+            }},
+            {.name = "bc", .path = argv[2], .function = [&](const char* path, const bench::LoadContext& ctx) {
+                return load(path, ctx, &bc_size);
+            }}
+        };
+        bench::run_loads(*cluster, loads, iterations);
+
+        bench::print_load(loads[0], iterations);
+        bench::print_load(loads[1], iterations);
+        std::cout << "device memory: rgba " << rgba_size << " bytes, bc " << bc_size << " bytes\n";
+        std::cout << "bc is " << static_cast<double>(rgba_size) / bc_size << "x smaller on device, "
+                  << bench::get_total_ms(loads[0]) / bench::get_total_ms(loads[1]) << "x faster to load\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
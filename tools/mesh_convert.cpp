@@ -0,0 +1,112 @@
+// converts Wavefront OBJ files into render_thing mesh files
+//   usage: mesh_convert <input.obj> <output.rtm>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "etc/mesh_file.h"
+#include "etc/mesh_optimizer.h"
+#include "etc/mesh_simplifier.h"
+#include "obj_reader.h"
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <input.obj> <output.rtm>\n";
+        return 1;
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    // ~~~ read and deduplicate ~~~
+
+    try {
+        read_obj(argv[1], vertices, indices);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    // ~~~ optimize ~~~
+
+    rt::MeshCreateInfo source = {
+        .vertices = vertices.data(),
+        .vertex_size = sizeof(Vertex),
+        .num_vertices = static_cast<uint32_t>(vertices.size()),
+        .indices = indices.data(),
+        .index_size = 4,
+        .num_indices = static_cast<uint32_t>(indices.size())
+    };
+
+    rt::MeshOptimizerSettings settings = {
+        .cache_size = 0,
+        .optimize_vertex_fetch = true,
+        .optimize_overdraw = true,
+        .position_offset = offsetof(Vertex, position),
+        .overdraw_threshold = 0.0f,
+        .downcast_indices = true
+    };
+
+    rt::MeshLodSettings lod_settings = {
+        .position_offset = offsetof(Vertex, position),
+        .max_lod_count = 0,
+        .reduction = 0.0f,
+        .max_error = 0.05f
+    };
+
+    // levels are simplified from the optimized mesh so they inherit
+    //   its triangle order and index its fetch ordered vertices
+    rt::OptimizedMesh mesh;
+    rt::MeshLodChain chain;
+    try {
+        mesh = rt::MeshOptimizer::Optimize(source, settings);
+        chain = rt::MeshSimplifier::GenerateLods(mesh.get_mesh_create_info(source), lod_settings);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::vector<rt::MeshFileLod> lods;
+    for (const auto& lod : chain.lods) {
+        lods.push_back({.first_index = lod.first_index, .index_count = lod.index_count, .error = lod.error, .reserved = 0});
+    }
+
+    // ~~~ write ~~~
+
+    rt::MeshFileAttribute attributes[] = {
+        {.location = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, position), .reserved = 0},
+        {.location = 1, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(Vertex, normal), .reserved = 0},
+        {.location = 2, .format = VK_FORMAT_R32G32_SFLOAT, .offset = offsetof(Vertex, uv), .reserved = 0}
+    };
+
+    rt::MeshFileWriteInfo write_info = {
+        .vertices = mesh.vertices.data(),
+        .vertex_size = mesh.vertex_size,
+        .num_vertices = mesh.num_vertices,
+        .indices = chain.indices.data(),
+        .index_size = chain.index_size,
+        .num_indices = chain.num_indices,
+        .attributes = attributes,
+        .attribute_count = 3,
+        .lods = lods.data(),
+        .lod_count = static_cast<uint32_t>(lods.size())
+    };
+
+    try {
+        rt::MeshFile::Write(argv[2], write_info);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << argv[2] << ": " << mesh.num_vertices << " vertices, " << mesh.num_indices << " indices\n";
+    std::cout << "  ACMR " << mesh.before.acmr << " -> " << mesh.after.acmr
+              << ", ATVR " << mesh.before.atvr << " -> " << mesh.after.atvr << "\n";
+    for (size_t i = 0; i < lods.size(); i++) {
+        std::cout << "  lod " << i << ": " << lods[i].index_count / 3 << " triangles, error " << lods[i].error << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+// the Wavefront OBJ reader shared by mesh_convert and bench_mesh_load,
+//   only positions, normals, uvs and faces are read
+
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+
+// position, normal, uv, 32 bytes so vertices stay nicely aligned
+struct Vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+// an OBJ face corner, indices are 0 when missing
+struct Corner {
+    int32_t position;
+    int32_t uv;
+    int32_t normal;
+
+    bool operator==(const Corner& other) const {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
+
+struct CornerHash {
+    size_t operator()(const Corner& corner) const {
+        size_t hash = std::hash<int32_t>()(corner.position);
+        hash = hash * 31 + std::hash<int32_t>()(corner.uv);
+        hash = hash * 31 + std::hash<int32_t>()(corner.normal);
+        return hash;
+    }
+};
+
+// OBJ indices are 1 based and negative ones count back from the end
+inline int32_t resolve_index(int32_t index, size_t count) {
+    if (index < 0) {
+        return static_cast<int32_t>(count) + index + 1;
+    }
+    return index;
+}
+
+inline Corner parse_corner(const std::string& token, size_t position_count, size_t uv_count, size_t normal_count) {
+    Corner corner = {0, 0, 0};
+    int32_t* fields[] = {&corner.position, &corner.uv, &corner.normal};
+
+    // v, v/vt, v//vn or v/vt/vn
+    size_t field = 0;
+    size_t start = 0;
+    while (field < 3 && start <= token.size()) {
+        size_t end = token.find('/', start);
+        if (end == std::string::npos) {
+            end = token.size();
+        }
+
+        if (end > start) {
+            *fields[field] = std::stoi(token.substr(start, end - start));
+        }
+
+        field++;
+        start = end + 1;
+    }
+
+    corner.position = resolve_index(corner.position, position_count);
+    corner.uv = resolve_index(corner.uv, uv_count);
+    corner.normal = resolve_index(corner.normal, normal_count);
+
+    return corner;
+}
+
+// reads and deduplicates face corners, polygons are triangulated as
+//   fans. throws if the file can't be read or has no triangles
+inline void read_obj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    std::ifstream input(path);
+    if (!input.is_open()) {
+        throw std::runtime_error("failed to open " + path);
+    }
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> uvs;
+    std::unordered_map<Corner, uint32_t, CornerHash> corner_indices;
+
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+
+        if (type == "v") {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            positions.insert(positions.end(), {x, y, z});
+        } else if (type == "vn") {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            normals.insert(normals.end(), {x, y, z});
+        } else if (type == "vt") {
+            float u = 0.0f, v = 0.0f;
+            stream >> u >> v;
+            // OBJ has v pointing up, Vulkan samples with it pointing down
+            uvs.insert(uvs.end(), {u, 1.0f - v});
+        } else if (type == "f") {
+            std::vector<uint32_t> face;
+            std::string token;
+            while (stream >> token) {
+                Corner corner = parse_corner(token, positions.size() / 3, uvs.size() / 2, normals.size() / 3);
+
+                auto found = corner_indices.find(corner);
+                if (found != corner_indices.end()) {
+                    face.push_back(found->second);
+                    continue;
+                }
+
+                Vertex vertex = {};
+                if (corner.position <= 0 || static_cast<size_t>(corner.position) * 3 > positions.size()) {
+                    throw std::runtime_error("face references a missing position: " + line);
+                }
+                std::memcpy(vertex.position, &positions[(corner.position - 1) * 3], sizeof(vertex.position));
+
+                if (corner.normal > 0 && static_cast<size_t>(corner.normal) * 3 <= normals.size()) {
+                    std::memcpy(vertex.normal, &normals[(corner.normal - 1) * 3], sizeof(vertex.normal));
+                }
+
+                if (corner.uv > 0 && static_cast<size_t>(corner.uv) * 2 <= uvs.size()) {
+                    std::memcpy(vertex.uv, &uvs[(corner.uv - 1) * 2], sizeof(vertex.uv));
+                }
+
+                uint32_t index = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+                corner_indices[corner] = index;
+                face.push_back(index);
+            }
+
+            // triangulate polygons as a fan
+            for (size_t i = 2; i < face.size(); i++) {
+                indices.insert(indices.end(), {face[0], face[i - 1], face[i]});
+            }
+        }
+    }
+
+    if (vertices.empty() || indices.empty()) {
+        throw std::runtime_error("no triangles found in " + path);
+    }
+}
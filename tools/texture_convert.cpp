@@ -0,0 +1,216 @@
+// converts raw 8 bit RGBA pixels into render_thing texture files with a
+//   full mip chain, either left uncompressed or encoded as BC1
+//   usage: texture_convert <input.rgba> <width> <height> <rgba|bc1> <output.rttx>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "etc/texture_file.h"
+#include "vk_utils.h"
+
+using Pixels = std::vector<uint8_t>;
+
+// 2x2 box filter, odd edges fold their last column / row in twice.
+//   filtering happens on the sRGB values directly, which darkens
+//   slightly but is what most tools do
+static Pixels downsample(const Pixels& src, uint32_t width, uint32_t height) {
+    uint32_t next_width = std::max(width / 2, 1u);
+    uint32_t next_height = std::max(height / 2, 1u);
+    Pixels dst(static_cast<size_t>(next_width) * next_height * 4);
+
+    for (uint32_t y = 0; y < next_height; y++) {
+        for (uint32_t x = 0; x < next_width; x++) {
+            uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+
+            for (uint32_t c = 0; c < 4; c++) {
+                uint32_t sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c] +
+                               src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+                dst[(y * next_width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+
+    return dst;
+}
+
+// ~~~ BC1 ~~~
+
+static uint16_t pack_565(const int color[3]) {
+    return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void unpack_565(uint16_t packed, int color[3]) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// bounding box endpoints inset by 1/16th of the range, which is cheap
+//   and close enough to a least squares fit for most textures
+static void encode_bc1_block(const uint8_t texels[16][4], uint8_t out[8]) {
+    int min[3] = {255, 255, 255};
+    int max[3] = {0, 0, 0};
+    for (uint32_t i = 0; i < 16; i++) {
+        for (uint32_t c = 0; c < 3; c++) {
+            min[c] = std::min(min[c], static_cast<int>(texels[i][c]));
+            max[c] = std::max(max[c], static_cast<int>(texels[i][c]));
+        }
+    }
+
+    for (uint32_t c = 0; c < 3; c++) {
+        int inset = (max[c] - min[c]) / 16;
+        min[c] = std::min(min[c] + inset, 255);
+        max[c] = std::max(max[c] - inset, 0);
+    }
+
+    uint16_t color0 = pack_565(max);
+    uint16_t color1 = pack_565(min);
+    // color0 > color1 selects 4 color mode, equal endpoints just use index 0
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    int palette[4][3];
+    unpack_565(color0, palette[0]);
+    unpack_565(color1, palette[1]);
+    for (uint32_t c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t best = 0;
+            int best_distance = INT32_MAX;
+            for (uint32_t p = 0; p < 4; p++) {
+                int distance = 0;
+                for (uint32_t c = 0; c < 3; c++) {
+                    int delta = texels[i][c] - palette[p][c];
+                    distance += delta * delta;
+                }
+
+                if (distance < best_distance) {
+                    best = p;
+                    best_distance = distance;
+                }
+            }
+
+            indices |= best << (i * 2);
+        }
+    }
+
+    out[0] = static_cast<uint8_t>(color0);
+    out[1] = static_cast<uint8_t>(color0 >> 8);
+    out[2] = static_cast<uint8_t>(color1);
+    out[3] = static_cast<uint8_t>(color1 >> 8);
+    for (uint32_t i = 0; i < 4; i++) {
+        out[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+static Pixels encode_bc1(const Pixels& src, uint32_t width, uint32_t height) {
+    uint32_t blocks_x = (width + 3) / 4;
+    uint32_t blocks_y = (height + 3) / 4;
+    Pixels dst(static_cast<size_t>(blocks_x) * blocks_y * 8);
+
+    for (uint32_t by = 0; by < blocks_y; by++) {
+        for (uint32_t bx = 0; bx < blocks_x; bx++) {
+            // blocks hanging off the edge repeat the last texel
+            uint8_t texels[16][4];
+            for (uint32_t i = 0; i < 16; i++) {
+                uint32_t x = std::min(bx * 4 + i % 4, width - 1);
+                uint32_t y = std::min(by * 4 + i / 4, height - 1);
+                std::copy_n(&src[(static_cast<size_t>(y) * width + x) * 4], 4, texels[i]);
+            }
+
+            encode_bc1_block(texels, &dst[(static_cast<size_t>(by) * blocks_x + bx) * 8]);
+        }
+    }
+
+    return dst;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 6) {
+        std::cerr << "usage: " << argv[0] << " <input.rgba> <width> <height> <rgba|bc1> <output.rttx>\n";
+        return 1;
+    }
+
+    uint32_t width = static_cast<uint32_t>(std::stoul(argv[2]));
+    uint32_t height = static_cast<uint32_t>(std::stoul(argv[3]));
+    std::string mode = argv[4];
+
+    VkFormat format;
+    if (mode == "rgba") {
+        format = VK_FORMAT_R8G8B8A8_SRGB;
+    } else if (mode == "bc1") {
+        format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+    } else {
+        std::cerr << "unknown format " << mode << ", expected rgba or bc1\n";
+        return 1;
+    }
+
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input.is_open()) {
+        std::cerr << "failed to open " << argv[1] << "\n";
+        return 1;
+    }
+
+    Pixels pixels(static_cast<size_t>(width) * height * 4);
+    input.read(reinterpret_cast<char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    if (width == 0 || height == 0 || !input) {
+        std::cerr << argv[1] << " is smaller than " << width << "x" << height << " RGBA pixels\n";
+        return 1;
+    }
+
+    // ~~~ build and encode the chain ~~~
+
+    uint32_t level_count = rt::Utils::get_full_mip_count(width, height);
+    std::vector<Pixels> encoded(level_count);
+
+    uint32_t level_width = width;
+    uint32_t level_height = height;
+    for (uint32_t level = 0; level < level_count; level++) {
+        encoded[level] = format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ? encode_bc1(pixels, level_width, level_height) : pixels;
+
+        if (level + 1 < level_count) {
+            pixels = downsample(pixels, level_width, level_height);
+            level_width = std::max(level_width / 2, 1u);
+            level_height = std::max(level_height / 2, 1u);
+        }
+    }
+
+    std::vector<rt::ImageLevelData> levels(level_count);
+    size_t total_size = 0;
+    for (uint32_t level = 0; level < level_count; level++) {
+        levels[level] = {.data = encoded[level].data(), .size = encoded[level].size()};
+        total_size += encoded[level].size();
+    }
+
+    // ~~~ write ~~~
+
+    rt::TextureFileWriteInfo write_info = {
+        .format = format,
+        .width = width,
+        .height = height,
+        .levels = levels.data(),
+        .level_count = level_count
+    };
+
+    try {
+        rt::TextureFile::Write(argv[5], write_info);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << argv[5] << ": " << width << "x" << height << ", " << level_count << " levels, " << total_size << " bytes\n";
+
+    return 0;
+}